@@ -8,7 +8,7 @@ TF:=$(MP_TOP)/tests/fail
 SRC_FILES:=\
 	  $(S)/list.c $(S)/tree.c $(S)/slots.c $(S)/utils.c $(S)/memory.c $(S)/heap.c $(S)/alloc.c $(S)/info.c \
 	  $(S)/stack.c $(S)/addr.c $(S)/strtab.c $(S)/symbol.c $(S)/signals.c $(S)/diag.c $(S)/option.c \
-	  $(S)/leaktab.c $(S)/profile.c $(S)/trace.c $(S)/inter.c $(S)/malloc.c $(S)/cplus.c $(S)/version.c \
+	  $(S)/leaktab.c $(S)/profile.c $(S)/trace.c $(S)/stats.c $(S)/inter.c $(S)/malloc.c $(S)/cplus.c $(S)/version.c \
 	  $(T)/dbmalloc.c $(T)/dmalloc.c $(T)/heapdiff.c $(T)/mgauge.c $(T)/mtrace.c \
 	  $(S)/mutex.c
 
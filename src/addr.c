@@ -94,27 +94,7 @@ static
 addrnode *
 getaddrnode(addrhead *h)
 {
-    addrnode *n;
-    heapnode *p;
-
-    /* If we have no more address node slots left then we must allocate
-     * some more memory for them.  An extra MP_ALLOCFACTOR pages of memory
-     * should suffice.
-     */
-    if ((n = (addrnode *) __mp_getslot(&h->table)) == NULL)
-    {
-        if ((p = __mp_heapalloc(h->heap, h->heap->memory.page * MP_ALLOCFACTOR,
-              h->table.entalign, 1)) == NULL)
-            return NULL;
-        __mp_initslots(&h->table, p->block, p->size);
-        n = (addrnode *) __mp_getslot(&h->table);
-        __mp_addtail(&h->list, &n->index.node);
-        n->index.block = p->block;
-        n->index.size = p->size;
-        h->size += p->size;
-        n = (addrnode *) __mp_getslot(&h->table);
-    }
-    return n;
+    return (addrnode *) __mp_heapslot(h->heap, &h->table, &h->list, &h->size);
 }
 
 
@@ -54,6 +54,7 @@ __mp_newallocs(allochead *h, size_t m, size_t s, unsigned char o,
                unsigned char a, unsigned char f, unsigned long u)
 {
     struct { char x; allocnode y; } z;
+    size_t i;
     long n;
 
     __mp_newheap(&h->heap);
@@ -69,8 +70,18 @@ __mp_newallocs(allochead *h, size_t m, size_t s, unsigned char o,
     __mp_newtree(&h->atree);
     __mp_newtree(&h->gtree);
     __mp_newtree(&h->ftree);
+    for (i = 0; i < MP_FREECACHE_BINS; i++)
+        __mp_newlist(&h->cache[i]);
+    h->ccount = 0;
     h->isize = h->asize = h->gsize = h->fsize = 0;
     h->fmax = m;
+    h->gmax = 0;
+    h->tmax = h->tfree = h->tsize = 0;
+    h->pool = NULL;
+    h->pslots = MP_GUARDPOOL_SIZE;
+    h->pused = h->pnext = 0;
+    h->sfreq = h->snext = 0;
+    h->sseed = 1;
     h->oflow = __mp_poweroftwo(s);
     h->obyte = o;
     h->abyte = a;
@@ -94,6 +105,8 @@ MP_GLOBAL
 void
 __mp_deleteallocs(allochead *h)
 {
+    size_t i;
+
     /* We don't need to explicitly free any memory as this is dealt with
      * at a lower level by the heap manager.
      */
@@ -106,12 +119,38 @@ __mp_deleteallocs(allochead *h)
     __mp_newtree(&h->atree);
     __mp_newtree(&h->gtree);
     __mp_newtree(&h->ftree);
+    for (i = 0; i < MP_FREECACHE_BINS; i++)
+        __mp_newlist(&h->cache[i]);
+    h->ccount = 0;
     h->isize = h->asize = h->gsize = h->fsize = 0;
+    h->tfree = 0;
+    h->pool = NULL;
+    h->pused = h->pnext = 0;
     h->prot = MA_NOACCESS;
     h->protrecur = 0;
 }
 
 
+/* Enlarge the slots in the table of allocation nodes so that each of them
+ * can hold either an allocation node or an object of the specified size and
+ * alignment.  This allows the information associated with each memory
+ * allocation to be placed in the same pages as the allocation nodes, and
+ * usually right next to the allocation node for the memory allocation.  This
+ * must be called before any allocation nodes have been allocated.
+ */
+
+MP_GLOBAL
+void
+__mp_shareslots(allochead *h, size_t l, size_t a)
+{
+    if (l < h->table.entsize)
+        l = h->table.entsize;
+    if (a < h->table.entalign)
+        a = h->table.entalign;
+    __mp_newslots(&h->table, l, a);
+}
+
+
 /* Allocate a new allocation node.
  */
 
@@ -123,13 +162,13 @@ getnode(allochead *h)
     heapnode *p;
 
     /* If we have no more allocation node slots left then we must allocate
-     * some more memory for them.  An extra MP_ALLOCFACTOR pages of memory
-     * should suffice.
+     * some more memory for them.  The amount of memory allocated grows
+     * with the size of the slot table.
      */
     if ((n = (allocnode *) __mp_getslot(&h->table)) == NULL)
     {
-        if ((p = __mp_heapalloc(&h->heap, h->heap.memory.page * MP_ALLOCFACTOR,
-              h->table.entalign, 1)) == NULL)
+        if ((p = __mp_heapalloc(&h->heap, __mp_growslots(&h->table,
+              h->heap.memory.page), h->table.entalign, 1)) == NULL)
             return NULL;
         __mp_initslots(&h->table, p->block, p->size);
         n = (allocnode *) __mp_getslot(&h->table);
@@ -145,6 +184,217 @@ getnode(allochead *h)
 }
 
 
+/* Allocate a number of new allocation nodes at once, or none of them if there
+ * is not enough memory for all of them.
+ */
+
+static
+int
+getnodes(allochead *h, allocnode **v, size_t n)
+{
+    size_t i;
+
+    for (i = __mp_getslots(&h->table, (void **) v, n); i < n; i++)
+        if ((v[i] = getnode(h)) == NULL)
+        {
+            __mp_freeslots(&h->table, (void **) v, i);
+            return 0;
+        }
+    return 1;
+}
+
+
+/* Allocate a new slot from the table of allocation nodes, which can be used
+ * for either an allocation node or for the information associated with a
+ * memory allocation.  It can be freed with __mp_freeslot().
+ */
+
+MP_GLOBAL
+void *
+__mp_getslotnode(allochead *h)
+{
+    return (void *) getnode(h);
+}
+
+
+/* Determine which bin of the free node cache a free node of a specified size
+ * belongs to.
+ */
+
+#define cachebin(h, l) ((l) / (h)->heap.memory.align)
+
+
+/* Add a free node to the free node cache rather than to the free tree.  Its
+ * tree node key is set to zero to indicate that it is in the cache, since no
+ * node on the free tree can have a size of zero.  If the cache is now full
+ * then all of its nodes are merged into the free tree.
+ */
+
+static
+void
+cachenode(allochead *h, allocnode *n)
+{
+    __mp_addhead(&h->cache[cachebin(h, n->size)], &n->fnode);
+    n->tnode.key = 0;
+    if (++h->ccount > MP_FREECACHE_SIZE)
+        __mp_mergefree(h);
+}
+
+
+/* Remove a free node from the free node cache.
+ */
+
+static
+void
+uncachenode(allochead *h, allocnode *n)
+{
+    __mp_remove(&h->cache[cachebin(h, n->size)], &n->fnode);
+    h->ccount--;
+}
+
+
+/* Attempt to merge a free node on the free tree with any bordering free
+ * nodes, including any that are in the free node cache.  Since the nodes in
+ * the cache are not merged with their neighbours there may be a run of several
+ * bordering free nodes on either side of the node.
+ */
+
+static
+allocnode *
+mergenode(allochead *h, allocnode *n)
+{
+    allocnode *l, *r;
+    int m;
+
+    m = 0;
+    do
+    {
+        /* See if the left node is free and borders on this node.
+         */
+        l = (allocnode *) n->lnode.prev;
+        if ((l->lnode.prev == NULL) || (l->info != NULL) ||
+            ((char *) l->block + l->size < (char *) n->block))
+            l = NULL;
+        /* See if the right node is free and borders on this node.
+         */
+        r = (allocnode *) n->lnode.next;
+        if ((r->lnode.next == NULL) || (r->info != NULL) ||
+            ((char *) n->block + n->size < (char *) r->block))
+            r = NULL;
+        /* If either or both of the left or right node is suitable for
+         * merging then perform the merge.
+         */
+        if ((l != NULL) || (r != NULL))
+        {
+            if (!m)
+            {
+                __mp_treeremove(&h->ftree, &n->tnode);
+                m = 1;
+            }
+            if (l != NULL)
+            {
+                __mp_remove(&h->list, &l->lnode);
+                if (l->tnode.key == 0)
+                    uncachenode(h, l);
+                else
+                    __mp_treeremove(&h->ftree, &l->tnode);
+                n->block = l->block;
+                n->size += l->size;
+                __mp_freeslot(&h->table, l);
+            }
+            if (r != NULL)
+            {
+                __mp_remove(&h->list, &r->lnode);
+                if (r->tnode.key == 0)
+                    uncachenode(h, r);
+                else
+                    __mp_treeremove(&h->ftree, &r->tnode);
+                n->size += r->size;
+                __mp_freeslot(&h->table, r);
+            }
+        }
+    }
+    while ((l != NULL) || (r != NULL));
+    if (m)
+        __mp_treeinsert(&h->ftree, &n->tnode, n->size);
+    return n;
+}
+
+
+/* Place a free node from the free node cache on the free tree and merge it
+ * with any bordering free nodes.
+ */
+
+static
+allocnode *
+releasenode(allochead *h, allocnode *n)
+{
+    uncachenode(h, n);
+    __mp_treeinsert(&h->ftree, &n->tnode, n->size);
+    return mergenode(h, n);
+}
+
+
+/* Search the free node cache for a free node that can hold an allocation of
+ * a specified size and alignment, including any padding that is needed to
+ * align its start address.  Only the most recently freed node in each of the
+ * two bins that could contain such a node is examined.
+ */
+
+static
+allocnode *
+findcached(allochead *h, size_t l, size_t a)
+{
+    allocnode *n;
+    unsigned long b;
+    size_t i, j;
+
+    if (h->ccount == 0)
+        return NULL;
+    for (i = cachebin(h, l), j = i + 2; (i < j) && (i < MP_FREECACHE_BINS); i++)
+        if (h->cache[i].size > 0)
+        {
+            n = (allocnode *) ((char *) h->cache[i].head -
+                               offsetof(allocnode, fnode));
+            b = (unsigned long) n->block + h->oflow;
+            if (n->size >= l + __mp_roundup(b, a) - b)
+                return n;
+        }
+    return NULL;
+}
+
+
+/* Refill the partial pages at either end of a free node with the free byte
+ * if they read back as zero bytes.  This can only happen once the heap has
+ * been trimmed, when a free node that was split or shrunk started or ended
+ * part of the way through a page that __mp_trimalloc() returned to the system
+ * and which has since been brought back into physical memory by a bordering
+ * allocation.
+ */
+
+static
+void
+refillnode(allochead *h, allocnode *n)
+{
+    char *b, *e, *p, *q;
+
+    if ((h->tsize == 0) || (h->flags & FLG_PAGEALLOC) || (h->fbyte == 0))
+        return;
+    b = (char *) n->block;
+    e = b + n->size;
+    if ((p = (char *) __mp_roundup((unsigned long) b,
+                                   h->heap.memory.page)) > e)
+        p = e;
+    if ((q = (char *) __mp_rounddown((unsigned long) e,
+                                     h->heap.memory.page)) < p)
+        q = p;
+    if ((p > b) && (__mp_memcheck(b, 0, p - b) == NULL))
+        __mp_memset(b, h->fbyte, p - b);
+    if ((e > q) && (__mp_memcheck(q, 0, e - q) == NULL))
+        __mp_memset(q, h->fbyte, e - q);
+}
+
+
 /* Split a free node into an allocated node of a certain size and alignment
  * and up to two new free nodes.
  */
@@ -153,23 +403,30 @@ static
 allocnode *
 splitnode(allochead *h, allocnode *n, size_t l, size_t a, void *i)
 {
+    allocnode *v[2];
     allocnode *p, *q;
-    size_t m, s;
+    size_t k, m, s;
+    int c;
 
     /* We choose the worst case scenario here and allocate new nodes for
      * both the left and right nodes.  This is so that we can easily recover
      * from lack of system memory at this point rather than rebuild the
      * original free node if we discover that we are out of memory later.
+     * Any nodes that turn out not to be needed are freed together.
      */
-    if (((p = getnode(h)) == NULL) || ((q = getnode(h)) == NULL))
-    {
-        if (p != NULL)
-            __mp_freeslot(&h->table, p);
+    if (!getnodes(h, v, 2))
         return NULL;
-    }
-    /* Remove the free node from the free tree.
+    p = v[0];
+    q = v[1];
+    k = 0;
+    /* Remove the free node from the free tree, or from the free node cache if
+     * it has not yet been placed on the free tree.
      */
-    __mp_treeremove(&h->ftree, &n->tnode);
+    c = (n->tnode.key == 0);
+    if (c)
+        uncachenode(h, n);
+    else
+        __mp_treeremove(&h->ftree, &n->tnode);
     h->fsize -= n->size;
     n->block = (char *) n->block + h->oflow;
     n->size -= h->oflow << 1;
@@ -188,9 +445,10 @@ splitnode(allochead *h, allocnode *n, size_t l, size_t a, void *i)
         n->block = (char *) n->block + m;
         n->size -= m;
         h->fsize += m;
+        refillnode(h, p);
     }
     else
-        __mp_freeslot(&h->table, p);
+        v[k++] = p;
     /* If we are allocating pages then the effective block size is the
      * original size rounded up to a multiple of the system page size.
      */
@@ -211,9 +469,16 @@ splitnode(allochead *h, allocnode *n, size_t l, size_t a, void *i)
         q->info = NULL;
         n->size = s;
         h->fsize += m;
+        refillnode(h, q);
     }
     else
-        __mp_freeslot(&h->table, q);
+        v[k++] = q;
+    __mp_freeslots(&h->table, (void **) v, k);
+    /* Keep track of the lowest total size of free memory since the heap was
+     * last trimmed so that we know how much of it has since been freed.
+     */
+    if (h->fsize < h->tfree)
+        h->tfree = h->fsize;
     /* Initialise the details of the newly allocated node and insert it in
      * the allocation tree.
      */
@@ -264,58 +529,166 @@ splitnode(allochead *h, allocnode *n, size_t l, size_t a, void *i)
     }
     __mp_treeinsert(&h->atree, &n->tnode, (unsigned long) n->block);
     h->asize += n->size;
+    /* A node from the free node cache may border other free nodes, so any
+     * free nodes that were split from it must be merged with them in order to
+     * maintain the property that the memory block list does not ever contain
+     * two bordering free nodes outside of the cache.
+     */
+    if (c)
+    {
+        if (n->lnode.prev == &p->lnode)
+            mergenode(h, p);
+        if (n->lnode.next == &q->lnode)
+            mergenode(h, q);
+    }
     return n;
 }
 
 
-/* Attempt to merge a free node with any bordering free nodes.
+/* Return the number of allocations to make before the next allocation is
+ * sampled from the guard page pool.  The intervals are spread uniformly
+ * around the sampling frequency so that they do not coincide with any
+ * regular pattern of allocations in the program.
+ */
+
+static
+unsigned long
+nextsample(allochead *h)
+{
+    if (h->sfreq <= 1)
+        return 1;
+    h->sseed = h->sseed * 1103515245UL + 12345UL;
+    return ((h->sseed >> 16) % (h->sfreq << 1)) + 1;
+}
+
+
+/* Determine if a slot in the guard page pool is occupied by an allocated
+ * or freed node.
+ */
+
+static
+int
+slotused(allochead *h, char *b)
+{
+    allocnode *n;
+    treenode *t;
+    unsigned long k;
+
+    k = (unsigned long) b + h->heap.memory.page - 1;
+    if ((t = __mp_searchlower(h->atree.root, k)) != NULL)
+    {
+        n = (allocnode *) ((char *) t - offsetof(allocnode, tnode));
+        if ((char *) n->block >= b)
+            return 1;
+    }
+    if ((t = __mp_searchlower(h->gtree.root, k)) != NULL)
+    {
+        n = (allocnode *) ((char *) t - offsetof(allocnode, tnode));
+        if ((char *) n->block >= b)
+            return 1;
+    }
+    return 0;
+}
+
+
+/* Allocate a new allocation node of a specified size and alignment from the
+ * guard page pool.  Each slot in the pool consists of a page for the memory
+ * allocation followed by an inaccessible page, and the memory allocation is
+ * placed at the highest point within its page so that any overflow will
+ * immediately cause an illegal memory access.
  */
 
 static
 allocnode *
-mergenode(allochead *h, allocnode *n)
+getguarded(allochead *h, size_t l, size_t a, void *i)
 {
-    allocnode *l, *r;
+    allocnode *n, *r, *s;
+    heapnode *p;
+    treenode *t;
+    char *b;
+    size_t k, m;
 
-    /* See if the left node is free and borders on this node.
-     */
-    l = (allocnode *) n->lnode.prev;
-    if ((l->lnode.prev == NULL) || (l->info != NULL) ||
-        ((char *) l->block + l->size < (char *) n->block))
-        l = NULL;
-    /* See if the right node is free and borders on this node.
-     */
-    r = (allocnode *) n->lnode.next;
-    if ((r->lnode.next == NULL) || (r->info != NULL) ||
-        ((char *) n->block + n->size < (char *) r->block))
-        r = NULL;
-    /* If either or both of the left or right node is suitable for
-     * merging then perform the merge.
-     */
-    if ((l != NULL) || (r != NULL))
+    if ((h->flags & (FLG_PAGEALLOC | FLG_OFLOWWATCH)) ||
+        (l > h->heap.memory.page) || (h->pslots == 0))
+        return NULL;
+    if (h->pool == NULL)
     {
-        __mp_treeremove(&h->ftree, &n->tnode);
-        if (l != NULL)
-        {
-            __mp_remove(&h->list, &l->lnode);
-            __mp_treeremove(&h->ftree, &l->tnode);
-            n->block = l->block;
-            n->size += l->size;
-            __mp_freeslot(&h->table, l);
-        }
-        if (r != NULL)
+        /* The pool is created the first time it is needed and all of it is
+         * made inaccessible at once.
+         */
+        if ((p = __mp_heapalloc(&h->heap, (h->pslots * h->heap.memory.page) <<
+              1, h->heap.memory.page, 0)) == NULL)
         {
-            __mp_remove(&h->list, &r->lnode);
-            __mp_treeremove(&h->ftree, &r->tnode);
-            n->size += r->size;
-            __mp_freeslot(&h->table, r);
+            h->pslots = 0;
+            return NULL;
         }
-        __mp_treeinsert(&h->ftree, &n->tnode, n->size);
+        __mp_memprotect(&h->heap.memory, p->block, p->size, MA_NOACCESS);
+        h->pool = (char *) p->block;
+        h->pslots = p->size / (h->heap.memory.page << 1);
+        h->pused = h->pnext = 0;
+    }
+    if (h->pused == h->pslots)
+        return NULL;
+    /* Slots are used in a round-robin fashion so that a slot that has just
+     * been freed is not reused for as long as possible.
+     */
+    for (k = h->pnext; ; k = (k + 1) % h->pslots)
+    {
+        b = h->pool + ((k * h->heap.memory.page) << 1);
+        if (!slotused(h, b))
+            break;
     }
+    if ((n = getnode(h)) == NULL)
+        return NULL;
+    if (!__mp_memprotect(&h->heap.memory, b, h->heap.memory.page,
+                         MA_READWRITE))
+    {
+        __mp_freeslot(&h->table, n);
+        return NULL;
+    }
+    /* Fill any unused space on either side of the allocation within the page
+     * with the overflow byte.
+     */
+    m = __mp_rounddown(h->heap.memory.page - l, a);
+    __mp_memset(b, h->obyte, m);
+    __mp_memset(b + m + l, h->obyte, h->heap.memory.page - m - l);
+    /* Insert the new node into the correct position in the memory block
+     * list.
+     */
+    if ((t = __mp_searchlower(h->atree.root, (unsigned long) b)) ||
+        (t = __mp_searchlower(h->gtree.root, (unsigned long) b)))
+        r = (allocnode *) ((char *) t - offsetof(allocnode, tnode));
+    else
+        r = (allocnode *) &h->list;
+    while (((s = (allocnode *) r->lnode.next)->lnode.next != NULL) &&
+           ((char *) s->block < b))
+        r = s;
+    __mp_insert(&h->list, &r->lnode, &n->lnode);
+    n->block = b + m;
+    n->size = l;
+    n->info = i;
+    __mp_treeinsert(&h->atree, &n->tnode, (unsigned long) n->block);
+    h->asize += l;
+    h->pused++;
+    h->pnext = (k + 1) % h->pslots;
     return n;
 }
 
 
+/* Return a slot in the guard page pool that was occupied by an allocation
+ * node.  The page should already have been made inaccessible.
+ */
+
+static
+void
+freeguarded(allochead *h, allocnode *n)
+{
+    __mp_remove(&h->list, &n->lnode);
+    __mp_freeslot(&h->table, n);
+    h->pused--;
+}
+
+
 /* Create a new allocation node of a specified size and alignment.
  */
 
@@ -326,7 +699,7 @@ __mp_getalloc(allochead *h, size_t l, size_t a, void *i)
     allocnode *n, *r, *s;
     heapnode *p;
     treenode *t;
-    size_t b, m;
+    size_t b, k, m;
 
     b = h->oflow << 1;
     if (l == 0)
@@ -337,6 +710,22 @@ __mp_getalloc(allochead *h, size_t l, size_t a, void *i)
         a = h->heap.memory.page;
     else
         a = __mp_poweroftwo(a);
+    /* If we are sampling allocations then an occasional allocation is made
+     * from the guard page pool instead of the heap.
+     */
+    if ((h->sfreq != 0) && (h->snext-- <= 1))
+    {
+        h->snext = nextsample(h);
+        if ((n = getguarded(h, l, a, i)) != NULL)
+            return n;
+    }
+#if MP_MREMAP_SUPPORT
+    /* Large allocations are aligned to the system page size so that their
+     * pages can be moved rather than copied if they are ever relocated.
+     */
+    if (l >= MP_MREMAP_SIZE)
+        a = h->heap.memory.page;
+#endif /* MP_MREMAP_SUPPORT */
     /* If all allocations are not pages then we must add more bytes to the
      * allocation request to account for alignment.
      */
@@ -344,22 +733,40 @@ __mp_getalloc(allochead *h, size_t l, size_t a, void *i)
         m = 0;
     else
         m = a - 1;
+    /* A recently freed node of a suitable size in the free node cache can be
+     * reused without searching the free tree.  If there is no suitable free
+     * node on the free tree either then any nodes in the cache are merged into
+     * it and the search is repeated.
+     */
+    if ((n = findcached(h, l + b, a)) != NULL)
+        return splitnode(h, n, l, a, i);
+    if (((t = __mp_searchhigher(h->ftree.root, l + b + m)) == NULL) &&
+        (h->ccount > 0))
+    {
+        __mp_mergefree(h);
+        t = __mp_searchhigher(h->ftree.root, l + b + m);
+    }
     /* If we have no suitable space for this allocation then we must allocate
      * memory via the heap manager.
      */
-    if ((t = __mp_searchhigher(h->ftree.root, l + b + m)) == NULL)
+    if (t == NULL)
     {
         if ((n = getnode(h)) == NULL)
             return NULL;
         /* If all allocations are pages then we must specify that we want our
-         * heap allocation to be page-aligned.
+         * heap allocation to be page-aligned.  We also allocate a pool of
+         * pages large enough for many such allocations so that the number of
+         * distinct heap blocks and protection changes is kept to a minimum.
          */
+        k = __mp_roundup(l + b, h->heap.memory.page);
         if (h->flags & FLG_PAGEALLOC)
             m = h->heap.memory.page;
         else
             m = a;
-        if ((p = __mp_heapalloc(&h->heap,
-              __mp_roundup(l + b, h->heap.memory.page), m, 0)) == NULL)
+        p = NULL;
+        if ((h->flags & FLG_PAGEALLOC) && (k < m * MP_PAGEPOOL_SIZE))
+            p = __mp_heapalloc(&h->heap, m * MP_PAGEPOOL_SIZE, m, 0);
+        if ((p == NULL) && ((p = __mp_heapalloc(&h->heap, k, m, 0)) == NULL))
         {
             __mp_freeslot(&h->table, n);
             return NULL;
@@ -416,9 +823,10 @@ __mp_resizealloc(allochead *h, allocnode *n, size_t l)
     /* If all allocations are pages and the allocations are to be aligned
      * to the end of a page then the easiest solution is to fail here since
      * the majority of cases would require relocation of the original memory
-     * allocation.
+     * allocation.  The same applies to allocations in the guard page pool.
      */
-    if ((h->flags & FLG_PAGEALLOC) && (h->flags & FLG_ALLOCUPPER))
+    if (((h->flags & FLG_PAGEALLOC) && (h->flags & FLG_ALLOCUPPER)) ||
+        __mp_isguarded(h, n))
         return 0;
     if (l == 0)
         l = 1;
@@ -438,6 +846,11 @@ __mp_resizealloc(allochead *h, allocnode *n, size_t l)
     if ((p->lnode.next == NULL) || (p->info != NULL) ||
         ((char *) n->block + m + h->oflow < (char *) p->block))
         p = NULL;
+    else if (p->tnode.key == 0)
+        /* The bordering free node is in the free node cache and so may border
+         * further free nodes, so it must be merged with them first.
+         */
+        p = releasenode(h, p);
     if ((h->flags & FLG_PAGEALLOC) && (l <= m) && (l > m - h->heap.memory.page))
     {
         /* There is space in the existing allocated pages to perform the
@@ -492,8 +905,13 @@ __mp_resizealloc(allochead *h, allocnode *n, size_t l)
             __mp_freeslot(&h->table, p);
         }
         else
+        {
             __mp_treeinsert(&h->ftree, &p->tnode, p->size);
+            refillnode(h, p);
+        }
         h->fsize -= s;
+        if (h->fsize < h->tfree)
+            h->tfree = h->fsize;
     }
     else if (d < 0)
     {
@@ -559,6 +977,36 @@ __mp_resizealloc(allochead *h, allocnode *n, size_t l)
 }
 
 
+/* Return a node that has just been freed to the free memory, including its
+ * overflow buffers.  Small blocks are filled with the free byte and placed in
+ * the free node cache so that they can be reused quickly by an allocation of
+ * the same size, while all other blocks are placed on the free tree and are
+ * merged with any bordering free nodes.
+ */
+
+static
+void
+freenode(allochead *h, allocnode *n)
+{
+    n->block = (char *) n->block - h->oflow;
+    n->size += h->oflow << 1;
+    n->info = NULL;
+    h->fsize += n->size;
+    if (!(h->flags & FLG_PAGEALLOC))
+    {
+        __mp_memset(n->block, h->fbyte, n->size);
+        if ((MP_FREECACHE_SIZE > 0) &&
+            (cachebin(h, n->size) < MP_FREECACHE_BINS))
+        {
+            cachenode(h, n);
+            return;
+        }
+    }
+    __mp_treeinsert(&h->ftree, &n->tnode, n->size);
+    mergenode(h, n);
+}
+
+
 /* Free an existing allocation node.
  */
 
@@ -569,17 +1017,44 @@ __mp_freealloc(allochead *h, allocnode *n, void *i)
     void *p=NULL;
     size_t l, s=0;
 
-    /* If we are keeping the details (and possibly the contents) of a specified
-     * number of recently freed memory allocations then we may have to recycle
-     * the oldest freed allocation if the length of the queue would extend past
-     * the user-specified limit.
+    /* If we are keeping the details (and possibly the contents) of recently
+     * freed memory allocations then we may have to recycle the oldest freed
+     * allocations if the length of the queue or the total size of the freed
+     * allocations in it would extend past the user-specified limits.
      */
-    if ((i != NULL) && (h->flist.size != 0) && (h->flist.size == h->fmax))
-        __mp_recyclefreed(h);
+    if (i != NULL)
+        while (__mp_queuefull(h, n->size))
+            __mp_recyclefreed(h);
     /* Remove the allocated node from the allocation tree.
      */
     __mp_treeremove(&h->atree, &n->tnode);
     h->asize -= n->size;
+    if (__mp_isguarded(h, n))
+    {
+        /* The page containing an allocation from the guard page pool is made
+         * inaccessible, or read-only if we are keeping the freed allocation
+         * and preserving its contents.  Its slot will only be returned to the
+         * pool if we are not keeping the freed allocation.
+         */
+        p = (void *) __mp_rounddown((unsigned long) n->block,
+                                    h->heap.memory.page);
+        if ((i != NULL) && (h->flags & FLG_PRESERVE))
+            __mp_memprotect(&h->heap.memory, p, h->heap.memory.page,
+                            MA_READONLY);
+        else
+            __mp_memprotect(&h->heap.memory, p, h->heap.memory.page,
+                            MA_NOACCESS);
+        if (i != NULL)
+        {
+            n->info = i;
+            __mp_addtail(&h->flist, &n->fnode);
+            __mp_treeinsert(&h->gtree, &n->tnode, (unsigned long) n->block);
+            h->gsize += n->size;
+        }
+        else
+            freeguarded(h, n);
+        return;
+    }
     if (h->flags & FLG_PAGEALLOC)
     {
         p = (void *) __mp_rounddown((unsigned long) n->block,
@@ -627,10 +1102,28 @@ __mp_freealloc(allochead *h, allocnode *n, void *i)
                 }
             }
             else
+            {
+                /* The contents of the pages will never be examined again so
+                 * they can be returned to the system if we are limiting the
+                 * total size of the freed allocations.
+                 */
+                if (h->gmax != 0)
+                    __mp_memdiscard(&h->heap.memory, p, s, h->fbyte);
                 __mp_memprotect(&h->heap.memory, n->block, n->size,
                                 MA_NOACCESS);
+            }
         else if (!(h->flags & FLG_PRESERVE))
-            __mp_memset(n->block, h->fbyte, n->size);
+        {
+            if (h->gmax != 0)
+                /* Any whole pages within the freed allocation are returned to
+                 * the system rather than being filled with the free byte so
+                 * that the freed allocation no longer occupies any physical
+                 * memory.
+                 */
+                __mp_memdiscard(&h->heap.memory, n->block, n->size, h->fbyte);
+            else
+                __mp_memset(n->block, h->fbyte, n->size);
+        }
         __mp_addtail(&h->flist, &n->fnode);
         __mp_treeinsert(&h->gtree, &n->tnode, (unsigned long) n->block);
         h->gsize += n->size;
@@ -662,18 +1155,43 @@ __mp_freealloc(allochead *h, allocnode *n, void *i)
             __mp_memwatch(&h->heap.memory, (char *) n->block + n->size,
                           h->oflow, MA_READWRITE);
         }
-        n->block = (char *) n->block - h->oflow;
-        n->size += h->oflow << 1;
-        n->info = NULL;
-        if (!(h->flags & FLG_PAGEALLOC))
-            __mp_memset(n->block, h->fbyte, n->size);
-        __mp_treeinsert(&h->ftree, &n->tnode, n->size);
-        h->fsize += n->size;
-        mergenode(h, n);
+        freenode(h, n);
     }
 }
 
 
+/* Determine if an allocated or freed node was allocated from the guard page
+ * pool.
+ */
+
+MP_GLOBAL
+int
+__mp_isguarded(allochead *h, allocnode *n)
+{
+    return ((h->pool != NULL) && ((char *) n->block >= h->pool) &&
+            ((char *) n->block < h->pool + ((h->pslots *
+               h->heap.memory.page) << 1)));
+}
+
+
+/* Determine if the oldest freed allocation node must be recycled before a
+ * freed allocation of a specified size can be added to the freed queue.
+ */
+
+MP_GLOBAL
+int
+__mp_queuefull(allochead *h, size_t l)
+{
+    if (h->flist.size == 0)
+        return 0;
+    if ((h->fmax != 0) && (h->flist.size >= h->fmax))
+        return 1;
+    if ((h->gmax != 0) && (h->gsize + l > h->gmax))
+        return 1;
+    return 0;
+}
+
+
 /* Recycle a freed allocation node.
  */
 
@@ -691,6 +1209,19 @@ __mp_recyclefreed(allochead *h)
     __mp_remove(&h->flist, &n->fnode);
     __mp_treeremove(&h->gtree, &n->tnode);
     h->gsize -= n->size;
+    if (__mp_isguarded(h, n))
+    {
+        /* Return the slot to the guard page pool, making its page
+         * inaccessible if it was only read-only.
+         */
+        if (h->flags & FLG_PRESERVE)
+            __mp_memprotect(&h->heap.memory,
+                            (void *) __mp_rounddown((unsigned long) n->block,
+                                                    h->heap.memory.page),
+                            h->heap.memory.page, MA_NOACCESS);
+        freeguarded(h, n);
+        return;
+    }
     if (h->flags & FLG_PAGEALLOC)
     {
         p = (void *) __mp_rounddown((unsigned long) n->block,
@@ -717,9 +1248,11 @@ __mp_recyclefreed(allochead *h)
     {
         /* Any watch points will have already been removed, and the
          * surrounding overflow buffers will already be protected with
-         * the MA_NOACCESS flag.
+         * the MA_NOACCESS flag.  The freed allocation itself will only
+         * still be accessible if its contents were preserved.
          */
-        __mp_memprotect(&h->heap.memory, n->block, n->size, MA_NOACCESS);
+        if (h->flags & FLG_PRESERVE)
+            __mp_memprotect(&h->heap.memory, n->block, n->size, MA_NOACCESS);
         n->block = p;
         n->size = s;
     }
@@ -733,14 +1266,106 @@ __mp_recyclefreed(allochead *h)
         __mp_memwatch(&h->heap.memory, (char *) n->block + n->size, h->oflow,
                       MA_READWRITE);
     }
-    n->block = (char *) n->block - h->oflow;
-    n->size += h->oflow << 1;
-    n->info = NULL;
-    if (!(h->flags & FLG_PAGEALLOC))
-        __mp_memset(n->block, h->fbyte, n->size);
-    __mp_treeinsert(&h->ftree, &n->tnode, n->size);
-    h->fsize += n->size;
-    mergenode(h, n);
+    freenode(h, n);
+}
+
+
+/* Place all of the free nodes in the free node cache on the free tree and
+ * merge them with any bordering free nodes.
+ */
+
+MP_GLOBAL
+void
+__mp_mergefree(allochead *h)
+{
+    size_t i;
+
+    for (i = 0; i < MP_FREECACHE_BINS; i++)
+        while (h->cache[i].size > 0)
+            releasenode(h, (allocnode *) ((char *) h->cache[i].head -
+                                          offsetof(allocnode, fnode)));
+}
+
+
+/* Return as much of the free memory in the heap to the system as possible.
+ * Any heap memory blocks that lie entirely within free nodes are returned to
+ * the system and removed from the heap, and any whole pages that remain within
+ * free nodes have their contents discarded.  The number of bytes returned is
+ * added to the total and is also returned.  Any free nodes in the free node
+ * cache are merged into the free tree first.
+ */
+
+MP_GLOBAL
+size_t
+__mp_trimalloc(allochead *h)
+{
+    allocnode *n, *p;
+    heapnode *m;
+    char *b, *e;
+    size_t l, r, s;
+
+    __mp_mergefree(h);
+    s = 0;
+    for (n = (allocnode *) h->list.head; n->lnode.next != NULL;
+         n = (allocnode *) n->lnode.next)
+    {
+        if (n->info != NULL)
+            continue;
+        /* Only the first heap memory block that starts within the free node
+         * is considered here.  Any others will start after it and so will be
+         * found when the remainder of the free node is visited.
+         */
+        if (((m = (heapnode *) __mp_searchhigher(h->heap.dtree.root,
+               (unsigned long) n->block)) != NULL) &&
+            ((char *) m->block + m->size <= (char *) n->block + n->size))
+        {
+            b = (char *) m->block;
+            e = b + m->size;
+            l = b - (char *) n->block;
+            r = (char *) n->block + n->size - e;
+            p = NULL;
+            if ((l == 0) || (r == 0) || ((p = getnode(h)) != NULL))
+            {
+                /* Remove the heap memory block from the free node, creating a
+                 * new free node for the remainder to its right if there is
+                 * memory remaining on both sides.
+                 */
+                __mp_treeremove(&h->ftree, &n->tnode);
+                if (p != NULL)
+                {
+                    __mp_insert(&h->list, &n->lnode, &p->lnode);
+                    __mp_treeinsert(&h->ftree, &p->tnode, r);
+                    p->block = e;
+                    p->size = r;
+                    p->info = NULL;
+                    r = 0;
+                }
+                h->fsize -= m->size;
+                s += m->size;
+                __mp_heapfree(&h->heap, m);
+                if ((l == 0) && (r == 0))
+                {
+                    p = (allocnode *) n->lnode.prev;
+                    __mp_remove(&h->list, &n->lnode);
+                    __mp_freeslot(&h->table, n);
+                    n = p;
+                    continue;
+                }
+                n->size = l + r;
+                __mp_treeinsert(&h->ftree, &n->tnode, n->size);
+                if (l == 0)
+                {
+                    n->block = e;
+                    n = (allocnode *) n->lnode.prev;
+                    continue;
+                }
+            }
+        }
+        s += __mp_memtrim(&h->heap.memory, n->block, n->size);
+    }
+    h->tsize += s;
+    h->tfree = h->fsize;
+    return s;
 }
 
 
@@ -846,22 +1471,34 @@ __mp_findnode(allochead *h, void *p, size_t s)
      */
     while (n->lnode.next != NULL)
     {
-        if ((h->flags & FLG_PAGEALLOC) && (n->info != NULL))
+        if (__mp_isguarded(h, n))
         {
+            /* An allocation from the guard page pool is considered to occupy
+             * both its page and the inaccessible page that follows it.
+             */
             b = (void *) __mp_rounddown((unsigned long) n->block,
                                         h->heap.memory.page);
-            l = __mp_roundup(n->size + ((char *) n->block - (char *) b),
-                             h->heap.memory.page);
+            l = h->heap.memory.page << 1;
         }
         else
         {
-            b = n->block;
-            l = n->size;
-        }
-        if (n->info != NULL)
-        {
-            b = (char *) b - h->oflow;
-            l += h->oflow << 1;
+            if ((h->flags & FLG_PAGEALLOC) && (n->info != NULL))
+            {
+                b = (void *) __mp_rounddown((unsigned long) n->block,
+                                            h->heap.memory.page);
+                l = __mp_roundup(n->size + ((char *) n->block - (char *) b),
+                                 h->heap.memory.page);
+            }
+            else
+            {
+                b = n->block;
+                l = n->size;
+            }
+            if (n->info != NULL)
+            {
+                b = (char *) b - h->oflow;
+                l += h->oflow << 1;
+            }
         }
         if (p < b)
             if ((char *) p + s > (char *) b)
@@ -53,16 +53,18 @@
  * is given to preserve all freed blocks).  Both trees are ordered by
  * the start address of the memory allocation.  The free tree stores
  * details of free blocks and is ordered by the size of the free block.
+ * The fields that are used when searching the trees are placed together,
+ * with the freed list node last since it is rarely used.
  */
 
 typedef struct allocnode
 {
     listnode lnode; /* list node */
-    listnode fnode; /* freed list node */
     treenode tnode; /* tree node */
     void *block;    /* pointer to block of memory */
     size_t size;    /* size of block of memory */
     void *info;     /* associated information */
+    listnode fnode; /* freed or cached list node */
 }
 allocnode;
 
@@ -71,24 +73,41 @@ allocnode;
  * the three trees (including a fourth tree for storing details of internal
  * blocks), a list for storing all memory blocks in ascending order of
  * start address, and associated settings controlling how the memory
- * allocations are filled and if they are to have overflow buffers.
+ * allocations are filled and if they are to have overflow buffers.  It also
+ * contains an optional pool of guard pages from which a sample of the memory
+ * allocations is made.  Small blocks that have recently been freed are kept
+ * in a cache of free nodes that have not yet been placed on the free tree or
+ * merged with their neighbours, with one list for each range of sizes.
  */
 
 typedef struct allochead
 {
     heaphead heap;       /* pointer to heap */
-    slottable table;     /* table of allocation nodes */
+    slottable table;     /* table of allocation and information nodes */
     listhead list;       /* list of allocation nodes */
     listhead flist;      /* list of freed allocations */
     treeroot itree;      /* internal allocation tree */
     treeroot atree;      /* allocation tree */
     treeroot gtree;      /* freed tree */
     treeroot ftree;      /* free tree */
+    listhead cache[MP_FREECACHE_BINS]; /* free node cache */
+    size_t ccount;       /* number of nodes in free node cache */
     size_t isize;        /* internal allocation total */
     size_t asize;        /* allocation total */
     size_t gsize;        /* freed total */
     size_t fsize;        /* free total */
     size_t fmax;         /* maximum number of freed allocations */
+    size_t gmax;         /* maximum total of freed allocations */
+    size_t tmax;         /* free total increase before trimming */
+    size_t tfree;        /* lowest free total since trimming */
+    size_t tsize;        /* total returned to system by trimming */
+    char *pool;          /* guard page pool */
+    size_t pslots;       /* number of slots in guard page pool */
+    size_t pused;        /* number of slots in use */
+    size_t pnext;        /* next slot to check */
+    unsigned long sfreq; /* guard page sampling frequency */
+    unsigned long snext; /* allocations until next sample */
+    unsigned long sseed; /* guard page sampling seed */
     size_t oflow;        /* overflow buffer size */
     unsigned char obyte; /* overflow byte */
     unsigned char abyte; /* allocation byte */
@@ -109,10 +128,16 @@ extern "C"
 MP_EXPORT void __mp_newallocs(allochead *, size_t, size_t, unsigned char,
                               unsigned char, unsigned char, unsigned long);
 MP_EXPORT void __mp_deleteallocs(allochead *);
+MP_EXPORT void __mp_shareslots(allochead *, size_t, size_t);
+MP_EXPORT void *__mp_getslotnode(allochead *);
 MP_EXPORT allocnode *__mp_getalloc(allochead *, size_t, size_t, void *);
 MP_EXPORT int __mp_resizealloc(allochead *, allocnode *, size_t);
 MP_EXPORT void __mp_freealloc(allochead *, allocnode *, void *);
+MP_EXPORT int __mp_isguarded(allochead *, allocnode *);
+MP_EXPORT int __mp_queuefull(allochead *, size_t);
 MP_EXPORT void __mp_recyclefreed(allochead *);
+MP_EXPORT void __mp_mergefree(allochead *);
+MP_EXPORT size_t __mp_trimalloc(allochead *);
 MP_EXPORT int __mp_protectalloc(allochead *, memaccess);
 MP_EXPORT allocnode *__mp_findalloc(allochead *, void *);
 MP_EXPORT allocnode *__mp_findfreed(allochead *, void *);
@@ -137,6 +137,15 @@
 #endif /* MP_NAMECACHE_SIZE */
 
 
+/* The maximum number of source file and function names that can be given
+ * with the TRACESOURCE option.  Any further names will be ignored.
+ */
+
+#ifndef MP_TRACESOURCES
+#define MP_TRACESOURCES 16
+#endif /* MP_TRACESOURCES */
+
+
 /* The number of entries in the memory reservation cache.  This cache is used
  * when tracing in order to store information about heap memory reservations
  * before the tracing output file has been opened.  If the number of entries
@@ -171,6 +180,17 @@
 #endif /* MP_BUFFER_SIZE */
 
 
+/* The number of allocation records that the mptrace and mleak tools obtain
+ * from the system in one go, and also the minimum number of buckets in the
+ * hash tables that they use to look up allocations by index.  Records are
+ * reused once their allocations have been freed.
+ */
+
+#ifndef MP_ALLOCBLOCK
+#define MP_ALLOCBLOCK 4096
+#endif /* MP_ALLOCBLOCK */
+
+
 /* The number of allocation bins to use when profiling.  Details of memory
  * allocations of all sizes up to the bin size will be recorded in a table and
  * written to the profiling output file at program termination.
@@ -181,6 +201,53 @@
 #endif /* MP_BIN_SIZE */
 
 
+/* The number of lifetime bins to use for each call site when profiling.
+ * The lifetime of each freed memory allocation is measured in events and
+ * is recorded in the bin corresponding to its base 2 logarithm, with the
+ * highest bin also recording all longer lifetimes.  Every bin holds a count
+ * and a total, so each call site that allocates memory uses an extra two
+ * words per bin of internal memory and of profiling output file, which is
+ * 512 bytes on 64-bit systems with the default value.
+ */
+
+#ifndef MP_LIFEBIN_SIZE
+#define MP_LIFEBIN_SIZE 32
+#endif /* MP_LIFEBIN_SIZE */
+
+
+/* The number of size classes to use in the live statistics page.  Each live
+ * memory allocation is counted in the class corresponding to the base 2
+ * logarithm of its size, with the highest class also counting all larger
+ * allocations.
+ */
+
+#ifndef MP_STATBIN_SIZE
+#define MP_STATBIN_SIZE 32
+#endif /* MP_STATBIN_SIZE */
+
+
+/* The number of buckets to use in each latency histogram.  Each power of two
+ * nanoseconds is divided into four buckets so that the percentiles reported
+ * are accurate to within 25%, and the highest bucket also counts all longer
+ * latencies.
+ */
+
+#ifndef MP_LATBIN_SIZE
+#define MP_LATBIN_SIZE 128
+#endif /* MP_LATBIN_SIZE */
+
+
+/* The maximum number of entries in each page of a B-tree.  The keys in each
+ * page are stored together so that a page can be searched without following
+ * any pointers, and the page size is chosen so that each page occupies a
+ * whole number of cache lines.
+ */
+
+#ifndef MP_TREEPAGE_SIZE
+#define MP_TREEPAGE_SIZE 31
+#endif /* MP_TREEPAGE_SIZE */
+
+
 /* The number of buckets in the hash table used to implement the string table.
  * This must be a prime number.
  */
@@ -199,6 +266,32 @@
 #endif /* MP_LEAKTAB_SIZE */
 
 
+/* The number of buckets in the hash table used to record the memory
+ * allocations and deallocations made by each thread.  This must be a prime
+ * number.
+ */
+
+#ifndef MP_THREADTAB_SIZE
+#define MP_THREADTAB_SIZE 31
+#endif /* MP_THREADTAB_SIZE */
+
+
+/* The number of buckets in the hash table used to look up call sites when
+ * profiling.  This must be a prime number.  Like the other hash tables in
+ * the mpatrol library, this table never grows, so the average number of call
+ * sites that must be examined in a bucket is the number of distinct call
+ * stacks divided by this value.  Lookups stay fast up to a few thousand call
+ * sites, but the cost of each profiled allocation grows linearly beyond that,
+ * so this should be increased when profiling programs with tens of thousands
+ * of distinct call stacks.  Each bucket adds a pointer to the profiling
+ * header.
+ */
+
+#ifndef MP_PROFTAB_SIZE
+#define MP_PROFTAB_SIZE 1021
+#endif /* MP_PROFTAB_SIZE */
+
+
 /* The multiple of pages to allocate from the heap every time a new block of
  * internal memory is required.  The higher the value, the less distinct
  * internal blocks to keep track of, but the potential for more memory wastage
@@ -210,6 +303,77 @@
 #endif /* MP_ALLOCFACTOR */
 
 
+/* The maximum multiple of pages to allocate from the heap every time more
+ * memory is required for a slot table.  The first block of memory allocated
+ * for a slot table is MP_ALLOCFACTOR pages and each subsequent block is twice
+ * the size of the previous one until this limit is reached, so that large
+ * tables do not need many distinct internal blocks.
+ */
+
+#ifndef MP_SLOTFACTOR
+#define MP_SLOTFACTOR 256
+#endif /* MP_SLOTFACTOR */
+
+
+/* The multiple of pages to allocate from the heap every time more memory is
+ * required for user allocations when all allocations are pages.  The pool of
+ * pages is made inaccessible with a single system call and allocations are
+ * then carved from it, so only their data pages ever need their protection
+ * changed and the surrounding overflow buffers remain inaccessible.  This
+ * reduces the number of system calls and heap blocks but not the number of
+ * memory mappings, since the data pages of every allocation still form a
+ * mapping of their own between inaccessible pages, giving about two mappings
+ * per allocation.
+ */
+
+#ifndef MP_PAGEPOOL_SIZE
+#define MP_PAGEPOOL_SIZE 256
+#endif /* MP_PAGEPOOL_SIZE */
+
+
+/* The default number of slots in the guard page pool that is used to sample
+ * memory allocations when the GUARDFREQ option is used.  Each slot occupies
+ * one page for the memory allocation followed by one inaccessible page.
+ */
+
+#ifndef MP_GUARDPOOL_SIZE
+#define MP_GUARDPOOL_SIZE 256
+#endif /* MP_GUARDPOOL_SIZE */
+
+
+/* The maximum number of recently freed blocks to keep in the free node cache
+ * before they are all merged into the free tree.  Small freed blocks are kept
+ * in the cache without being merged with their neighbours so that they can be
+ * reused quickly by an allocation of the same size.  A value of zero disables
+ * the cache.
+ */
+
+#ifndef MP_FREECACHE_SIZE
+#define MP_FREECACHE_SIZE 64
+#endif /* MP_FREECACHE_SIZE */
+
+
+/* The number of bins in the free node cache.  Each bin holds free blocks
+ * whose sizes lie within one multiple of the minimum alignment for the
+ * system, so this also limits the size of the blocks that can be cached.
+ */
+
+#ifndef MP_FREECACHE_BINS
+#define MP_FREECACHE_BINS 32
+#endif /* MP_FREECACHE_BINS */
+
+
+/* The maximum number of distinct page ranges to remember when changing the
+ * protection of the library's internal memory blocks.  Adjacent and
+ * overlapping blocks are merged into a single range so that the protection of
+ * each range can be changed with one system call.
+ */
+
+#ifndef MP_PROTRANGE_SIZE
+#define MP_PROTRANGE_SIZE 32
+#endif /* MP_PROTRANGE_SIZE */
+
+
 /* The maximum number of recursive calls to C++ operator delete and operator
  * delete[] that will have source level information associated with them.
  * This acts as a workaround for the fact that placement delete will only be
@@ -351,6 +515,117 @@
 #endif /* MP_MMAP_SUPPORT */
 
 
+/* Indicates if all of the internal memory blocks used by the mpatrol library
+ * should be allocated from a single region of virtual memory which is
+ * reserved when the first internal memory block is required.  Pages in the
+ * region only become accessible when they are allocated.  Keeping the
+ * internal memory blocks together improves their locality and means that
+ * their protection can be changed with very few system calls.
+ */
+
+#ifndef MP_ARENA_SUPPORT
+#if MP_MMAP_SUPPORT && MP_MMAP_ANONYMOUS && !MP_ARRAY_SUPPORT
+#define MP_ARENA_SUPPORT 1
+#else /* MP_MMAP_SUPPORT && MP_MMAP_ANONYMOUS && MP_ARRAY_SUPPORT */
+#define MP_ARENA_SUPPORT 0
+#endif /* MP_MMAP_SUPPORT && MP_MMAP_ANONYMOUS && MP_ARRAY_SUPPORT */
+#endif /* MP_ARENA_SUPPORT */
+
+
+/* The size of the region of virtual memory to reserve for internal memory
+ * blocks.  Internal memory blocks are allocated in the usual way once the
+ * region is full.
+ */
+
+#if MP_ARENA_SUPPORT
+#ifndef MP_ARENA_SIZE
+#if ENVIRON == ENVIRON_64
+#define MP_ARENA_SIZE 0x40000000
+#else /* ENVIRON */
+#define MP_ARENA_SIZE 0x04000000
+#endif /* ENVIRON */
+#endif /* MP_ARENA_SIZE */
+#endif /* MP_ARENA_SUPPORT */
+
+
+/* Indicates if the mremap() system call can be used to move whole pages from
+ * one address to another.  This allows the contents of a large memory
+ * allocation to be relocated by a call to realloc() without copying them.
+ */
+
+#ifndef MP_MREMAP_SUPPORT
+#if MP_MMAP_SUPPORT && MP_MMAP_ANONYMOUS && !MP_ARRAY_SUPPORT && \
+    (SYSTEM == SYSTEM_ANDROID || SYSTEM == SYSTEM_LINUX)
+#define MP_MREMAP_SUPPORT 1
+#else /* MP_MMAP_SUPPORT && MP_MMAP_ANONYMOUS && MP_ARRAY_SUPPORT && SYSTEM */
+#define MP_MREMAP_SUPPORT 0
+#endif /* MP_MMAP_SUPPORT && MP_MMAP_ANONYMOUS && MP_ARRAY_SUPPORT && SYSTEM */
+#endif /* MP_MREMAP_SUPPORT */
+
+
+/* The minimum size of a memory allocation whose pages will be moved rather
+ * than copied when it is relocated.  Memory allocations of at least this size
+ * are always aligned to the system page size so that their old and new
+ * locations have the same offset within a page.
+ */
+
+#if MP_MREMAP_SUPPORT
+#ifndef MP_MREMAP_SIZE
+#define MP_MREMAP_SIZE 0x10000
+#endif /* MP_MREMAP_SIZE */
+#endif /* MP_MREMAP_SUPPORT */
+
+
+/* Indicates if user memory can be allocated in regions of transparent huge
+ * pages when the HUGEPAGES option is used.  Each region is aligned to the size
+ * of a huge page and the system is advised to back it with huge pages, which
+ * greatly reduces the number of TLB misses when accessing a large heap.
+ */
+
+#ifndef MP_HUGEPAGE_SUPPORT
+#if MP_MMAP_SUPPORT && MP_MMAP_ANONYMOUS && !MP_ARRAY_SUPPORT && \
+    (SYSTEM == SYSTEM_ANDROID || SYSTEM == SYSTEM_LINUX)
+#define MP_HUGEPAGE_SUPPORT 1
+#else /* MP_MMAP_SUPPORT && MP_MMAP_ANONYMOUS && MP_ARRAY_SUPPORT && SYSTEM */
+#define MP_HUGEPAGE_SUPPORT 0
+#endif /* MP_MMAP_SUPPORT && MP_MMAP_ANONYMOUS && MP_ARRAY_SUPPORT && SYSTEM */
+#endif /* MP_HUGEPAGE_SUPPORT */
+
+
+/* The size of a transparent huge page.  Regions of user memory allocated for
+ * the HUGEPAGES option are aligned to and rounded up to a multiple of this.
+ */
+
+#if MP_HUGEPAGE_SUPPORT
+#ifndef MP_HUGEPAGE_SIZE
+#define MP_HUGEPAGE_SIZE 0x200000
+#endif /* MP_HUGEPAGE_SIZE */
+#endif /* MP_HUGEPAGE_SUPPORT */
+
+
+/* Indicates if a UNIX system supports the shm_open() function call to create
+ * named shared memory objects.  This is required in order to publish the live
+ * statistics page with the STATSFILE option.  Note that some older systems
+ * require programs that use this function to be linked with -lrt.
+ */
+
+#ifndef MP_SHM_SUPPORT
+#if MP_MMAP_SUPPORT
+#if SYSTEM == SYSTEM_AIX || SYSTEM == SYSTEM_FREEBSD || \
+    SYSTEM == SYSTEM_HPUX || SYSTEM == SYSTEM_IRIX || \
+    SYSTEM == SYSTEM_LINUX || SYSTEM == SYSTEM_NETBSD || \
+    SYSTEM == SYSTEM_OPENBSD || SYSTEM == SYSTEM_SOLARIS || \
+    SYSTEM == SYSTEM_TRU64
+#define MP_SHM_SUPPORT 1
+#else /* SYSTEM */
+#define MP_SHM_SUPPORT 0
+#endif /* SYSTEM */
+#else /* MP_MMAP_SUPPORT */
+#define MP_SHM_SUPPORT 0
+#endif /* MP_MMAP_SUPPORT */
+#endif /* MP_SHM_SUPPORT */
+
+
 /* Indicates if a UNIX system supports the mincore() function call to
  * determine if a memory mapping is in core.
  */
@@ -1046,6 +1321,49 @@
 #endif /* MP_PROFMAGIC */
 
 
+/* The magic sequence of bytes to use at the beginning and end of every
+ * set of changes that is appended to a profiling output file.  This must
+ * be exactly four bytes in length and will be truncated if it is greater
+ * than that.
+ */
+
+#ifndef MP_DELTAMAGIC
+#define MP_DELTAMAGIC "MPTD"
+#endif /* MP_DELTAMAGIC */
+
+
+/* The magic sequence of bytes to use at the beginning of the section in a
+ * profiling output file that contains the lifetime bins for each call site.
+ * This must be exactly four bytes in length and will be truncated if it is
+ * greater than that.
+ */
+
+#ifndef MP_LIFEMAGIC
+#define MP_LIFEMAGIC "MPLF"
+#endif /* MP_LIFEMAGIC */
+
+
+/* The magic sequence of bytes to use at the beginning of the section in a
+ * profiling output file that contains the allocation summary for each
+ * thread.  This must be exactly four bytes in length and will be truncated
+ * if it is greater than that.
+ */
+
+#ifndef MP_THREADMAGIC
+#define MP_THREADMAGIC "MPTH"
+#endif /* MP_THREADMAGIC */
+
+
+/* The magic sequence of bytes to use at the beginning of the live statistics
+ * page that is published with the STATSFILE option.  This must be exactly
+ * four bytes in length and will be truncated if it is greater than that.
+ */
+
+#ifndef MP_STATSMAGIC
+#define MP_STATSMAGIC "MPST"
+#endif /* MP_STATSMAGIC */
+
+
 /* The magic sequence of bytes to use at the beginning and end of every
  * tracing output file for verification purposes.  This must be exactly
  * four bytes in length and will be truncated if it is greater than that.
@@ -1141,6 +1459,27 @@
 #endif /* MP_LARGEBOUND */
 
 
+/* The initial state of the random number generator used to choose which
+ * memory allocations are sampled when the PROFSAMPLE option is used.  This
+ * must be non-zero.
+ */
+
+#ifndef MP_PROFSEED
+#define MP_PROFSEED 2463534242UL
+#endif /* MP_PROFSEED */
+
+
+/* The number of times that the profiling output file is written before a
+ * complete profile is appended to it.  In between, only the call sites that
+ * have changed since the last write are appended to the file.  This may be overridden at
+ * run-time using the PROFCHECKPOINT option.
+ */
+
+#ifndef MP_PROFCHECKPOINT
+#define MP_PROFCHECKPOINT 16
+#endif /* MP_PROFCHECKPOINT */
+
+
 /* Ensure that the small allocation boundary is less than the medium
  * allocation boundary and the medium allocation boundary is less than the
  * large allocation boundary.
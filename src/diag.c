@@ -502,6 +502,26 @@ __mp_tracefile(memoryinfo *m, char *s)
 }
 
 
+/* Process the name of the shared memory object used for the live statistics
+ * page, expanding any special characters.  The name must begin with a slash
+ * and must not contain any others, so one is prefixed if necessary.  Note
+ * that this function is not currently re-entrant.
+ */
+
+MP_GLOBAL
+char *
+__mp_statsfile(memoryinfo *m, char *s)
+{
+    static char b[256];
+
+    if (*s == '/')
+        s++;
+    b[0] = '/';
+    processfile(m, s, b + 1, sizeof(b) - 1);
+    return b;
+}
+
+
 /* Read the contents of an environment variable.
  */
 
@@ -1906,6 +1926,76 @@ __mp_printversion(void)
 }
 
 
+/* Display the memory allocated and freed by each thread.  The allocation and
+ * deallocation rates are averaged over the time since each thread was first
+ * seen.
+ */
+
+static
+void
+printthreads(infohead *h)
+{
+    threadnode *n;
+    unsigned long s, t;
+
+    t = (unsigned long) time(NULL);
+    __mp_diag("\n%lu threads:\n\n", h->ltable.tlist.size);
+    __mp_diag("     unfreed       bytes        peak    allocs     frees  remote  "
+              "allocs/s   frees/s  thread\n");
+    __mp_diag("    --------  ----------  ----------  --------  --------  ------  "
+              "--------  --------  ------\n");
+    for (n = (threadnode *) h->ltable.tlist.head; n->data.node.next != NULL;
+         n = (threadnode *) n->data.node.next)
+    {
+        if (t > n->data.time)
+            s = t - n->data.time;
+        else
+            s = 1;
+        __mp_diag("    %8lu  %10lu  %10lu  %8lu  %8lu  %6lu  %8lu  %8lu  %lu\n",
+                  n->data.ucount, n->data.utotal, n->data.upeak,
+                  n->data.acount, n->data.dcount, n->data.rcount,
+                  n->data.acount / s, n->data.dcount / s, n->data.id);
+    }
+}
+
+
+/* Display a single row of the latency summary.
+ */
+
+static
+void
+printlatencyrow(latency *l, char *s)
+{
+    __mp_diag("    %8lu  %10lu  %10lu  %10lu  %10lu  %10lu  %s\n", l->count,
+              l->total / l->count, __mp_percentile(l, 50),
+              __mp_percentile(l, 90), __mp_percentile(l, 99), l->max, s);
+}
+
+
+/* Display the latencies of all of the entry points that have been called and
+ * of all of the phases of processing within the library.
+ */
+
+static
+void
+printlatency(infohead *h)
+{
+    size_t i;
+
+    __mp_diag("\nlatencies in nanoseconds:\n\n");
+    __mp_diag("       calls        mean         p50         p90         p99  "
+              "       max  function\n");
+    __mp_diag("    --------  ----------  ----------  ----------  ----------  "
+              "----------  --------\n");
+    for (i = 0; i < AT_MAX; i++)
+        if (h->latencies[i].count > 0)
+            printlatencyrow(&h->latencies[i], __mp_functionnames[i]);
+    for (i = 0; i < LP_MAX; i++)
+        if (h->stats.phases[i].count > 0)
+            printlatencyrow(&h->stats.phases[i], __mp_latencynames[i]);
+}
+
+
 /* Display a summary of all mpatrol library settings and statistics.
  */
 
@@ -2276,6 +2366,17 @@ __mp_printsummary(infohead *h)
         __mp_diag("%lu", h->alloc.fmax);
         __mp_diagtag("</TD>\n");
         __mp_diagtag("</TR>\n");
+        if (h->alloc.gmax != 0)
+        {
+            __mp_diagtag("<TR>\n");
+            __mp_diagtag("<TD>");
+            __mp_diag("freed queue limit");
+            __mp_diagtag("</TD>\n");
+            __mp_diagtag("<TD>");
+            __mp_printsize(h->alloc.gmax);
+            __mp_diagtag("</TD>\n");
+            __mp_diagtag("</TR>\n");
+        }
         __mp_diagtag("<TR>\n");
         __mp_diagtag("<TD>");
         __mp_diag("allocation count");
@@ -2332,22 +2433,49 @@ __mp_printsummary(infohead *h)
         __mp_diag(")");
         __mp_diagtag("</TD>\n");
         __mp_diagtag("</TR>\n");
+        if (h->alloc.pool != NULL)
+        {
+            __mp_diagtag("<TR>\n");
+            __mp_diagtag("<TD>");
+            __mp_diag("guarded slots");
+            __mp_diagtag("</TD>\n");
+            __mp_diagtag("<TD>");
+            __mp_diag("%lu (%lu in pool)", h->alloc.pused, h->alloc.pslots);
+            __mp_diagtag("</TD>\n");
+            __mp_diagtag("</TR>\n");
+        }
         __mp_diagtag("<TR>\n");
         __mp_diagtag("<TD>");
         __mp_diag("free blocks");
         __mp_diagtag("</TD>\n");
         __mp_diagtag("<TD>");
-        __mp_diag("%lu (", h->alloc.ftree.size);
+        __mp_diag("%lu (", h->alloc.ftree.size + h->alloc.ccount);
         __mp_printsize(h->alloc.fsize);
         __mp_diag(")");
         __mp_diagtag("</TD>\n");
         __mp_diagtag("</TR>\n");
+        if (h->alloc.tsize != 0)
+        {
+            __mp_diagtag("<TR>\n");
+            __mp_diagtag("<TD>");
+            __mp_diag("trimmed memory");
+            __mp_diagtag("</TD>\n");
+            __mp_diagtag("<TD>");
+            __mp_printsize(h->alloc.tsize);
+            __mp_diagtag("</TD>\n");
+            __mp_diagtag("</TR>\n");
+        }
     }
     else
     {
         __mp_diag("\nsymbols read:      %lu", h->syms.dtree.size);
         __mp_diag("\nautosave count:    %lu", h->prof.autosave);
         __mp_diag("\nfreed queue size:  %lu", h->alloc.fmax);
+        if (h->alloc.gmax != 0)
+        {
+            __mp_diag("\nfreed queue limit: ");
+            __mp_printsize(h->alloc.gmax);
+        }
         __mp_diag("\nallocation count:  %lu", h->count);
         __mp_diag("\nallocation peak:   %lu (", h->cpeak);
         __mp_printsize(h->peak);
@@ -2359,13 +2487,23 @@ __mp_printsummary(infohead *h)
         __mp_printsize(h->mtotal);
         __mp_diag(")\nfreed blocks:      %lu (", h->alloc.gtree.size);
         __mp_printsize(h->alloc.gsize);
-        __mp_diag(")\nfree blocks:       %lu (", h->alloc.ftree.size);
+        if (h->alloc.pool != NULL)
+            __mp_diag(")\nguarded slots:     %lu (%lu in pool",
+                      h->alloc.pused, h->alloc.pslots);
+        __mp_diag(")\nfree blocks:       %lu (",
+                  h->alloc.ftree.size + h->alloc.ccount);
         __mp_printsize(h->alloc.fsize);
+        if (h->alloc.tsize != 0)
+        {
+            __mp_diag(")\ntrimmed memory:    ");
+            __mp_printsize(h->alloc.tsize);
+            __mp_diag(" (returned to system");
+        }
     }
     n = h->alloc.heap.itree.size + h->alloc.itree.size + h->addr.list.size +
         h->syms.strings.list.size + h->syms.strings.tree.size +
         h->syms.itree.size + h->ltable.list.size + h->prof.ilist.size +
-        h->list.size + h->alist.size;
+        h->alist.size;
     if (__mp_diagflags & FLG_HTML)
     {
         __mp_diagtag("<TR>\n");
@@ -2381,6 +2519,30 @@ __mp_printsummary(infohead *h)
         h->syms.strings.size + h->syms.size + h->ltable.isize + h->prof.size +
         h->size;
     __mp_printsize(n);
+    /* If the internal memory blocks were allocated from the internal memory
+     * arena then display how much of it is in use and how much of it is
+     * resident in physical memory.
+     */
+    if (h->alloc.heap.memory.arena != NULL)
+    {
+        if (__mp_diagflags & FLG_HTML)
+        {
+            __mp_diag(")");
+            __mp_diagtag("</TD>\n");
+            __mp_diagtag("</TR>\n");
+            __mp_diagtag("<TR>\n");
+            __mp_diagtag("<TD>");
+            __mp_diag("internal arena");
+            __mp_diagtag("</TD>\n");
+            __mp_diagtag("<TD>");
+        }
+        else
+            __mp_diag(")\ninternal arena:    ");
+        __mp_printsize(h->alloc.heap.memory.aused);
+        __mp_diag(" (");
+        __mp_printsize(__mp_arenaresident(&h->alloc.heap.memory));
+        __mp_diag(" resident");
+    }
     if (__mp_diagflags & FLG_HTML)
     {
         __mp_diag(")");
@@ -2463,6 +2625,10 @@ __mp_printsummary(infohead *h)
         __mp_diag("\ntotal warnings:    %lu", warnings);
         __mp_diag("\ntotal errors:      %lu\n", errors);
     }
+    if (h->ltable.tlist.size > 1)
+        printthreads(h);
+    if (h->stats.timing)
+        printlatency(h);
 }
 
 
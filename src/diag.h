@@ -113,6 +113,7 @@ MP_EXPORT unsigned long __mp_diagflags;
 MP_EXPORT char *__mp_logfile(memoryinfo *, char *);
 MP_EXPORT char *__mp_proffile(memoryinfo *, char *);
 MP_EXPORT char *__mp_tracefile(memoryinfo *, char *);
+MP_EXPORT char *__mp_statsfile(memoryinfo *, char *);
 MP_EXPORT char *__mp_getenv(char *);
 MP_EXPORT int __mp_openlogfile(char *);
 MP_EXPORT int __mp_closelogfile(void);
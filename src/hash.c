@@ -0,0 +1,203 @@
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Hash tables.  This implementation uses linear probing to resolve
+ * collisions, which keeps each search within a small number of adjacent
+ * buckets, and backward shift deletion so that no tombstone entries are
+ * ever required.  The load factor of a table is never allowed to exceed
+ * three quarters.
+ */
+
+
+#include "hash.h"
+
+
+#if MP_IDENT_SUPPORT
+#ident "$Id$"
+#else /* MP_IDENT_SUPPORT */
+static MP_CONST MP_VOLATILE char *hash_id = "$Id$";
+#endif /* MP_IDENT_SUPPORT */
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+/* Scramble the bits of a key and return the index of its home bucket.  The
+ * keys used in practice tend to be sequential or aligned, so this ensures
+ * that they are spread evenly across the buckets.
+ */
+
+static
+size_t
+hashkey(unsigned long k, size_t m)
+{
+    k = (k ^ (k >> 16)) * 0x45D9F3BUL;
+    k = (k ^ (k >> 16)) * 0x45D9F3BUL;
+    k ^= k >> 16;
+    return (size_t) k & m;
+}
+
+
+/* Initialise the fields of a hash table so that the table becomes empty and
+ * has no buckets.
+ */
+
+MP_GLOBAL
+void
+__mp_newhash(hashtable *t)
+{
+    t->buckets = NULL;
+    t->mask = 0;
+    t->size = 0;
+}
+
+
+/* Supply a new block of memory to be used as the bucket array for a hash
+ * table and move all existing entries into it.  The previous bucket array
+ * is returned so that it can be freed, or NULL if the new block is too small
+ * to hold the existing entries.
+ */
+
+MP_GLOBAL
+void *
+__mp_rehash(hashtable *t, void *p, size_t s)
+{
+    hashbucket *b, *o;
+    size_t i, j, m, n;
+
+    /* Determine the largest power of two number of buckets that will fit
+     * in the supplied block.
+     */
+    if ((n = s / sizeof(hashbucket)) == 0)
+        return NULL;
+    for (m = 1; m <= n >> 1; m <<= 1);
+    if (t->size > m - (m >> 2))
+        return NULL;
+    b = (hashbucket *) p;
+    for (i = 0; i < m; i++)
+        b[i].data = NULL;
+    if ((o = t->buckets) != NULL)
+        for (i = 0; i <= t->mask; i++)
+            if (o[i].data != NULL)
+            {
+                for (j = hashkey(o[i].key, m - 1); b[j].data != NULL;
+                     j = (j + 1) & (m - 1));
+                b[j] = o[i];
+            }
+    t->buckets = b;
+    t->mask = m - 1;
+    return (void *) o;
+}
+
+
+/* Insert a new entry into a hash table.  This returns zero if the table
+ * needs to be given a larger bucket array with __mp_rehash() before the
+ * entry can be inserted.  If an entry with the same key already exists then
+ * its data is replaced.
+ */
+
+MP_GLOBAL
+int
+__mp_hashinsert(hashtable *t, unsigned long k, void *d)
+{
+    hashbucket *b;
+    size_t i;
+
+    if ((b = t->buckets) == NULL)
+        return 0;
+    for (i = hashkey(k, t->mask); b[i].data != NULL; i = (i + 1) & t->mask)
+        if (b[i].key == k)
+        {
+            b[i].data = d;
+            return 1;
+        }
+    if (t->size >= t->mask - (t->mask >> 2))
+        return 0;
+    b[i].key = k;
+    b[i].data = d;
+    t->size++;
+    return 1;
+}
+
+
+/* Remove an entry from a hash table and return its data, or NULL if no entry
+ * with the specified key exists.
+ */
+
+MP_GLOBAL
+void *
+__mp_hashremove(hashtable *t, unsigned long k)
+{
+    hashbucket *b;
+    void *d;
+    size_t h, i, j;
+
+    if ((b = t->buckets) == NULL)
+        return NULL;
+    for (i = hashkey(k, t->mask); b[i].data != NULL; i = (i + 1) & t->mask)
+        if (b[i].key == k)
+            break;
+    if ((d = b[i].data) == NULL)
+        return NULL;
+    /* Shift back any following entries in the same cluster that would no
+     * longer be reachable from their home bucket once this bucket is empty.
+     */
+    for (j = (i + 1) & t->mask; b[j].data != NULL; j = (j + 1) & t->mask)
+    {
+        h = hashkey(b[j].key, t->mask);
+        if ((i <= j) ? ((h <= i) || (h > j)) : ((h <= i) && (h > j)))
+        {
+            b[i] = b[j];
+            i = j;
+        }
+    }
+    b[i].data = NULL;
+    t->size--;
+    return d;
+}
+
+
+/* Search for an entry in a hash table and return its data, or NULL if no
+ * entry with the specified key exists.
+ */
+
+MP_GLOBAL
+void *
+__mp_hashsearch(hashtable *t, unsigned long k)
+{
+    hashbucket *b;
+    size_t i;
+
+    if ((b = t->buckets) == NULL)
+        return NULL;
+    for (i = hashkey(k, t->mask); b[i].data != NULL; i = (i + 1) & t->mask)
+        if (b[i].key == k)
+            return b[i].data;
+    return NULL;
+}
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
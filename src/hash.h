@@ -0,0 +1,86 @@
+#ifndef MP_HASH_H
+#define MP_HASH_H
+
+
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Hash tables.  These are open-addressing hash tables which map unsigned
+ * long keys to arbitrary non-null pointers and are intended for situations
+ * where a tree would be overkill because no ordering of the keys is required.
+ * Only the placement of entries within a table is dealt with by this module
+ * - dynamically allocating memory for the bucket arrays is done elsewhere.
+ */
+
+
+/*
+ * $Id$
+ */
+
+
+#include "config.h"
+#include <stddef.h>
+
+
+/* A hash bucket contains the key and data pointer for a single entry.  A
+ * bucket is considered to be empty if its data pointer is NULL.
+ */
+
+typedef struct hashbucket
+{
+    unsigned long key; /* search key */
+    void *data;        /* entry data */
+}
+hashbucket;
+
+
+/* A hash table contains a pointer to the array of buckets, which must always
+ * contain a power of two number of buckets.
+ */
+
+typedef struct hashtable
+{
+    struct hashbucket *buckets; /* array of buckets */
+    size_t mask;                /* number of buckets minus one */
+    size_t size;                /* number of entries in table */
+}
+hashtable;
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+MP_EXPORT void __mp_newhash(hashtable *);
+MP_EXPORT void *__mp_rehash(hashtable *, void *, size_t);
+MP_EXPORT int __mp_hashinsert(hashtable *, unsigned long, void *);
+MP_EXPORT void *__mp_hashremove(hashtable *, unsigned long);
+MP_EXPORT void *__mp_hashsearch(hashtable *, unsigned long);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+
+#endif /* MP_HASH_H */
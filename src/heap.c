@@ -121,12 +121,12 @@ __mp_heapalloc(heaphead *h, size_t l, size_t a, int i)
     size_t s;
 
     /* If we have no more heap node slots left then we must allocate
-     * some more memory for them.  An extra MP_ALLOCFACTOR pages of memory
-     * should suffice.
+     * some more memory for them.  The amount of memory allocated grows
+     * with the size of the slot table.
      */
     if ((n = (heapnode *) __mp_getslot(&h->table)) == NULL)
     {
-        s = h->memory.page * MP_ALLOCFACTOR;
+        s = __mp_growslots(&h->table, h->memory.page);
         if ((p = __mp_memalloc(&h->memory, &s, h->table.entalign, 0)) == NULL)
             return NULL;
         __mp_initslots(&h->table, p, s);
@@ -176,6 +176,38 @@ __mp_heapfree(heaphead *h, heapnode *n)
 }
 
 
+/* Allocate a new slot from a slot table whose memory is allocated from the
+ * heap.  If there are no free slots left then a new block of memory is
+ * allocated for the slot table, its size growing with the size of the slot
+ * table, and the first slot in the block is used as a heap index to record
+ * the block in a list of internal blocks and add its size to a total.
+ */
+
+MP_GLOBAL
+void *
+__mp_heapslot(heaphead *h, slottable *t, listhead *l, size_t *s)
+{
+    heapindex *i;
+    heapnode *p;
+    void *n;
+
+    if ((n = __mp_getslot(t)) == NULL)
+    {
+        if ((p = __mp_heapalloc(h, __mp_growslots(t, h->memory.page),
+              t->entalign, 1)) == NULL)
+            return NULL;
+        __mp_initslots(t, p->block, p->size);
+        i = (heapindex *) __mp_getslot(t);
+        __mp_addtail(l, &i->node);
+        i->block = p->block;
+        i->size = p->size;
+        *s += p->size;
+        n = __mp_getslot(t);
+    }
+    return n;
+}
+
+
 /* Protect the internal memory blocks used by the heap with the
  * supplied access permission.
  */
@@ -37,6 +37,7 @@
 
 
 #include "config.h"
+#include "list.h"
 #include "memory.h"
 #include "slots.h"
 #include "tree.h"
@@ -55,6 +56,21 @@ typedef struct heapnode
 heapnode;
 
 
+/* A heap index occupies the first slot of each block of memory that is
+ * allocated from the heap for a slot table by __mp_heapslot() and records
+ * the block in a list of internal blocks.  Any slot table that is used with
+ * __mp_heapslot() must have slots that begin with the same fields.
+ */
+
+typedef struct heapindex
+{
+    listnode node; /* internal list node */
+    void *block;   /* pointer to block of memory */
+    size_t size;   /* size of block of memory */
+}
+heapindex;
+
+
 /* A heap head contains the slot table of heap nodes, whose memory blocks
  * are allocated in the internal allocation tree.
  */
@@ -84,6 +100,7 @@ MP_EXPORT void __mp_newheap(heaphead *);
 MP_EXPORT void __mp_deleteheap(heaphead *);
 MP_EXPORT heapnode *__mp_heapalloc(heaphead *, size_t, size_t, int);
 MP_EXPORT void __mp_heapfree(heaphead *, heapnode *);
+MP_EXPORT void *__mp_heapslot(heaphead *, slottable *, listhead *, size_t *);
 MP_EXPORT int __mp_heapprotect(heaphead *, memaccess);
 
 
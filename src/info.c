@@ -67,6 +67,7 @@ __mp_newinfo(infohead *h)
 {
     struct { char x; allocanode y; } w;
     struct { char x; infonode y; } z;
+    size_t i;
     long n;
 
     /* The signal table is initialised before this function is called
@@ -76,20 +77,23 @@ __mp_newinfo(infohead *h)
     __mp_newallocs(&h->alloc, 0, MP_OVERFLOW, MP_OVERBYTE, MP_ALLOCBYTE,
                    MP_FREEBYTE, 0);
     __mp_newaddrs(&h->addr, &h->alloc.heap);
-    __mp_newsymbols(&h->syms, &h->alloc.heap, h);
+    __mp_newsymbols(&h->syms, &h->alloc.heap, &h->stats, h);
     __mp_newleaktab(&h->ltable, &h->alloc.heap);
-    __mp_newprofile(&h->prof, &h->alloc.heap, &h->syms);
-    __mp_newtrace(&h->trace, &h->alloc.heap.memory);
+    __mp_newprofile(&h->prof, &h->alloc.heap, &h->syms, &h->ltable,
+                    &h->stats);
+    __mp_newtrace(&h->trace, &h->alloc.heap.memory, &h->stats);
+    __mp_newstats(&h->stats, &h->alloc.heap.memory);
+    for (i = 0; i < AT_MAX; i++)
+        __mp_newlatency(&h->latencies[i]);
     /* Determine the minimum alignment for an allocation information node
      * on this system and force the alignment to be a power of two.  This
-     * information is used when initialising the slot table.  Likewise for
-     * the slot table of allocanodes.
+     * information is used when sharing the slot table of allocation nodes.
+     * Likewise for the slot table of allocanodes.
      */
     n = (char *) &z.y - &z.x;
-    __mp_newslots(&h->table, sizeof(infonode), __mp_poweroftwo(n));
+    __mp_shareslots(&h->alloc, sizeof(infonode), __mp_poweroftwo(n));
     n = (char *) &w.y - &w.x;
     __mp_newslots(&h->atable, sizeof(allocanode), __mp_poweroftwo(n));
-    __mp_newlist(&h->list);
     __mp_newlist(&h->alist);
     __mp_newlist(&h->astack);
     /* Initialise the settings to their default values.
@@ -118,6 +122,7 @@ __mp_newinfo(infohead *h)
 #endif /* MP_PROTECT_SUPPORT */
     h->pid = __mp_processid();
     h->prot = MA_READWRITE;
+    h->dprot = 0;
     /* Now that the infohead has valid fields we can now set the initialised
      * flag.  This means that the library can now recursively call malloc()
      * or another memory allocation function without any problems.  It just
@@ -143,11 +148,8 @@ __mp_deleteinfo(infohead *h)
     __mp_deletesymbols(&h->syms);
     __mp_deleteaddrs(&h->addr);
     __mp_deleteallocs(&h->alloc);
-    h->table.free = NULL;
-    h->table.size = 0;
     h->atable.free = NULL;
     h->atable.size = 0;
-    __mp_newlist(&h->list);
     __mp_newlist(&h->alist);
     __mp_newlist(&h->astack);
     h->size = h->event = h->count = h->cpeak = h->peak = 0;
@@ -200,34 +202,15 @@ __mp_atfini(infohead *h, void (*f)(void))
 }
 
 
-/* Allocate a new allocation information node.
+/* Allocate a new allocation information node from the slot table of
+ * allocation nodes.
  */
 
 static
 infonode *
 getinfonode(infohead *h)
 {
-    infonode *n;
-    heapnode *p;
-
-    /* If we have no more allocation information node slots left then we
-     * must allocate some more memory for them.  An extra MP_ALLOCFACTOR
-     * pages of memory should suffice.
-     */
-    if ((n = (infonode *) __mp_getslot(&h->table)) == NULL)
-    {
-        if ((p = __mp_heapalloc(&h->alloc.heap, h->alloc.heap.memory.page *
-              MP_ALLOCFACTOR, h->table.entalign, 1)) == NULL)
-            return NULL;
-        __mp_initslots(&h->table, p->block, p->size);
-        n = (infonode *) __mp_getslot(&h->table);
-        __mp_addtail(&h->list, &n->index.node);
-        n->index.block = p->block;
-        n->index.size = p->size;
-        h->size += p->size;
-        n = (infonode *) __mp_getslot(&h->table);
-    }
-    return n;
+    return (infonode *) __mp_getslotnode(&h->alloc);
 }
 
 
@@ -238,26 +221,8 @@ static
 allocanode *
 getallocanode(infohead *h)
 {
-    allocanode *n;
-    heapnode *p;
-
-    /* If we have no more allocanode slots left then we must allocate some more
-     * memory for them.  An extra MP_ALLOCFACTOR pages of memory should suffice.
-     */
-    if ((n = (allocanode *) __mp_getslot(&h->atable)) == NULL)
-    {
-        if ((p = __mp_heapalloc(&h->alloc.heap, h->alloc.heap.memory.page *
-              MP_ALLOCFACTOR, h->atable.entalign, 1)) == NULL)
-            return NULL;
-        __mp_initslots(&h->atable, p->block, p->size);
-        n = (allocanode *) __mp_getslot(&h->atable);
-        __mp_addtail(&h->alist, &n->node);
-        n->block = p->block;
-        n->data.size = p->size;
-        h->size += p->size;
-        n = (allocanode *) __mp_getslot(&h->atable);
-    }
-    return n;
+    return (allocanode *) __mp_heapslot(&h->alloc.heap, &h->atable, &h->alist,
+                                        &h->size);
 }
 
 
@@ -299,6 +264,201 @@ leaktabentry(infohead *h, infonode *m, size_t l, int f)
 }
 
 
+/* Record an allocation or deallocation made by a particular thread in the
+ * thread table.  Deallocations are also recorded against the thread which
+ * made the original allocation.  The size classes of the live statistics
+ * are updated at the same time.
+ */
+
+static
+void
+threadentry(infohead *h, infonode *m, unsigned long t, size_t l, int f)
+{
+    unsigned long o;
+
+    if (m->data.flags & FLG_INTERNAL)
+        return;
+#if MP_THREADS_SUPPORT
+    o = m->data.thread;
+#else /* MP_THREADS_SUPPORT */
+    o = 0;
+#endif /* MP_THREADS_SUPPORT */
+    if (f == 0)
+    {
+        __mp_allocthread(&h->ltable, t, l);
+        __mp_statsalloc(&h->stats, l);
+    }
+    else
+    {
+        __mp_freethread(&h->ltable, t, o, l);
+        __mp_statsfree(&h->stats, l);
+    }
+}
+
+
+/* Report that a freed allocation has been written to after it was freed
+ * and then abort.
+ */
+
+static
+void
+freedcorrupt(infohead *h, allocnode *n, void *p, loginfo *v)
+{
+    size_t l;
+
+    __mp_log(h, v);
+    __mp_printsummary(h);
+    __mp_diag("\n");
+    __mp_error(ET_FRDCOR, AT_MAX, v->file, v->line, NULL, n->block, p);
+    if ((l = (char *) n->block + n->size - (char *) p) > 256)
+        __mp_printmemory(p, 256);
+    else
+        __mp_printmemory(p, l);
+    __mp_diag("\n");
+    __mp_printalloc(&h->syms, n);
+    h->fini = 1;
+    __mp_abort();
+}
+
+
+/* Check that a freed allocation is still filled with the free byte.  If the
+ * total size of the freed allocations is being limited then their contents
+ * are not checked by __mp_checkinfo() since some of their pages may have been
+ * returned to the system, so they are checked here instead.
+ */
+
+static
+void
+checkfreed(infohead *h, allocnode *n, loginfo *v)
+{
+    void *p;
+
+    if ((h->alloc.gmax != 0) && !(h->alloc.flags & FLG_PAGEALLOC) &&
+        !(h->alloc.flags & FLG_PRESERVE) && !__mp_isguarded(&h->alloc, n) &&
+        (p = __mp_memcheckpages(&h->alloc.heap.memory, n->block, n->size,
+                                h->alloc.fbyte)))
+        freedcorrupt(h, n, p, v);
+}
+
+
+/* Recycle the oldest freed allocations until there is room in the freed
+ * queue for a freed allocation of a specified size, checking each of them
+ * before they are returned to the free memory pool.
+ */
+
+static
+void
+recyclefreed(infohead *h, size_t l, loginfo *v)
+{
+    while (__mp_queuefull(&h->alloc, l))
+    {
+        checkfreed(h, (allocnode *) ((char *) h->alloc.flist.head -
+                                     offsetof(allocnode, fnode)), v);
+        __mp_recyclefreed(&h->alloc);
+    }
+}
+
+
+/* Recycle the oldest freed allocations until no more than a specified number
+ * remain in the freed queue, checking each of them before they are returned
+ * to the free memory pool.
+ */
+
+MP_GLOBAL
+void
+__mp_flushfreed(infohead *h, size_t c, loginfo *v)
+{
+    while (h->alloc.flist.size > c)
+    {
+        checkfreed(h, (allocnode *) ((char *) h->alloc.flist.head -
+                                     offsetof(allocnode, fnode)), v);
+        __mp_recyclefreed(&h->alloc);
+    }
+}
+
+
+/* Check all of the freed allocations that are still in the freed queue.  This
+ * is needed when the library terminates since any that have not yet been
+ * recycled would otherwise never be checked.
+ */
+
+MP_GLOBAL
+void
+__mp_checkfreed(infohead *h, loginfo *v)
+{
+    listnode *l;
+
+    for (l = h->alloc.flist.head; l->next != NULL; l = l->next)
+        checkfreed(h, (allocnode *) ((char *) l - offsetof(allocnode, fnode)),
+                   v);
+}
+
+
+/* Return free memory to the system if enough of it has been freed since the
+ * heap was last trimmed.
+ */
+
+static
+void
+trimfree(infohead *h)
+{
+    if ((h->alloc.tmax != 0) &&
+        (h->alloc.fsize - h->alloc.tfree >= h->alloc.tmax))
+        __mp_trimalloc(&h->alloc);
+}
+
+
+/* Allocate a new memory block for an allocation that is being relocated by a
+ * reallocation function.
+ */
+
+static
+allocnode *
+getrelocated(infohead *h, infonode *m, size_t l, size_t d, size_t a)
+{
+    allocnode *n;
+    size_t s;
+
+    /* If the allocation has been grown by a reallocation function before then
+     * it is likely to be grown again, so we allocate half as much memory again
+     * as was requested and then shrink the new allocation back to the requested
+     * size.  That leaves a free block immediately after the new allocation,
+     * into which its next few reallocations can extend without relocating it.
+     */
+    if ((l > d) && (m->data.realloc > 1) &&
+        !((h->alloc.flags & FLG_PAGEALLOC) &&
+          (h->alloc.flags & FLG_ALLOCUPPER)) && ((s = l + (l >> 1)) > l) &&
+        (n = __mp_getalloc(&h->alloc, s, a, m)))
+    {
+        if (__mp_resizealloc(&h->alloc, n, l))
+            return n;
+        __mp_freealloc(&h->alloc, n, NULL);
+    }
+    return __mp_getalloc(&h->alloc, l, a, m);
+}
+
+
+/* Copy the contents of an allocation that is being relocated to its new
+ * location.  If the old allocation is about to be made inaccessible or have
+ * its pages discarded then any whole pages can be moved rather than copied,
+ * but otherwise it is cheaper to copy them than to fault in the zero-filled
+ * pages that would replace them when the old allocation is filled with the
+ * free byte.
+ */
+
+static
+void
+copyrelocated(infohead *h, void *t, void *s, size_t l, int k)
+{
+    if ((h->alloc.flags & FLG_OFLOWWATCH) ||
+        (k && (h->alloc.flags & FLG_PRESERVE)) ||
+        !((h->alloc.flags & FLG_PAGEALLOC) || (k && (h->alloc.gmax != 0))))
+        __mp_memcopy(t, s, l);
+    else
+        __mp_memremap(&h->alloc.heap.memory, t, s, l);
+}
+
+
 /* Allocate a new block of memory of a specified size and alignment.
  */
 
@@ -419,6 +579,7 @@ __mp_getmemory(infohead *h, size_t l, size_t a, loginfo *v)
                 m->data.stack = __mp_getaddrs(&h->addr, v->stack);
                 m->data.typestr = v->typestr;
                 m->data.typesize = v->typesize;
+                m->data.psize = 0;
                 m->data.userdata = NULL;
                 if (h->recur > 1)
                     m->data.flags = FLG_INTERNAL;
@@ -432,25 +593,32 @@ __mp_getmemory(infohead *h, size_t l, size_t a, loginfo *v)
                     __mp_memset(p, h->alloc.abyte, l);
                 if (h->recur == 1)
                 {
+                    threadentry(h, m, t, n->size, 0);
                     if (h->ltable.tracing)
                         leaktabentry(h, m, l, 0);
                     if (h->prof.profiling &&
-                        __mp_profilealloc(&h->prof, n->size, m,
-                                          !(h->flags & FLG_NOPROTECT)))
-                        m->data.flags |= FLG_PROFILED;
-                    if (h->trace.tracing)
+                        __mp_profilesample(&h->prof, n->size))
                     {
+                        /* The size at which the allocation was sampled
+                         * determines the weight of every profiling event
+                         * that is later recorded for it.
+                         */
+                        m->data.psize = n->size;
+                        if (__mp_profilealloc(&h->prof, n->size, m,
+                                              !(h->flags & FLG_NOPROTECT)))
+                            m->data.flags |= FLG_PROFILED;
+                    }
+                    if (h->trace.tracing &&
                         __mp_tracealloc(&h->trace, c, p, l, t, v->func, v->file,
-                                        v->line);
+                                        v->line))
                         m->data.flags |= FLG_TRACED;
-                    }
                 }
 #if MP_INUSE_SUPPORT
                 _Inuse_malloc(p, l);
 #endif /* MP_INUSE_SUPPORT */
             }
             else
-                __mp_freeslot(&h->table, m);
+                __mp_freeslot(&h->alloc.table, m);
         }
         if (((v->type == AT_ALLOCA) || (v->type == AT_STRDUPA) ||
              (v->type == AT_STRNDUPA)) && (g != NULL))
@@ -642,22 +810,24 @@ __mp_resizememory(infohead *h, void *p, size_t l, size_t a, loginfo *v)
                     i->data.stack = __mp_getaddrs(&h->addr, v->stack);
                     i->data.typestr = m->data.typestr;
                     i->data.typesize = m->data.typesize;
+                    i->data.psize = m->data.psize;
                     i->data.userdata = m->data.userdata;
                     i->data.flags = m->data.flags | FLG_FREED;
-                    __mp_memcopy(r->block, n->block, (l > d) ? d : l);
+                    copyrelocated(h, r->block, n->block, (l > d) ? d : l, 1);
                     if (m->data.flags & FLG_TRACED)
                         __mp_tracerealloc(&h->trace, m->data.alloc, r->block,
                                           l, t, v->func, v->file, v->line);
 #if MP_INUSE_SUPPORT
                     _Inuse_realloc(n->block, r->block, l);
 #endif /* MP_INUSE_SUPPORT */
+                    recyclefreed(h, n->size, v);
                     __mp_freealloc(&h->alloc, n, i);
                     p = r->block;
                 }
                 else
                 {
                     if (i != NULL)
-                        __mp_freeslot(&h->table, i);
+                        __mp_freeslot(&h->alloc.table, i);
                     p = NULL;
                 }
             else if (l == d)
@@ -673,10 +843,11 @@ __mp_resizememory(infohead *h, void *p, size_t l, size_t a, loginfo *v)
                  */
                 if ((v->type != AT_EXPAND) &&
                     (((h->alloc.flags & FLG_PAGEALLOC) &&
-                      (h->alloc.flags & FLG_ALLOCUPPER)) || (l > d)) &&
-                    (r = __mp_getalloc(&h->alloc, l, a, m)))
+                      (h->alloc.flags & FLG_ALLOCUPPER)) || (l > d) ||
+                     __mp_isguarded(&h->alloc, n)) &&
+                    (r = getrelocated(h, m, l, d, a)))
                 {
-                    __mp_memcopy(r->block, n->block, (l > d) ? d : l);
+                    copyrelocated(h, r->block, n->block, (l > d) ? d : l, 0);
                     if (m->data.flags & FLG_TRACED)
                         __mp_tracerealloc(&h->trace, m->data.alloc, r->block,
                                           l, t, v->func, v->file, v->line);
@@ -707,10 +878,11 @@ __mp_resizememory(infohead *h, void *p, size_t l, size_t a, loginfo *v)
                     h->mtotal -= d;
                     h->mtotal += l;
                 }
+                threadentry(h, m, t, d, 1);
                 if (h->ltable.tracing)
                     leaktabentry(h, m, d, 1);
                 if (m->data.flags & FLG_PROFILED)
-                    __mp_profilefree(&h->prof, d, m,
+                    __mp_profilefree(&h->prof, d, m, h->event,
                                      !(h->flags & FLG_NOPROTECT));
                 m->data.type = v->type;
 #if MP_THREADS_SUPPORT
@@ -724,11 +896,13 @@ __mp_resizememory(infohead *h, void *p, size_t l, size_t a, loginfo *v)
                 m->data.stack = __mp_getaddrs(&h->addr, v->stack);
                 m->data.typestr = v->typestr;
                 m->data.typesize = v->typesize;
+                threadentry(h, m, t, l, 0);
                 if (h->ltable.tracing)
                     leaktabentry(h, m, l, 0);
                 if (m->data.flags & FLG_PROFILED)
                     __mp_profilealloc(&h->prof, l, m,
                                       !(h->flags & FLG_NOPROTECT));
+                trimfree(h);
             }
             if ((h->recur == 1) && !(h->flags & FLG_NOPROTECT))
                 __mp_protectinfo(h, MA_READONLY);
@@ -866,10 +1040,12 @@ __mp_freememory(infohead *h, void *p, loginfo *v)
         }
         if (!(h->flags & FLG_NOPROTECT))
             __mp_protectinfo(h, MA_READWRITE);
+        threadentry(h, m, t, n->size, 1);
         if (h->ltable.tracing)
             leaktabentry(h, m, n->size, 1);
         if (m->data.flags & FLG_PROFILED)
-            __mp_profilefree(&h->prof, n->size, m, !(h->flags & FLG_NOPROTECT));
+            __mp_profilefree(&h->prof, n->size, m, h->event,
+                             !(h->flags & FLG_NOPROTECT));
         if (m->data.flags & FLG_TRACED)
             __mp_tracefree(&h->trace, m->data.alloc, t, v->func, v->file,
                            v->line);
@@ -892,7 +1068,7 @@ __mp_freememory(infohead *h, void *p, loginfo *v)
         }
         else
         {
-            __mp_freeslot(&h->table, m);
+            __mp_freeslot(&h->alloc.table, m);
             m = NULL;
         }
         if ((v->type == AT_ALLOCA) || (v->type == AT_DEALLOCA))
@@ -920,7 +1096,10 @@ __mp_freememory(infohead *h, void *p, loginfo *v)
 #if MP_INUSE_SUPPORT
         _Inuse_free(p);
 #endif /* MP_INUSE_SUPPORT */
+        if (m != NULL)
+            recyclefreed(h, n->size, v);
         __mp_freealloc(&h->alloc, n, m);
+        trimfree(h);
         if ((h->recur == 1) && !(h->flags & FLG_NOPROTECT))
             __mp_protectinfo(h, MA_READONLY);
     }
@@ -1080,24 +1259,12 @@ __mp_comparememory(infohead *h, void *p, void *q, size_t l, loginfo *v)
  * with the supplied access permission.
  */
 
-MP_GLOBAL
+static
 int
-__mp_protectinfo(infohead *h, memaccess a)
+protectinfo(infohead *h, memaccess a)
 {
     allocanode *m;
-    infonode *n;
 
-    /* The library already knows what its protection status is so we don't
-     * need to do anything if the request has already been done.
-     */
-    if (a == h->prot)
-        return 1;
-    h->prot = a;
-    for (n = (infonode *) h->list.head; n->index.node.next != NULL;
-         n = (infonode *) n->index.node.next)
-        if (!__mp_memprotect(&h->alloc.heap.memory, n->index.block,
-             n->index.size, a))
-            return 0;
     for (m = (allocanode *) h->alist.head; m->node.next != NULL;
          m = (allocanode *) m->node.next)
         if (!__mp_memprotect(&h->alloc.heap.memory, m->block, m->data.size, a))
@@ -1110,6 +1277,85 @@ __mp_protectinfo(infohead *h, memaccess a)
 }
 
 
+/* Change the protection status of the internal memory blocks, batching
+ * the requests so that adjacent memory blocks are protected with a single
+ * system call and recording the time taken if latencies are being recorded.
+ */
+
+static
+int
+changeprotection(infohead *h, memaccess a)
+{
+    unsigned long t;
+    int r;
+
+    h->prot = a;
+    t = __mp_starttimer(&h->stats);
+    __mp_startprotect(&h->alloc.heap.memory);
+    r = protectinfo(h, a);
+    if (!__mp_endprotect(&h->alloc.heap.memory))
+        r = 0;
+    __mp_stoptimer(&h->stats, &h->stats.phases[LP_PROTECT], t);
+    return r;
+}
+
+
+/* Protect the internal memory blocks used by the mpatrol library
+ * with the supplied access permission.
+ */
+
+MP_GLOBAL
+int
+__mp_protectinfo(infohead *h, memaccess a)
+{
+    /* If a request to make the internal memory blocks read-only has been
+     * deferred then they are still writable.
+     */
+    if (h->dprot)
+    {
+        if (a == MA_READONLY)
+            return 1;
+        h->dprot = 0;
+    }
+    /* The library already knows what its protection status is so we don't
+     * need to do anything if the request has already been done.
+     */
+    if (a == h->prot)
+        return 1;
+    /* The internal memory blocks are made writable and then read-only again
+     * several times during a single call to the library, which can require
+     * a large number of system calls.  If we have been called from within the
+     * library then a request to make them read-only is deferred until just
+     * before the library returns control to the user, unless there are user
+     * handlers installed that could be called before then.
+     */
+    if ((a == MA_READONLY) && (h->prot == MA_READWRITE) && (h->recur > 0) &&
+        (h->prologue == NULL) && (h->epilogue == NULL) &&
+        (h->nomemory == NULL))
+    {
+        h->dprot = 1;
+        return 1;
+    }
+    return changeprotection(h, a);
+}
+
+
+/* Make the internal memory blocks read-only if a request to do so was
+ * deferred.  This must be called before the library returns control to the
+ * user.
+ */
+
+MP_GLOBAL
+int
+__mp_syncinfo(infohead *h)
+{
+    if (!h->dprot)
+        return 1;
+    h->dprot = 0;
+    return changeprotection(h, MA_READONLY);
+}
+
+
 /* Check the validity of all memory blocks that have been filled with
  * a predefined pattern.
  */
@@ -1122,6 +1368,7 @@ __mp_checkinfo(infohead *h, loginfo *v)
     infonode *m;
     void *b, *p;
     size_t l, s;
+    int g;
 
     for (n = (allocnode *) h->alloc.list.head; n->lnode.next != NULL;
          n = (allocnode *) n->lnode.next)
@@ -1130,10 +1377,15 @@ __mp_checkinfo(infohead *h, loginfo *v)
         {
             /* Check that all free blocks are filled with the free byte, but
              * only if all allocations are not pages since they will be read
-             * and write protected in that case.
+             * and write protected in that case.  If any free memory has been
+             * returned to the system then pages that are no longer resident
+             * are not checked since that would bring them back into memory.
              */
             if (!(h->alloc.flags & FLG_PAGEALLOC) &&
-                (p = __mp_memcheck(n->block, h->alloc.fbyte, n->size)))
+                (p = (h->alloc.tsize != 0) ?
+                 __mp_memcheckresident(&h->alloc.heap.memory, n->block, n->size,
+                                       h->alloc.fbyte) :
+                 __mp_memcheck(n->block, h->alloc.fbyte, n->size)))
             {
                 __mp_log(h, v);
                 __mp_printsummary(h);
@@ -1149,34 +1401,27 @@ __mp_checkinfo(infohead *h, loginfo *v)
             else
                 continue;
         }
-        if ((m->data.flags & FLG_FREED) && !(h->alloc.flags & FLG_PAGEALLOC) &&
-            !(h->alloc.flags & FLG_PRESERVE))
+        /* Allocations from the guard page pool are treated as if all
+         * allocations are pages.
+         */
+        g = ((h->alloc.flags & FLG_PAGEALLOC) ||
+             __mp_isguarded(&h->alloc, n));
+        if ((m->data.flags & FLG_FREED) && !g &&
+            !(h->alloc.flags & FLG_PRESERVE) && (h->alloc.gmax == 0))
             /* Check that all freed blocks are filled with the free byte, but
              * only if all allocations are not pages and the original contents
-             * were not preserved.
+             * were not preserved.  If the total size of the freed allocations
+             * is being limited then this is only done when they are recycled
+             * since some of their pages may have been returned to the system.
              */
             if ((p = __mp_memcheck(n->block, h->alloc.fbyte, n->size)) != NULL)
-            {
-                __mp_log(h, v);
-                __mp_printsummary(h);
-                __mp_diag("\n");
-                __mp_error(ET_FRDCOR, AT_MAX, v->file, v->line, NULL, n->block,
-                           p);
-                if ((l = (char *) n->block + n->size - (char *) p) > 256)
-                    __mp_printmemory(p, 256);
-                else
-                    __mp_printmemory(p, l);
-                __mp_diag("\n");
-                __mp_printalloc(&h->syms, n);
-                h->fini = 1;
-                __mp_abort();
-            }
+                freedcorrupt(h, n, p, v);
         if (h->alloc.flags & FLG_OFLOWWATCH)
             /* If we have watch areas on every overflow buffer then we don't
              * need to perform the following checks.
              */
             continue;
-        if ((h->alloc.flags & FLG_PAGEALLOC) && !(m->data.flags & FLG_FREED))
+        if (g && !(m->data.flags & FLG_FREED))
         {
             /* Check that all allocated blocks have overflow buffers filled with
              * the overflow byte, but only if all allocations are pages as this
@@ -1212,7 +1457,7 @@ __mp_checkinfo(infohead *h, loginfo *v)
                 __mp_abort();
             }
         }
-        if (!(h->alloc.flags & FLG_PAGEALLOC) && ((l = h->alloc.oflow) > 0))
+        if (!g && ((l = h->alloc.oflow) > 0))
             /* Check that all allocated and freed blocks have overflow buffers
              * filled with the overflow byte, but only if all allocations are
              * not pages and the overflow buffer size is greater than zero.
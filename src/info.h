@@ -40,6 +40,7 @@
 #include "leaktab.h"
 #include "profile.h"
 #include "trace.h"
+#include "stats.h"
 #include "signals.h"
 
 
@@ -250,37 +251,32 @@ typedef struct delstack
 delstack;
 
 
-/* An allocation information node belongs to a table of nodes, although
- * details of internal memory allocations are also stored in allocation
- * information nodes as part of a list.
+/* An allocation information node is stored in the same slot table as the
+ * allocation nodes, so that it is normally placed next to the allocation node
+ * that refers to it.  The fields that are needed by most library calls are
+ * placed first, and the type and flags are packed into a single word.
  */
 
 typedef union infonode
 {
-    struct
-    {
-        listnode node;         /* internal list node */
-        void *block;           /* pointer to block of memory */
-        size_t size;           /* size of block of memory */
-    }
-    index;
     struct
     {
         alloctype type;        /* type of memory allocation */
+        unsigned int flags;    /* allocation flags */
         unsigned long alloc;   /* allocation index */
         unsigned long realloc; /* reallocation index */
+        addrnode *stack;       /* call stack details */
+        unsigned long event;   /* event of last modification */
 #if MP_THREADS_SUPPORT
         unsigned long thread;  /* thread identifier */
 #endif /* MP_THREADS_SUPPORT */
-        unsigned long event;   /* event of last modification */
         char *func;            /* calling function name */
         char *file;            /* file name in which call took place */
         unsigned long line;    /* line number at which call took place */
-        addrnode *stack;       /* call stack details */
         char *typestr;         /* type stored in allocation */
         size_t typesize;       /* size of type stored in allocation */
+        size_t psize;          /* size when sampled for profiling */
         void *userdata;        /* user data associated with allocation */
-        unsigned long flags;   /* allocation flags */
     }
     data;
 }
@@ -300,9 +296,9 @@ typedef struct infohead
     leaktab ltable;                   /* leak table */
     profhead prof;                    /* profiling information */
     tracehead trace;                  /* tracing information */
-    slottable table;                  /* table of information nodes */
+    statshead stats;                  /* live statistics */
+    latency latencies[AT_MAX];        /* entry point latencies */
     slottable atable;                 /* table of allocanodes */
-    listhead list;                    /* internal allocation list */
     listhead alist;                   /* internal allocanode list */
     listhead astack;                  /* alloca allocation stack */
     size_t size;                      /* internal allocation total */
@@ -339,6 +335,7 @@ typedef struct infohead
     unsigned long flags;              /* global flags */
     unsigned long pid;                /* process identifier */
     memaccess prot;                   /* protection status */
+    char dprot;                       /* deferred protection flag */
     size_t recur;                     /* recursion count */
     char init;                        /* initialisation flag */
     char fini;                        /* finalisation flag */
@@ -368,7 +365,10 @@ MP_EXPORT void *__mp_locatememory(infohead *, void *, size_t, void *, size_t,
                                   loginfo *);
 MP_EXPORT int __mp_comparememory(infohead *, void *, void *, size_t, loginfo *);
 MP_EXPORT int __mp_protectinfo(infohead *, memaccess);
+MP_EXPORT int __mp_syncinfo(infohead *);
 MP_EXPORT void __mp_checkinfo(infohead *, loginfo *);
+MP_EXPORT void __mp_flushfreed(infohead *, size_t, loginfo *);
+MP_EXPORT void __mp_checkfreed(infohead *, loginfo *);
 MP_EXPORT int __mp_checkrange(infohead *, void *, size_t, loginfo *);
 MP_EXPORT int __mp_checkstring(infohead *, char *, size_t *, loginfo *, int);
 MP_EXPORT size_t __mp_fixalign(infohead *, alloctype, size_t);
@@ -245,6 +245,37 @@ savesignals(void)
 }
 
 
+/* Write a snapshot of the heap statistics to the live statistics page.
+ */
+
+static
+void
+updatestats(void)
+{
+    statspage *p;
+
+    p = __mp_lockstats(&memhead.stats);
+    p->event = memhead.event;
+    p->acount = memhead.alloc.atree.size;
+    p->atotal = memhead.alloc.asize;
+    p->cpeak = memhead.cpeak;
+    p->peak = memhead.peak;
+    p->fcount = memhead.alloc.ftree.size + memhead.alloc.ccount;
+    p->ftotal = memhead.alloc.fsize;
+    p->gcount = memhead.alloc.gtree.size;
+    p->gtotal = memhead.alloc.gsize;
+    p->mcount = memhead.mcount;
+    p->mtotal = memhead.mtotal;
+    p->hsize = memhead.alloc.heap.isize;
+    p->tsize = memhead.alloc.isize;
+    p->ssize = memhead.syms.strings.size + memhead.syms.size;
+    p->lsize = memhead.ltable.isize;
+    p->psize = memhead.prof.size;
+    p->isize = memhead.addr.size + memhead.size;
+    __mp_unlockstats(&memhead.stats);
+}
+
+
 /* Restore the previous signal handlers.  Also unlock the library data
  * structures if we are thread-safe.
  */
@@ -253,10 +284,19 @@ static
 void
 restoresignals(void)
 {
-    /* Only perform this step if we are not doing a recursive call.
+    /* Only perform this step if we are not doing a recursive call.  Any
+     * deferred protection of the internal memory blocks is also applied at
+     * this point, and the live statistics page is updated if there have been
+     * any allocation events since it was last written.
      */
     if (--memhead.recur == 0)
+    {
+        __mp_syncinfo(&memhead);
         __mp_restoresignals(&memhead.signals);
+        if ((memhead.stats.page != NULL) &&
+            (memhead.stats.page->event != memhead.event))
+            updatestats();
+    }
 #if MP_THREADS_SUPPORT
     __mp_unlockmutex(MT_MAIN);
 #endif /* MP_THREADS_SUPPORT */
@@ -272,7 +312,7 @@ static
 void
 checkheap(loginfo *v, unsigned long n)
 {
-    unsigned long l;
+    unsigned long l, t;
 
     /* If the lower and upper bounds are zero then we never need to check
      * the heap.
@@ -283,7 +323,12 @@ checkheap(loginfo *v, unsigned long n)
             l = 0;
         if ((l <= n) && (n <= memhead.urange) &&
             ((memhead.check == 1) || (memhead.event % memhead.check == 0)))
+        {
+            t = __mp_starttimer(&memhead.stats);
             __mp_checkinfo(&memhead, v);
+            __mp_stoptimer(&memhead.stats, &memhead.stats.phases[LP_CHECK],
+                           t);
+        }
     }
 }
 
@@ -436,7 +481,7 @@ finishmarked(void)
                 p = 1;
             }
             if (m->data.flags & FLG_PROFILED)
-                __mp_profilefree(&memhead.prof, n->size, m,
+                __mp_profilefree(&memhead.prof, n->size, m, memhead.event,
                                  !(memhead.flags & FLG_NOPROTECT));
             if (m->data.flags & FLG_TRACED)
                 __mp_tracefree(&memhead.trace, m->data.alloc, d, NULL, NULL, 0);
@@ -530,9 +575,14 @@ __mp_init(void)
          */
         if (memhead.flags & FLG_LEAKTABLE)
             memhead.ltable.tracing = 1;
+        /* Publish the live statistics page if necessary.
+         */
+        if ((memhead.stats.file != NULL) && __mp_openstats(&memhead.stats))
+            updatestats();
         /* Finally, call any initialisation functions in the order in which
          * they were registered.
          */
+        __mp_syncinfo(&memhead);
         for (i = 0; i < memhead.initcount; i++)
         {
             memhead.inits[i]();
@@ -585,6 +635,7 @@ __mp_reinit(void)
             __mp_writeprofile(&memhead.prof, !(memhead.flags & FLG_NOPROTECT));
         memhead.prof.file = __mp_proffile(&memhead.alloc.heap.memory,
                                           "%n.%p.out");
+        memhead.prof.nextfull = memhead.prof.firstsave = memhead.prof.saves;
         /* Remove the traced flag from any existing memory allocations and then
          * change the tracing output file.
          */
@@ -597,6 +648,17 @@ __mp_reinit(void)
         __mp_changetrace(&memhead.trace,
                          __mp_tracefile(&memhead.alloc.heap.memory,
                                         "%n.%p.trace"), 0);
+        /* Detach from the live statistics page of the parent process and
+         * publish the statistics for this process in a new one.
+         */
+        if (memhead.stats.page != NULL)
+        {
+            __mp_closestats(&memhead.stats, 0);
+            memhead.stats.file = __mp_statsfile(&memhead.alloc.heap.memory,
+                                                "%n.%p");
+            if (__mp_openstats(&memhead.stats))
+                updatestats();
+        }
         if ((memhead.recur == 1) && !(memhead.flags & FLG_NOPROTECT))
             __mp_protectinfo(&memhead, MA_READONLY);
     }
@@ -637,10 +699,12 @@ __mp_fini(void)
             v.typesize = 0;
             v.logged = 0;
             __mp_checkinfo(&memhead, &v);
+            __mp_checkfreed(&memhead, &v);
             checkalloca(&v, 1);
             /* Then call any finalisation functions in the reverse order in
              * which they were registered.
              */
+            __mp_syncinfo(&memhead);
             while (memhead.finicount > 0)
             {
                 memhead.finis[--memhead.finicount]();
@@ -649,6 +713,17 @@ __mp_fini(void)
             /* Then close any access library handles that might still be open.
              */
             __mp_closesymbols(&memhead.syms);
+            /* Then merge any recently freed blocks in the free node cache into
+             * the free tree so that all free blocks are displayed correctly.
+             */
+            if (memhead.alloc.ccount > 0)
+            {
+                if (!(memhead.flags & FLG_NOPROTECT))
+                    __mp_protectinfo(&memhead, MA_READWRITE);
+                __mp_mergefree(&memhead.alloc);
+                if (!(memhead.flags & FLG_NOPROTECT))
+                    __mp_protectinfo(&memhead, MA_READONLY);
+            }
             /* Then print a summary of library statistics and settings.
              */
             __mp_printsummary(&memhead);
@@ -698,6 +773,14 @@ __mp_fini(void)
             if (memhead.prof.autocount > 0)
                 __mp_writeprofile(&memhead.prof,
                                   !(memhead.flags & FLG_NOPROTECT));
+            /* Remove the live statistics page.  Any monitoring tool that
+             * still has it mapped will see the final statistics.
+             */
+            if (memhead.stats.page != NULL)
+            {
+                updatestats();
+                __mp_closestats(&memhead.stats, 1);
+            }
             /* Finally, attempt to close the log file.
              */
             __mp_closelogfile();
@@ -772,6 +855,8 @@ MP_API
 unsigned long
 __mp_setoption(long o, unsigned long v)
 {
+    stackinfo i;
+    loginfo l;
     unsigned long r;
 
     savesignals();
@@ -784,9 +869,24 @@ __mp_setoption(long o, unsigned long v)
     else
     {
         o = -o;
+        /* Determine the call stack details in case any freed allocations
+         * that are recycled as a result of this option are corrupted.
+         */
+        __mp_newframe(&i, NULL);
+        if (__mp_getframe(&i))
+            __mp_getframe(&i);
+        l.ltype = LT_MAX;
+        l.type = AT_MAX;
+        l.func = NULL;
+        l.file = NULL;
+        l.line = 0;
+        l.stack = &i;
+        l.typestr = NULL;
+        l.typesize = 0;
+        l.logged = 0;
         if (!(memhead.flags & FLG_NOPROTECT))
             __mp_protectinfo(&memhead, MA_READWRITE);
-        if ((r = __mp_set(&memhead, (unsigned long) o, v)) &&
+        if ((r = __mp_set(&memhead, (unsigned long) o, v, &l)) &&
             (o != OPT_SETFLAGS) && (o != OPT_UNSETFLAGS))
             r = 1;
         if ((memhead.recur == 1) && !(memhead.flags & FLG_NOPROTECT))
@@ -846,6 +946,7 @@ __mp_alloc(size_t l, size_t a, alloctype f, char *s, char *t, unsigned long u,
     stackinfo i;
     loginfo v;
     int j, z;
+    unsigned long w, x;
 
 #if TARGET == TARGET_UNIX || TARGET == TARGET_WINDOWS
     /* If the C run-time library has not finished initialising then we must
@@ -869,6 +970,7 @@ __mp_alloc(size_t l, size_t a, alloctype f, char *s, char *t, unsigned long u,
         return p;
     }
 #endif /* TARGET */
+    w = __mp_starttimer(&memhead.stats);
     savesignals();
     if (!memhead.init)
         __mp_init();
@@ -876,6 +978,7 @@ __mp_alloc(size_t l, size_t a, alloctype f, char *s, char *t, unsigned long u,
         __mp_reinit();
     /* Determine the call stack details.
      */
+    x = __mp_starttimer(&memhead.stats);
     __mp_newframe(&i, NULL);
     if (__mp_getframe(&i))
     {
@@ -886,6 +989,7 @@ __mp_alloc(size_t l, size_t a, alloctype f, char *s, char *t, unsigned long u,
             k--;
         }
     }
+    __mp_stoptimer(&memhead.stats, &memhead.stats.phases[LP_STACK], x);
     /* If no filename was passed through then attempt to read any debugging
      * information to determine the source location of the call.
      */
@@ -949,6 +1053,8 @@ __mp_alloc(size_t l, size_t a, alloctype f, char *s, char *t, unsigned long u,
             __mp_abort();
         }
     }
+    if (memhead.recur == 1)
+        __mp_stoptimer(&memhead.stats, &memhead.latencies[f], w);
     restoresignals();
     return p;
 }
@@ -967,6 +1073,7 @@ __mp_strdup(char *p, size_t l, alloctype f, char *s, char *t, unsigned long u,
     loginfo v;
     size_t n;
     int j, z;
+    unsigned long w, x;
 
 #if TARGET == TARGET_UNIX || TARGET == TARGET_WINDOWS
     /* If the C run-time library has not finished initialising then we must
@@ -997,6 +1104,7 @@ __mp_strdup(char *p, size_t l, alloctype f, char *s, char *t, unsigned long u,
         return o;
     }
 #endif /* TARGET */
+    w = __mp_starttimer(&memhead.stats);
     savesignals();
     if (!memhead.init)
         __mp_init();
@@ -1004,6 +1112,7 @@ __mp_strdup(char *p, size_t l, alloctype f, char *s, char *t, unsigned long u,
         __mp_reinit();
     /* Determine the call stack details.
      */
+    x = __mp_starttimer(&memhead.stats);
     __mp_newframe(&i, NULL);
     if (__mp_getframe(&i))
     {
@@ -1014,6 +1123,7 @@ __mp_strdup(char *p, size_t l, alloctype f, char *s, char *t, unsigned long u,
             k--;
         }
     }
+    __mp_stoptimer(&memhead.stats, &memhead.stats.phases[LP_STACK], x);
     /* If no filename was passed through then attempt to read any debugging
      * information to determine the source location of the call.
      */
@@ -1090,6 +1200,8 @@ __mp_strdup(char *p, size_t l, alloctype f, char *s, char *t, unsigned long u,
             __mp_abort();
         }
     }
+    if (memhead.recur == 1)
+        __mp_stoptimer(&memhead.stats, &memhead.latencies[f], w);
     restoresignals();
     return p;
 }
@@ -1107,6 +1219,7 @@ __mp_realloc(void *p, size_t l, size_t a, alloctype f, char *s, char *t,
     stackinfo i;
     loginfo v;
     int j, z;
+    unsigned long w, x;
 
 #if TARGET == TARGET_UNIX || TARGET == TARGET_WINDOWS
     /* If the C run-time library has not finished initialising then we must
@@ -1139,6 +1252,7 @@ __mp_realloc(void *p, size_t l, size_t a, alloctype f, char *s, char *t,
         return q;
     }
 #endif /* TARGET */
+    w = __mp_starttimer(&memhead.stats);
     savesignals();
     if (!memhead.init)
         __mp_init();
@@ -1146,6 +1260,7 @@ __mp_realloc(void *p, size_t l, size_t a, alloctype f, char *s, char *t,
         __mp_reinit();
     /* Determine the call stack details.
      */
+    x = __mp_starttimer(&memhead.stats);
     __mp_newframe(&i, NULL);
     if (__mp_getframe(&i))
     {
@@ -1156,6 +1271,7 @@ __mp_realloc(void *p, size_t l, size_t a, alloctype f, char *s, char *t,
             k--;
         }
     }
+    __mp_stoptimer(&memhead.stats, &memhead.stats.phases[LP_STACK], x);
     /* If no filename was passed through then attempt to read any debugging
      * information to determine the source location of the call.
      */
@@ -1218,6 +1334,8 @@ __mp_realloc(void *p, size_t l, size_t a, alloctype f, char *s, char *t,
             __mp_abort();
         }
     }
+    if (memhead.recur == 1)
+        __mp_stoptimer(&memhead.stats, &memhead.latencies[f], w);
     restoresignals();
     return p;
 }
@@ -1233,6 +1351,7 @@ __mp_free(void *p, alloctype f, char *s, char *t, unsigned long u, size_t k)
     stackinfo i;
     loginfo v;
     int j;
+    unsigned long w, x;
 
 #if TARGET == TARGET_UNIX || TARGET == TARGET_WINDOWS
     /* If the C run-time library has not finished initialising then just
@@ -1243,6 +1362,7 @@ __mp_free(void *p, alloctype f, char *s, char *t, unsigned long u, size_t k)
     if (memhead.fini)
 #endif /* TARGET */
         return;
+    w = __mp_starttimer(&memhead.stats);
     savesignals();
     if (!memhead.init)
         __mp_init();
@@ -1250,6 +1370,7 @@ __mp_free(void *p, alloctype f, char *s, char *t, unsigned long u, size_t k)
         __mp_reinit();
     /* Determine the call stack details.
      */
+    x = __mp_starttimer(&memhead.stats);
     __mp_newframe(&i, NULL);
     if (__mp_getframe(&i))
     {
@@ -1260,6 +1381,7 @@ __mp_free(void *p, alloctype f, char *s, char *t, unsigned long u, size_t k)
             k--;
         }
     }
+    __mp_stoptimer(&memhead.stats, &memhead.stats.phases[LP_STACK], x);
     /* If no filename was passed through then attempt to read any debugging
      * information to determine the source location of the call.
      */
@@ -1292,6 +1414,8 @@ __mp_free(void *p, alloctype f, char *s, char *t, unsigned long u, size_t k)
     __mp_freememory(&memhead, p, &v);
     if (memhead.epilogue && (memhead.recur == 1))
         memhead.epilogue((void *) -1, s, t, u, i.addr);
+    if (memhead.recur == 1)
+        __mp_stoptimer(&memhead.stats, &memhead.latencies[f], w);
     restoresignals();
 }
 
@@ -1307,17 +1431,20 @@ __mp_setmem(void *p, size_t l, unsigned char c, alloctype f, char *s, char *t,
     stackinfo i;
     loginfo v;
     int j;
+    unsigned long w, x;
 
     if (!memhead.init || memhead.fini)
     {
         __mp_memset(p, c, l);
         return p;
     }
+    w = __mp_starttimer(&memhead.stats);
     savesignals();
     if (__mp_processid() != memhead.pid)
         __mp_reinit();
     /* Determine the call stack details.
      */
+    x = __mp_starttimer(&memhead.stats);
     __mp_newframe(&i, NULL);
     if (__mp_getframe(&i))
     {
@@ -1328,6 +1455,7 @@ __mp_setmem(void *p, size_t l, unsigned char c, alloctype f, char *s, char *t,
             k--;
         }
     }
+    __mp_stoptimer(&memhead.stats, &memhead.stats.phases[LP_STACK], x);
     /* If no filename was passed through then attempt to read any debugging
      * information to determine the source location of the call.
      */
@@ -1354,6 +1482,8 @@ __mp_setmem(void *p, size_t l, unsigned char c, alloctype f, char *s, char *t,
     v.logged = 0;
     checkalloca(&v, 0);
     __mp_setmemory(&memhead, p, l, c, &v);
+    if (memhead.recur == 1)
+        __mp_stoptimer(&memhead.stats, &memhead.latencies[f], w);
     restoresignals();
     return p;
 }
@@ -1371,6 +1501,7 @@ __mp_copymem(void *p, void *q, size_t l, unsigned char c, alloctype f, char *s,
     stackinfo i;
     loginfo v;
     int j;
+    unsigned long w, x;
 
     if (!memhead.init || memhead.fini)
     {
@@ -1390,11 +1521,13 @@ __mp_copymem(void *p, void *q, size_t l, unsigned char c, alloctype f, char *s,
             return q;
         }
     }
+    w = __mp_starttimer(&memhead.stats);
     savesignals();
     if (__mp_processid() != memhead.pid)
         __mp_reinit();
     /* Determine the call stack details.
      */
+    x = __mp_starttimer(&memhead.stats);
     __mp_newframe(&i, NULL);
     if (__mp_getframe(&i))
     {
@@ -1405,6 +1538,7 @@ __mp_copymem(void *p, void *q, size_t l, unsigned char c, alloctype f, char *s,
             k--;
         }
     }
+    __mp_stoptimer(&memhead.stats, &memhead.stats.phases[LP_STACK], x);
     /* If no filename was passed through then attempt to read any debugging
      * information to determine the source location of the call.
      */
@@ -1431,6 +1565,8 @@ __mp_copymem(void *p, void *q, size_t l, unsigned char c, alloctype f, char *s,
     v.logged = 0;
     checkalloca(&v, 0);
     q = __mp_copymemory(&memhead, p, q, l, c, &v);
+    if (memhead.recur == 1)
+        __mp_stoptimer(&memhead.stats, &memhead.latencies[f], w);
     restoresignals();
     return q;
 }
@@ -1449,6 +1585,7 @@ __mp_locatemem(void *p, size_t l, void *q, size_t m, alloctype f, char *s,
     loginfo v;
     int j;
     unsigned char b;
+    unsigned long w, x;
 
     if (f == AT_MEMCHR)
     {
@@ -1466,11 +1603,13 @@ __mp_locatemem(void *p, size_t l, void *q, size_t m, alloctype f, char *s,
         else
             return __mp_memfind(p, l, q, m);
     }
+    w = __mp_starttimer(&memhead.stats);
     savesignals();
     if (__mp_processid() != memhead.pid)
         __mp_reinit();
     /* Determine the call stack details.
      */
+    x = __mp_starttimer(&memhead.stats);
     __mp_newframe(&i, NULL);
     if (__mp_getframe(&i))
     {
@@ -1481,6 +1620,7 @@ __mp_locatemem(void *p, size_t l, void *q, size_t m, alloctype f, char *s,
             k--;
         }
     }
+    __mp_stoptimer(&memhead.stats, &memhead.stats.phases[LP_STACK], x);
     /* If no filename was passed through then attempt to read any debugging
      * information to determine the source location of the call.
      */
@@ -1507,6 +1647,8 @@ __mp_locatemem(void *p, size_t l, void *q, size_t m, alloctype f, char *s,
     v.logged = 0;
     checkalloca(&v, 0);
     r = __mp_locatememory(&memhead, p, l, q, m, &v);
+    if (memhead.recur == 1)
+        __mp_stoptimer(&memhead.stats, &memhead.latencies[f], w);
     restoresignals();
     return r;
 }
@@ -1524,6 +1666,7 @@ __mp_comparemem(void *p, void *q, size_t l, alloctype f, char *s, char *t,
     stackinfo i;
     loginfo v;
     int j, r;
+    unsigned long w, x;
 
     if (!memhead.init || memhead.fini)
     {
@@ -1536,11 +1679,13 @@ __mp_comparemem(void *p, void *q, size_t l, alloctype f, char *s, char *t,
         else
             return 0;
     }
+    w = __mp_starttimer(&memhead.stats);
     savesignals();
     if (__mp_processid() != memhead.pid)
         __mp_reinit();
     /* Determine the call stack details.
      */
+    x = __mp_starttimer(&memhead.stats);
     __mp_newframe(&i, NULL);
     if (__mp_getframe(&i))
     {
@@ -1551,6 +1696,7 @@ __mp_comparemem(void *p, void *q, size_t l, alloctype f, char *s, char *t,
             k--;
         }
     }
+    __mp_stoptimer(&memhead.stats, &memhead.stats.phases[LP_STACK], x);
     /* If no filename was passed through then attempt to read any debugging
      * information to determine the source location of the call.
      */
@@ -1577,6 +1723,8 @@ __mp_comparemem(void *p, void *q, size_t l, alloctype f, char *s, char *t,
     v.logged = 0;
     checkalloca(&v, 0);
     r = __mp_comparememory(&memhead, p, q, l, &v);
+    if (memhead.recur == 1)
+        __mp_stoptimer(&memhead.stats, &memhead.latencies[f], w);
     restoresignals();
     return r;
 }
@@ -2032,6 +2180,10 @@ __mp_iterate(int (*f)(void *, void *), void *d, unsigned long s)
         __mp_init();
     if (__mp_processid() != memhead.pid)
         __mp_reinit();
+    /* Ensure that the internal memory blocks are protected before calling the
+     * user-supplied function.
+     */
+    __mp_syncinfo(&memhead);
     i = 0;
     for (n = (allocnode *) memhead.alloc.list.head;
          (p = (allocnode *) n->lnode.next) != NULL; n = p)
@@ -2069,6 +2221,10 @@ __mp_iterateall(int (*f)(void *, void *), void *d)
         __mp_init();
     if (__mp_processid() != memhead.pid)
         __mp_reinit();
+    /* Ensure that the internal memory blocks are protected before calling the
+     * user-supplied function.
+     */
+    __mp_syncinfo(&memhead);
     i = 0;
     for (n = (allocnode *) memhead.alloc.list.head;
          (p = (allocnode *) n->lnode.next) != NULL; n = p)
@@ -2275,7 +2431,7 @@ __mp_stats(heapinfo *d)
         __mp_reinit();
     d->acount = memhead.alloc.atree.size;
     d->atotal = memhead.alloc.asize;
-    d->fcount = memhead.alloc.ftree.size;
+    d->fcount = memhead.alloc.ftree.size + memhead.alloc.ccount;
     d->ftotal = memhead.alloc.fsize;
     d->gcount = memhead.alloc.gtree.size;
     d->gtotal = memhead.alloc.gsize;
@@ -2283,7 +2439,7 @@ __mp_stats(heapinfo *d)
                 memhead.addr.list.size + memhead.syms.strings.list.size +
                 memhead.syms.strings.tree.size + memhead.syms.itree.size +
                 memhead.ltable.list.size + memhead.prof.ilist.size +
-                memhead.list.size + memhead.alist.size;
+                memhead.alist.size;
     d->itotal = memhead.alloc.heap.isize + memhead.alloc.isize +
                 memhead.addr.size + memhead.syms.strings.size +
                 memhead.syms.size + memhead.ltable.isize + memhead.prof.size +
@@ -2295,6 +2451,126 @@ __mp_stats(heapinfo *d)
 }
 
 
+/* Return statistics about the memory allocated and freed by each thread, in
+ * the order in which the threads were first seen.  The number of threads is
+ * returned, but no more than the specified number of entries are filled in.
+ */
+
+MP_API
+size_t
+__mp_threadstats(threadinfo *d, size_t l)
+{
+    threadnode *n;
+    size_t i;
+    unsigned long t;
+
+    savesignals();
+    if (!memhead.init)
+        __mp_init();
+    if (__mp_processid() != memhead.pid)
+        __mp_reinit();
+    t = (unsigned long) time(NULL);
+    for (n = (threadnode *) memhead.ltable.tlist.head, i = 0;
+         (n->data.node.next != NULL) && (i < l);
+         n = (threadnode *) n->data.node.next, i++)
+    {
+        d[i].id = n->data.id;
+        d[i].acount = n->data.acount;
+        d[i].atotal = n->data.atotal;
+        d[i].dcount = n->data.dcount;
+        d[i].dtotal = n->data.dtotal;
+        d[i].ucount = n->data.ucount;
+        d[i].utotal = n->data.utotal;
+        d[i].upeak = n->data.upeak;
+        d[i].rcount = n->data.rcount;
+        d[i].secs = (t > n->data.time) ? t - n->data.time : 0;
+    }
+    i = memhead.ltable.tlist.size;
+    restoresignals();
+    return i;
+}
+
+
+/* Fill in the details of a latency histogram.
+ */
+
+static
+void
+getlatency(latencyinfo *d, latency *l, char *s)
+{
+    d->name = s;
+    d->count = l->count;
+    d->total = l->total;
+    d->p50 = __mp_percentile(l, 50);
+    d->p90 = __mp_percentile(l, 90);
+    d->p99 = __mp_percentile(l, 99);
+    d->max = l->max;
+}
+
+
+/* Return the latencies of each entry point that has been called, followed by
+ * the latencies of each phase of processing within the library that has been
+ * timed.  Nothing is recorded unless the LATENCY option was used.  The number
+ * of entries is returned, but no more than the specified number of entries
+ * are filled in.
+ */
+
+MP_API
+size_t
+__mp_latencystats(latencyinfo *d, size_t l)
+{
+    size_t i, n;
+
+    savesignals();
+    if (!memhead.init)
+        __mp_init();
+    if (__mp_processid() != memhead.pid)
+        __mp_reinit();
+    for (i = n = 0; i < AT_MAX; i++)
+        if (memhead.latencies[i].count > 0)
+        {
+            if (n < l)
+                getlatency(&d[n], &memhead.latencies[i],
+                           __mp_functionnames[i]);
+            n++;
+        }
+    for (i = 0; i < LP_MAX; i++)
+        if (memhead.stats.phases[i].count > 0)
+        {
+            if (n < l)
+                getlatency(&d[n], &memhead.stats.phases[i],
+                           __mp_latencynames[i]);
+            n++;
+        }
+    restoresignals();
+    return n;
+}
+
+
+/* Return as much free memory in the heap to the system as possible.
+ */
+
+MP_API
+size_t
+__mp_trim(void)
+{
+    size_t n;
+
+    savesignals();
+    if (!memhead.init)
+        __mp_init();
+    if (__mp_processid() != memhead.pid)
+        __mp_reinit();
+    if (!(memhead.flags & FLG_NOPROTECT))
+        __mp_protectinfo(&memhead, MA_READWRITE);
+    n = __mp_trimalloc(&memhead.alloc);
+    if ((memhead.recur == 1) && !(memhead.flags & FLG_NOPROTECT))
+        __mp_protectinfo(&memhead, MA_READONLY);
+    restoresignals();
+    return n;
+}
+
+
 /* Check the validity of all memory blocks that have been filled with
  * a predefined pattern.
  */
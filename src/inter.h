@@ -108,6 +108,45 @@ typedef struct heapinfo
 heapinfo;
 
 
+/* A threadinfo structure provides statistics about the memory allocated and
+ * freed by a thread.  This must be kept up to date with the definition of
+ * __mp_threadinfo in mpatrol.h.
+ */
+
+typedef struct threadinfo
+{
+    unsigned long id;   /* thread identifier */
+    size_t acount;      /* total number of allocations */
+    size_t atotal;      /* total size of allocations */
+    size_t dcount;      /* total number of deallocations */
+    size_t dtotal;      /* total size of deallocations */
+    size_t ucount;      /* total number of unfreed allocations */
+    size_t utotal;      /* total size of unfreed allocations */
+    size_t upeak;       /* peak size of unfreed allocations */
+    size_t rcount;      /* number of allocations freed by other threads */
+    unsigned long secs; /* seconds since first allocation or deallocation */
+}
+threadinfo;
+
+
+/* A latencyinfo structure provides the latencies in nanoseconds of a library
+ * entry point or of a phase of processing within the library.  This must be
+ * kept up to date with the definition of __mp_latencyinfo in mpatrol.h.
+ */
+
+typedef struct latencyinfo
+{
+    char *name;          /* entry point or phase name */
+    unsigned long count; /* number of measurements */
+    unsigned long total; /* total time */
+    unsigned long p50;   /* median time */
+    unsigned long p90;   /* 90th percentile time */
+    unsigned long p99;   /* 99th percentile time */
+    unsigned long max;   /* maximum time */
+}
+latencyinfo;
+
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -161,6 +200,9 @@ MP_API void __mp_leaktable(size_t, int, unsigned char);
 MP_API void __mp_memorymap(int);
 MP_API void __mp_summary(void);
 MP_API int __mp_stats(heapinfo *);
+MP_API size_t __mp_threadstats(threadinfo *, size_t);
+MP_API size_t __mp_latencystats(latencyinfo *, size_t);
+MP_API size_t __mp_trim(void);
 MP_API void __mp_checkheap(char *, char *, unsigned long);
 MP_API void __mp_check(void);
 MP_API prologuehandler __mp_prologue(prologuehandler);
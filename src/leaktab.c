@@ -21,7 +21,9 @@
 /*
  * Memory leak tables.  Such tables are used by the mpatrol library to record
  * where heap memory is allocated and freed so that a summary of where memory
- * leaks occurred can be made.  The hash function comes from P. J. Weinberger's
+ * leaks occurred can be made.  The memory allocated and freed by each thread
+ * is also recorded so that it can be determined which threads are responsible
+ * for any growth in the heap.  The hash function comes from P. J. Weinberger's
  * C compiler and was published in Compilers: Principles, Techniques and Tools,
  * First Edition by Aho, Sethi and Ullman (Addison-Wesley, 1986, ISBN
  * 0-201-10194-7).
@@ -31,6 +33,7 @@
 #include "leaktab.h"
 #include "utils.h"
 #include <string.h>
+#include <time.h>
 
 
 #if MP_IDENT_SUPPORT
@@ -54,19 +57,26 @@ void
 __mp_newleaktab(leaktab *t, heaphead *h)
 {
     struct { char x; tablenode y; } z;
+    struct { char x; threadnode y; } w;
     size_t i;
     long n;
 
     t->heap = h;
     /* Determine the minimum alignment for a table node on this system and
      * force the alignment to be a power of two.  This information is used
-     * when initialising the slot table.
+     * when initialising the slot table.  Likewise for the slot table of
+     * thread nodes.
      */
     n = (char *) &z.y - &z.x;
     __mp_newslots(&t->table, sizeof(tablenode), __mp_poweroftwo(n));
+    n = (char *) &w.y - &w.x;
+    __mp_newslots(&t->ttable, sizeof(threadnode), __mp_poweroftwo(n));
     for (i = 0; i < MP_LEAKTAB_SIZE; i++)
         __mp_newlist(&t->slots[i]);
+    for (i = 0; i < MP_THREADTAB_SIZE; i++)
+        t->tslots[i] = NULL;
     __mp_newlist(&t->list);
+    __mp_newlist(&t->tlist);
     __mp_newtree(&t->tree);
     t->isize = t->size = 0;
     t->prot = MA_NOACCESS;
@@ -90,9 +100,14 @@ __mp_deleteleaktab(leaktab *t)
     t->heap = NULL;
     t->table.free = NULL;
     t->table.size = 0;
+    t->ttable.free = NULL;
+    t->ttable.size = 0;
     for (i = 0; i < MP_LEAKTAB_SIZE; i++)
         __mp_newlist(&t->slots[i]);
+    for (i = 0; i < MP_THREADTAB_SIZE; i++)
+        t->tslots[i] = NULL;
     __mp_newlist(&t->list);
+    __mp_newlist(&t->tlist);
     __mp_newtree(&t->tree);
     t->isize = t->size = 0;
     t->prot = MA_NOACCESS;
@@ -203,27 +218,8 @@ static
 tablenode *
 gettablenode(leaktab *t)
 {
-    tablenode *n;
-    heapnode *p;
-
-    /* If we have no more table node slots left then we must allocate
-     * some more memory for them.  An extra MP_ALLOCFACTOR pages of memory
-     * should suffice.
-     */
-    if ((n = (tablenode *) __mp_getslot(&t->table)) == NULL)
-    {
-        if ((p = __mp_heapalloc(t->heap, t->heap->memory.page * MP_ALLOCFACTOR,
-              t->table.entalign, 1)) == NULL)
-            return NULL;
-        __mp_initslots(&t->table, p->block, p->size);
-        n = (tablenode *) __mp_getslot(&t->table);
-        __mp_addtail(&t->list, &n->index.node);
-        n->index.block = p->block;
-        n->index.size = p->size;
-        t->isize += p->size;
-        n = (tablenode *) __mp_getslot(&t->table);
-    }
-    return n;
+    return (tablenode *) __mp_heapslot(t->heap, &t->table, &t->list,
+                                       &t->isize);
 }
 
 
@@ -287,6 +283,98 @@ __mp_freeentry(leaktab *t, char *f, unsigned long l, size_t c)
 }
 
 
+/* Allocate a new thread node.
+ */
+
+static
+threadnode *
+getthreadnode(leaktab *t)
+{
+    return (threadnode *) __mp_heapslot(t->heap, &t->ttable, &t->list,
+                                        &t->isize);
+}
+
+
+/* Locate the thread node for a particular thread, creating a new one if
+ * necessary.  Thread identifiers are often addresses, so the low bits are
+ * mixed with the higher bits before choosing a hash bucket.
+ */
+
+static
+threadnode *
+findthread(leaktab *t, unsigned long i)
+{
+    threadnode *n;
+    unsigned long k;
+
+    k = (i ^ (i >> 12)) % MP_THREADTAB_SIZE;
+    for (n = t->tslots[k]; n != NULL; n = n->data.next)
+        if (n->data.id == i)
+            return n;
+    if ((n = getthreadnode(t)) == NULL)
+        return NULL;
+    __mp_addtail(&t->tlist, &n->data.node);
+    n->data.next = t->tslots[k];
+    t->tslots[k] = n;
+    n->data.id = i;
+    n->data.time = (unsigned long) time(NULL);
+    n->data.acount = n->data.atotal = 0;
+    n->data.dcount = n->data.dtotal = 0;
+    n->data.ucount = n->data.utotal = n->data.upeak = 0;
+    n->data.rcount = 0;
+    return n;
+}
+
+
+/* Record a memory allocation made by a particular thread.
+ */
+
+MP_GLOBAL
+int
+__mp_allocthread(leaktab *t, unsigned long i, size_t l)
+{
+    threadnode *n;
+
+    if ((n = findthread(t, i)) == NULL)
+        return 0;
+    n->data.acount++;
+    n->data.atotal += l;
+    n->data.ucount++;
+    n->data.utotal += l;
+    if (n->data.upeak < n->data.utotal)
+        n->data.upeak = n->data.utotal;
+    return 1;
+}
+
+
+/* Record a memory deallocation made by a particular thread of memory that
+ * was allocated by a possibly different thread.
+ */
+
+MP_GLOBAL
+int
+__mp_freethread(leaktab *t, unsigned long i, unsigned long o, size_t l)
+{
+    threadnode *n;
+
+    if ((n = findthread(t, i)) == NULL)
+        return 0;
+    n->data.dcount++;
+    n->data.dtotal += l;
+    if ((i != o) && ((n = findthread(t, o)) == NULL))
+        return 0;
+    if (n->data.ucount > 0)
+        n->data.ucount--;
+    if (n->data.utotal > l)
+        n->data.utotal -= l;
+    else
+        n->data.utotal = 0;
+    if (i != o)
+        n->data.rcount++;
+    return 1;
+}
+
+
 /* Protect the memory blocks used by the leak table with the supplied access
  * permission.
  */
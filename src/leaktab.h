@@ -74,15 +74,53 @@ typedef union tablenode
 tablenode;
 
 
-/* A leaktab holds the hash table of table nodes.
+/* A threadnode belongs to a hash table of thread nodes and contains an
+ * allocation summary for a particular thread.  The unfreed memory is that
+ * which was allocated by the thread, regardless of which thread frees it.
+ */
+
+typedef union threadnode
+{
+    struct
+    {
+        listnode node;           /* internal list node */
+        void *block;             /* pointer to block of memory */
+        size_t size;             /* size of block of memory */
+    }
+    index;
+    struct
+    {
+        listnode node;           /* list node */
+        union threadnode *next;  /* next node in hash bucket */
+        unsigned long id;        /* thread identifier */
+        unsigned long time;      /* time of first allocation or deallocation */
+        size_t acount;           /* allocation count */
+        size_t atotal;           /* allocation total */
+        size_t dcount;           /* deallocation count */
+        size_t dtotal;           /* deallocation total */
+        size_t ucount;           /* unfreed count */
+        size_t utotal;           /* unfreed total */
+        size_t upeak;            /* unfreed peak */
+        size_t rcount;           /* unfreed count freed by other threads */
+    }
+    data;
+}
+threadnode;
+
+
+/* A leaktab holds the hash table of table nodes and the hash table of
+ * thread nodes.
  */
 
 typedef struct leaktab
 {
     heaphead *heap;                  /* pointer to heap */
     slottable table;                 /* table of table nodes */
+    slottable ttable;                /* table of thread nodes */
     listhead slots[MP_LEAKTAB_SIZE]; /* array of lists for table nodes */
+    threadnode *tslots[MP_THREADTAB_SIZE]; /* hash table of thread nodes */
     listhead list;                   /* internal list of memory blocks */
+    listhead tlist;                  /* list of thread nodes */
     treeroot tree;                   /* tree for sorting */
     size_t isize;                    /* memory used by internal blocks */
     size_t size;                     /* number of nodes in table */
@@ -105,6 +143,8 @@ MP_EXPORT void __mp_clearleaktab(leaktab *);
 MP_EXPORT void __mp_sortleaktab(leaktab *, int, int);
 MP_EXPORT int __mp_allocentry(leaktab *, char *, unsigned long, size_t);
 MP_EXPORT int __mp_freeentry(leaktab *, char *, unsigned long, size_t);
+MP_EXPORT int __mp_allocthread(leaktab *, unsigned long, size_t);
+MP_EXPORT int __mp_freethread(leaktab *, unsigned long, unsigned long, size_t);
 MP_EXPORT int __mp_protectleaktab(leaktab *, memaccess);
 
 
@@ -53,8 +53,10 @@
 #endif
 #endif /* MP_SIGINFO_SUPPORT */
 #include <fcntl.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/time.h>
 #if SYSTEM == SYSTEM_FREEBSD || SYSTEM == SYSTEM_INTERIX || \
     SYSTEM == SYSTEM_NETBSD || SYSTEM == SYSTEM_OPENBSD
 #ifndef MAP_ANONYMOUS
@@ -445,7 +447,14 @@ __mp_newmemory(memoryinfo *i)
 #else /* MP_WATCH_SUPPORT */
     i->wfile = -1;
 #endif /* MP_WATCH_SUPPORT */
+    i->arena = NULL;
+    i->asize = i->atop = i->amax = i->aused = 0;
+    i->hbase = NULL;
+    i->hsize = 0;
+    i->nranges = 0;
+    i->prot = MA_READWRITE;
     i->flags = 0;
+    i->batch = 0;
 }
 
 
@@ -472,6 +481,14 @@ __mp_endmemory(memoryinfo *i)
         i->wfile = -1;
     }
 #endif /* MP_WATCH_SUPPORT */
+#if MP_ARENA_SUPPORT
+    if (i->arena != NULL)
+    {
+        munmap(i->arena, i->asize);
+        i->arena = NULL;
+        i->asize = i->atop = i->amax = i->aused = 0;
+    }
+#endif /* MP_ARENA_SUPPORT */
 }
 
 
@@ -497,6 +514,50 @@ __mp_processid(void)
 }
 
 
+/* Return the current value of a high resolution clock in nanoseconds.  The
+ * value is only meaningful when compared with another value returned by this
+ * function, and zero is returned if there is no suitable clock.  The value
+ * wraps around every few seconds if an unsigned long is only 32 bits wide, so
+ * the difference between two values must be calculated with unsigned
+ * arithmetic.
+ */
+
+MP_GLOBAL
+unsigned long
+__mp_timestamp(void)
+{
+#if TARGET == TARGET_UNIX
+#ifdef CLOCK_MONOTONIC
+    struct timespec t;
+#endif /* CLOCK_MONOTONIC */
+    struct timeval v;
+
+#ifdef CLOCK_MONOTONIC
+    if (clock_gettime(CLOCK_MONOTONIC, &t) == 0)
+        return (unsigned long) t.tv_sec * 1000000000UL +
+               (unsigned long) t.tv_nsec;
+#endif /* CLOCK_MONOTONIC */
+    if (gettimeofday(&v, NULL) == 0)
+        return (unsigned long) v.tv_sec * 1000000000UL +
+               (unsigned long) v.tv_usec * 1000UL;
+    return 0;
+#elif TARGET == TARGET_WINDOWS
+    static LARGE_INTEGER f;
+    LARGE_INTEGER c;
+
+    if ((f.QuadPart == 0) && !QueryPerformanceFrequency(&f))
+        return 0;
+    if (!QueryPerformanceCounter(&c))
+        return 0;
+    return (unsigned long) ((c.QuadPart / f.QuadPart) * 1000000000 +
+                            (c.QuadPart % f.QuadPart) * 1000000000 /
+                            f.QuadPart);
+#else /* TARGET */
+    return 0;
+#endif /* TARGET */
+}
+
+
 #if MP_ARRAY_SUPPORT
 /* Provide sbrk()-like functionality for systems that have no system functions
  * for allocating heap memory.  The simulated heap grows upwards in this
@@ -527,6 +588,136 @@ getmemory(long l)
 #endif /* MP_ARRAY_SUPPORT && TARGET */
 
 
+#if MP_ARENA_SUPPORT
+/* Allocate a block of internal memory from the internal memory arena,
+ * reserving the arena if this is the first internal memory block.  This
+ * returns NULL if the arena could not be reserved or is full.
+ */
+
+static
+void *
+arenaalloc(memoryinfo *i, size_t l)
+{
+    char *p;
+    int f;
+
+    if (i->arena == NULL)
+    {
+        if (i->flags & FLG_NOARENA)
+            return NULL;
+        /* The arena is reserved without any access permissions so that none
+         * of its pages are committed until they are allocated.
+         */
+        f = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+        f |= MAP_NORESERVE;
+#endif /* MAP_NORESERVE */
+        if ((p = (char *) mmap(NULL, MP_ARENA_SIZE, PROT_NONE, f, -1, 0)) ==
+            (char *) MAP_FAILED)
+        {
+            i->flags |= FLG_NOARENA;
+            return NULL;
+        }
+        i->arena = p;
+        i->asize = MP_ARENA_SIZE;
+    }
+    if (l > i->asize - i->atop)
+        return NULL;
+    p = i->arena + i->atop;
+    if (mprotect(p, l, PROT_READ | PROT_WRITE) == -1)
+        return NULL;
+    /* Pages that were previously allocated from the arena and then freed are
+     * not guaranteed to be zero-filled on all systems.
+     */
+    if (i->atop < i->amax)
+        __mp_memset(p, 0, (i->amax - i->atop < l) ? i->amax - i->atop : l);
+    i->atop += l;
+    i->aused += l;
+    if (i->amax < i->atop)
+        i->amax = i->atop;
+    return p;
+}
+
+
+/* Return a block of internal memory to the internal memory arena.  The pages
+ * are made inaccessible and their contents discarded, but the address space
+ * is only reused if the block was the last one to be allocated.
+ */
+
+static
+void
+arenafree(memoryinfo *i, char *p, size_t l)
+{
+    mprotect(p, l, PROT_NONE);
+#ifdef MADV_DONTNEED
+    madvise(p, l, MADV_DONTNEED);
+#endif /* MADV_DONTNEED */
+    i->aused -= l;
+    if (p + l == i->arena + i->atop)
+        i->atop = p - i->arena;
+}
+#endif /* MP_ARENA_SUPPORT */
+
+
+#if MP_HUGEPAGE_SUPPORT
+/* Allocate a region of user memory that is aligned to the size of a huge page
+ * and advise the system to back it with transparent huge pages.  We first try
+ * to place the region directly below or above the previous one so that they
+ * can be merged by the heap manager.  This returns NULL if the region could
+ * not be mapped.
+ */
+
+static
+void *
+hugealloc(memoryinfo *i, size_t *l)
+{
+    char *a[2];
+    char *p, *q;
+    size_t j, n, s;
+
+    n = __mp_roundup(*l, MP_HUGEPAGE_SIZE);
+    p = (char *) MAP_FAILED;
+    if (i->hbase != NULL)
+    {
+        a[0] = ((unsigned long) i->hbase > n) ? i->hbase - n : NULL;
+        a[1] = i->hbase + i->hsize;
+        for (j = 0; (j < 2) && (p == (char *) MAP_FAILED); j++)
+            if ((a[j] != NULL) &&
+                ((p = (char *) mmap(a[j], n, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) !=
+                 (char *) MAP_FAILED) && (p != a[j]))
+            {
+                munmap(p, n);
+                p = (char *) MAP_FAILED;
+            }
+    }
+    if (p == (char *) MAP_FAILED)
+    {
+        /* Map enough extra memory to be able to align the region and then
+         * unmap the pages on either side of it.
+         */
+        s = n + MP_HUGEPAGE_SIZE - i->page;
+        if ((p = (char *) mmap(NULL, s, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == (char *) MAP_FAILED)
+            return NULL;
+        q = (char *) __mp_roundup((unsigned long) p, MP_HUGEPAGE_SIZE);
+        if (q > p)
+            munmap(p, q - p);
+        if (q + n < p + s)
+            munmap(q + n, (p + s) - (q + n));
+        p = q;
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(p, n, MADV_HUGEPAGE);
+#endif /* MADV_HUGEPAGE */
+    i->hbase = p;
+    i->hsize = n;
+    *l = n;
+    return p;
+}
+#endif /* MP_HUGEPAGE_SUPPORT */
+
+
 /* Allocate a specified size of general-purpose memory from the system
  * with a required alignment.
  */
@@ -564,6 +755,21 @@ __mp_memalloc(memoryinfo *i, size_t *l, size_t a, int u)
     if (a > MEM_BLOCKSIZE)
         *l += __mp_poweroftwo(a) - MEM_BLOCKSIZE;
 #endif /* MP_ARRAY_SUPPORT && TARGET */
+#if MP_ARENA_SUPPORT
+    /* Internal memory is allocated from the internal memory arena if there is
+     * enough room left in it.
+     */
+    if ((u == 0) && ((p = arenaalloc(i, *l)) != NULL))
+        return p;
+#endif /* MP_ARENA_SUPPORT */
+#if MP_HUGEPAGE_SUPPORT
+    /* User memory is allocated in regions of huge pages if they have been
+     * requested, otherwise we fall back to allocating it in the usual way.
+     */
+    if ((u != 0) && (i->flags & FLG_HUGEPAGES) &&
+        ((p = hugealloc(i, l)) != NULL))
+        return p;
+#endif /* MP_HUGEPAGE_SUPPORT */
 #if MP_ARRAY_SUPPORT || TARGET == TARGET_UNIX
     /* UNIX has a contiguous heap for a process, but we are not guaranteed to
      * have full control over it, so we must assume that each separate memory
@@ -688,6 +894,15 @@ __mp_memfree(memoryinfo *i, void *p, size_t l)
     TARGET == TARGET_NETWARE
     t = (void *) __mp_rounddown((unsigned long) p, i->page);
 #endif /* TARGET */
+#if MP_ARENA_SUPPORT
+    if ((i->arena != NULL) && ((char *) t >= i->arena) &&
+        ((char *) t < i->arena + i->asize))
+    {
+        arenafree(i, (char *) t, __mp_roundup(l + ((char *) p - (char *) t),
+                                               i->page));
+        return;
+    }
+#endif /* MP_ARENA_SUPPORT */
 #if TARGET == TARGET_UNIX
     /* If we used sbrk() to allocate this memory then we can't shrink the
      * break point since someone else might have allocated memory in between
@@ -710,6 +925,42 @@ __mp_memfree(memoryinfo *i, void *p, size_t l)
 }
 
 
+/* Return the number of bytes of the internal memory arena that are resident
+ * in physical memory.
+ */
+
+MP_GLOBAL
+size_t
+__mp_arenaresident(memoryinfo *i)
+{
+#if MP_ARENA_SUPPORT
+#if SYSTEM == SYSTEM_LINUX || SYSTEM == SYSTEM_ANDROID
+    unsigned char v[256];
+#else /* SYSTEM */
+    char v[256];
+#endif /* SYSTEM */
+    size_t j, k, l, n;
+
+    n = 0;
+    if (i->arena == NULL)
+        return 0;
+    for (j = 0; j < i->amax; j += l)
+    {
+        if ((l = i->amax - j) > sizeof(v) * i->page)
+            l = sizeof(v) * i->page;
+        if (mincore(i->arena + j, l, v) == -1)
+            return i->aused;
+        for (k = 0; k < l / i->page; k++)
+            if (v[k] & 1)
+                n += i->page;
+    }
+    return n;
+#else /* MP_ARENA_SUPPORT */
+    return 0;
+#endif /* MP_ARENA_SUPPORT */
+}
+
+
 #if TARGET == TARGET_UNIX
 /* Handles any signals that result from illegal memory accesses whilst
  * querying the permissions of addresses.
@@ -799,23 +1050,16 @@ __mp_memquery(memoryinfo *i, void *p)
 }
 
 
-/* Protect a block of allocated memory with the supplied access permission.
+#if TARGET == TARGET_UNIX || TARGET == TARGET_WINDOWS
+/* Change the access permission of a range of pages.
  */
 
-MP_GLOBAL
+static
 int
-__mp_memprotect(memoryinfo *i, void *p, size_t l, memaccess a)
+protectpages(void *t, size_t l, memaccess a)
 {
-#if TARGET == TARGET_UNIX || TARGET == TARGET_WINDOWS
-    void *t;
     int n;
-#endif /* TARGET */
 
-#if TARGET == TARGET_UNIX || TARGET == TARGET_WINDOWS
-    if (l == 0)
-        return 1;
-    t = (void *) __mp_rounddown((unsigned long) p, i->page);
-    l = __mp_roundup(l + ((char *) p - (char *) t), i->page);
 #if TARGET == TARGET_UNIX
     if (a == MA_NOACCESS)
         n = PROT_NONE;
@@ -835,8 +1079,127 @@ __mp_memprotect(memoryinfo *i, void *p, size_t l, memaccess a)
     if (!VirtualProtect(t, l, n, (unsigned long *) &n))
         return 0;
 #endif /* TARGET */
+    return 1;
+}
+
+
+/* Change the access permission of all of the pending page ranges.
+ */
+
+static
+int
+flushranges(memoryinfo *i)
+{
+    size_t j;
+    int r;
+
+    for (j = 0, r = 1; j < i->nranges; j++)
+        if (!protectpages(i->ranges[j].block, i->ranges[j].size, i->prot))
+            r = 0;
+    i->nranges = 0;
+    return r;
+}
+
+
+/* Add a range of pages to the pending page ranges, merging it with any
+ * ranges that it overlaps or adjoins.
+ */
+
+static
+int
+addrange(memoryinfo *i, char *p, size_t l, memaccess a)
+{
+    protrange *r;
+    char *e;
+    size_t j;
+
+    if ((i->nranges > 0) && (i->prot != a) && !flushranges(i))
+        return 0;
+    i->prot = a;
+    /* Since a merged range may now adjoin a range that was already checked,
+     * we start again from the beginning every time a range is merged.
+     */
+    j = 0;
+    while (j < i->nranges)
+    {
+        r = &i->ranges[j];
+        if ((p <= r->block + r->size) && (r->block <= p + l))
+        {
+            if ((e = p + l) < r->block + r->size)
+                e = r->block + r->size;
+            if (p > r->block)
+                p = r->block;
+            l = e - p;
+            *r = i->ranges[--i->nranges];
+            j = 0;
+        }
+        else
+            j++;
+    }
+    if ((i->nranges == MP_PROTRANGE_SIZE) && !flushranges(i))
+        return 0;
+    i->ranges[i->nranges].block = p;
+    i->ranges[i->nranges].size = l;
+    i->nranges++;
+    return 1;
+}
+#endif /* TARGET */
+
+
+/* Protect a block of allocated memory with the supplied access permission.
+ * If protection requests are being batched then the change is deferred until
+ * the batch ends.
+ */
+
+MP_GLOBAL
+int
+__mp_memprotect(memoryinfo *i, void *p, size_t l, memaccess a)
+{
+#if TARGET == TARGET_UNIX || TARGET == TARGET_WINDOWS
+    void *t;
 #endif /* TARGET */
+
+#if TARGET == TARGET_UNIX || TARGET == TARGET_WINDOWS
+    if (l == 0)
+        return 1;
+    t = (void *) __mp_rounddown((unsigned long) p, i->page);
+    l = __mp_roundup(l + ((char *) p - (char *) t), i->page);
+    if (i->batch)
+        return addrange(i, (char *) t, l, a);
+    return protectpages(t, l, a);
+#else /* TARGET */
     return 1;
+#endif /* TARGET */
+}
+
+
+/* Start batching protection requests so that the protection of adjacent
+ * memory blocks can be changed with a single system call.
+ */
+
+MP_GLOBAL
+void
+__mp_startprotect(memoryinfo *i)
+{
+    i->nranges = 0;
+    i->batch = 1;
+}
+
+
+/* Stop batching protection requests and change the protection of all of the
+ * memory blocks that were requested since the batch started.
+ */
+
+MP_GLOBAL
+int
+__mp_endprotect(memoryinfo *i)
+{
+    i->batch = 0;
+#if TARGET == TARGET_UNIX || TARGET == TARGET_WINDOWS
+    return flushranges(i);
+#else /* TARGET */
+    return 1;
+#endif /* TARGET */
 }
 
 
@@ -894,6 +1257,119 @@ __mp_memwatch(memoryinfo *i, void *p, size_t l, memaccess a)
 }
 
 
+/* Fill a block of memory with a specific byte, but discard the contents of
+ * any whole pages within it so that they no longer occupy physical memory.
+ * Each discarded page will then contain either the specific byte or zero
+ * bytes throughout, depending on the system.
+ */
+
+MP_GLOBAL
+void
+__mp_memdiscard(memoryinfo *i, void *p, size_t l, char c)
+{
+    char *b, *e;
+
+    b = (char *) __mp_roundup((unsigned long) p, i->page);
+    e = (char *) __mp_rounddown((unsigned long) p + l, i->page);
+    if (b >= e)
+    {
+        __mp_memset(p, c, l);
+        return;
+    }
+    __mp_memset(p, c, b - (char *) p);
+    __mp_memset(e, c, (char *) p + l - e);
+#if TARGET == TARGET_UNIX
+#if (SYSTEM == SYSTEM_ANDROID || SYSTEM == SYSTEM_LINUX) && \
+    defined(MADV_DONTNEED)
+    /* Private pages are guaranteed to be zero-filled the next time they are
+     * accessed after being discarded on Linux, so there is no need to fill
+     * them first.
+     */
+    if (madvise(b, e - b, MADV_DONTNEED) == 0)
+        return;
+#endif /* SYSTEM && MADV_DONTNEED */
+    __mp_memset(b, c, e - b);
+#ifdef MADV_FREE
+    madvise(b, e - b, MADV_FREE);
+#endif /* MADV_FREE */
+#else /* TARGET */
+    __mp_memset(b, c, e - b);
+#endif /* TARGET */
+}
+
+
+/* Fill in a vector indicating which of the pages in a page-aligned block of
+ * memory are resident in physical memory, or return 0 if this cannot be
+ * determined.  The vector must contain an entry for each page.
+ */
+
+static
+int
+pagesresident(memoryinfo *i, void *p, size_t n, char *v)
+{
+#if TARGET == TARGET_UNIX
+#if SYSTEM == SYSTEM_ANDROID || SYSTEM == SYSTEM_LINUX
+    return (mincore(p, n * i->page, (unsigned char *) v) == 0);
+#elif MP_MINCORE_SUPPORT
+    return (mincore(p, n * i->page, v) == 0);
+#endif /* SYSTEM && MP_MINCORE_SUPPORT */
+#endif /* TARGET */
+    return 0;
+}
+
+
+/* Return any whole pages within a block of memory to the system so that they
+ * no longer occupy physical memory, but leave the block of memory mapped.  Each
+ * returned page will then contain either its original contents or zero bytes
+ * throughout, depending on the system.  The number of bytes that were resident
+ * before they were returned is itself returned, if that can be determined.
+ */
+
+MP_GLOBAL
+size_t
+__mp_memtrim(memoryinfo *i, void *p, size_t l)
+{
+#if TARGET == TARGET_UNIX
+    char v[256];
+    char *b, *e, *q;
+    size_t k, n, r;
+
+    b = (char *) __mp_roundup((unsigned long) p, i->page);
+    e = (char *) __mp_rounddown((unsigned long) p + l, i->page);
+    if (b >= e)
+        return 0;
+    /* Only pages that are currently resident are counted so that pages which
+     * were returned by an earlier call are not counted again.
+     */
+    for (q = b, r = 0; q < e; q += n * i->page)
+    {
+        if ((n = (e - q) / i->page) > sizeof(v))
+            n = sizeof(v);
+        if (!pagesresident(i, q, n, v))
+        {
+            r += e - q;
+            break;
+        }
+        for (k = 0; k < n; k++)
+            if (v[k] & 1)
+                r += i->page;
+    }
+    if (r == 0)
+        return 0;
+#if (SYSTEM == SYSTEM_ANDROID || SYSTEM == SYSTEM_LINUX) && \
+    defined(MADV_DONTNEED)
+    if (madvise(b, e - b, MADV_DONTNEED) == 0)
+        return r;
+#endif /* SYSTEM && MADV_DONTNEED */
+#ifdef MADV_FREE
+    if (madvise(b, e - b, MADV_FREE) == 0)
+        return r;
+#endif /* MADV_FREE */
+#endif /* TARGET */
+    return 0;
+}
+
+
 /* Check that a block of memory only contains a specific byte.
  */
 
@@ -963,6 +1439,71 @@ __mp_memcheck(void *t, char c, size_t l)
 }
 
 
+/* Check that a block of memory only contains a specific byte, except that
+ * any whole pages within it may instead contain only zero bytes if they were
+ * discarded with __mp_memdiscard().
+ */
+
+MP_GLOBAL
+void *
+__mp_memcheckpages(memoryinfo *i, void *p, size_t l, char c)
+{
+    char *b, *e, *q;
+    void *r;
+
+    b = (char *) __mp_roundup((unsigned long) p, i->page);
+    e = (char *) __mp_rounddown((unsigned long) p + l, i->page);
+    if (b >= e)
+        return __mp_memcheck(p, c, l);
+    if ((r = __mp_memcheck(p, c, b - (char *) p)) != NULL)
+        return r;
+    for (q = b; q < e; q += i->page)
+        if ((r = __mp_memcheck(q, (*q == '\0') ? '\0' : c, i->page)) != NULL)
+            return r;
+    return __mp_memcheck(e, c, (char *) p + l - e);
+}
+
+
+/* Check that a block of memory only contains a specific byte, except that any
+ * whole pages within it that are not resident in physical memory are skipped
+ * since they may have been returned to the system with __mp_memtrim().  Such
+ * pages are never examined so that they are not brought back into physical
+ * memory.
+ */
+
+MP_GLOBAL
+void *
+__mp_memcheckresident(memoryinfo *i, void *p, size_t l, char c)
+{
+    char v[256];
+    char *b, *e, *q;
+    void *r;
+    size_t k, n;
+
+    b = (char *) __mp_roundup((unsigned long) p, i->page);
+    e = (char *) __mp_rounddown((unsigned long) p + l, i->page);
+    if (b >= e)
+        return __mp_memcheck(p, c, l);
+    if ((r = __mp_memcheck(p, c, b - (char *) p)) != NULL)
+        return r;
+    for (q = b; q < e; q += n * i->page)
+    {
+        if ((n = (e - q) / i->page) > sizeof(v))
+            n = sizeof(v);
+        /* If we cannot tell which pages are resident then the pages that were
+         * returned to the system might contain zero bytes instead.
+         */
+        if (!pagesresident(i, q, n, v))
+            return __mp_memcheckpages(i, q, (char *) p + l - q, c);
+        for (k = 0; k < n; k++)
+            if ((v[k] & 1) && ((r = __mp_memcheckpages(i, q + k * i->page,
+                  i->page, c)) != NULL))
+                return r;
+    }
+    return __mp_memcheck(e, c, (char *) p + l - e);
+}
+
+
 /* Compare two blocks of memory.
  */
 
@@ -1221,6 +1762,54 @@ __mp_memcopy(void *t, void *s, size_t l)
 }
 
 
+/* Copy a block of memory from one address to another, moving any whole pages
+ * within it rather than copying them if the two addresses have the same
+ * offset within a page.  The moved pages are replaced with zero-filled pages
+ * at the old address so that it still refers to accessible memory.  The two
+ * blocks of memory must not overlap.
+ */
+
+MP_GLOBAL
+void
+__mp_memremap(memoryinfo *i, void *t, void *s, size_t l)
+{
+#if MP_MREMAP_SUPPORT && defined(MREMAP_FIXED)
+    char *b, *e, *p;
+
+    if ((l >= MP_MREMAP_SIZE) &&
+        ((((unsigned long) t ^ (unsigned long) s) & (i->page - 1)) == 0))
+    {
+        b = (char *) __mp_roundup((unsigned long) s, i->page);
+        e = (char *) __mp_rounddown((unsigned long) s + l, i->page);
+        p = (char *) t + (b - (char *) s);
+        /* The destination pages are discarded by mremap() and the source pages
+         * are left unmapped, so they must be mapped again before anything else
+         * can be placed there.  If that fails then the pages are moved back
+         * and the destination pages are mapped again instead.
+         */
+        if ((b < e) && (mremap(b, e - b, e - b, MREMAP_MAYMOVE | MREMAP_FIXED,
+              p) != (void *) MAP_FAILED))
+        {
+            if (mmap(b, e - b, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) ==
+                (void *) MAP_FAILED)
+            {
+                mremap(p, e - b, e - b, MREMAP_MAYMOVE | MREMAP_FIXED, b);
+                mmap(p, e - b, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+                __mp_memcopy(t, s, l);
+                return;
+            }
+            __mp_memcopy(t, s, b - (char *) s);
+            __mp_memcopy(p + (e - b), e, (char *) s + l - e);
+            return;
+        }
+    }
+#endif /* MP_MREMAP_SUPPORT && MREMAP_FIXED */
+    __mp_memcopy(t, s, l);
+}
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -40,6 +40,8 @@
 
 
 #define FLG_USEMMAP 1 /* use mmap() to allocate user memory */
+#define FLG_NOARENA 2 /* internal memory arena could not be reserved */
+#define FLG_HUGEPAGES 4 /* use transparent huge pages for user memory */
 
 
 /* The different types of memory access permissions.
@@ -54,19 +56,42 @@ typedef enum memaccess
 memaccess;
 
 
+/* A protrange describes a range of pages whose access permission is waiting
+ * to be changed.
+ */
+
+typedef struct protrange
+{
+    char *block; /* pointer to first page */
+    size_t size; /* size of pages */
+}
+protrange;
+
+
 /* A memoryinfo structure contains details about the underlying memory
  * architecture.
  */
 
 typedef struct memoryinfo
 {
-    size_t align;        /* most restrictive alignment */
-    size_t page;         /* system page size */
-    int stackdir;        /* stack direction */
-    char *prog;          /* program filename */
-    int mfile;           /* memory mapped file handle */
-    int wfile;           /* watch point control file handle */
-    unsigned char flags; /* control flags */
+    size_t align;                        /* most restrictive alignment */
+    size_t page;                         /* system page size */
+    int stackdir;                        /* stack direction */
+    char *prog;                          /* program filename */
+    int mfile;                           /* memory mapped file handle */
+    int wfile;                           /* watch point control file handle */
+    char *arena;                         /* internal memory arena */
+    size_t asize;                        /* size of internal memory arena */
+    size_t atop;                         /* top of allocated arena memory */
+    size_t amax;                         /* highest top of arena memory */
+    size_t aused;                        /* allocated arena memory */
+    char *hbase;                         /* last huge page region */
+    size_t hsize;                        /* size of last huge page region */
+    protrange ranges[MP_PROTRANGE_SIZE]; /* pending protection ranges */
+    size_t nranges;                      /* number of pending ranges */
+    memaccess prot;                      /* pending protection status */
+    unsigned char flags;                 /* control flags */
+    char batch;                          /* protection batching flag */
 }
 memoryinfo;
 
@@ -80,16 +105,25 @@ extern "C"
 MP_EXPORT void __mp_newmemory(memoryinfo *);
 MP_EXPORT void __mp_endmemory(memoryinfo *);
 MP_EXPORT unsigned long __mp_processid(void);
+MP_EXPORT unsigned long __mp_timestamp(void);
 MP_EXPORT void *__mp_memalloc(memoryinfo *, size_t *, size_t, int);
 MP_EXPORT void __mp_memfree(memoryinfo *, void *, size_t);
+MP_EXPORT size_t __mp_arenaresident(memoryinfo *);
 MP_EXPORT memaccess __mp_memquery(memoryinfo *, void *);
 MP_EXPORT int __mp_memprotect(memoryinfo *, void *, size_t, memaccess);
+MP_EXPORT void __mp_startprotect(memoryinfo *);
+MP_EXPORT int __mp_endprotect(memoryinfo *);
 MP_EXPORT int __mp_memwatch(memoryinfo *, void *, size_t, memaccess);
+MP_EXPORT void __mp_memdiscard(memoryinfo *, void *, size_t, char);
+MP_EXPORT size_t __mp_memtrim(memoryinfo *, void *, size_t);
 MP_EXPORT void *__mp_memcheck(void *, char, size_t);
+MP_EXPORT void *__mp_memcheckpages(memoryinfo *, void *, size_t, char);
+MP_EXPORT void *__mp_memcheckresident(memoryinfo *, void *, size_t, char);
 MP_EXPORT void *__mp_memcompare(void *, void *, size_t);
 MP_EXPORT void *__mp_memfind(void *, size_t, void *, size_t);
 MP_EXPORT void __mp_memset(void *, char, size_t);
 MP_EXPORT void __mp_memcopy(void *, void *, size_t);
+MP_EXPORT void __mp_memremap(memoryinfo *, void *, void *, size_t);
 
 
 #ifdef __cplusplus
@@ -30,8 +30,10 @@
  */
 
 
-#include "tree.h"
+#include "hash.h"
+#include "slots.h"
 #include "getopt.h"
+#include "utils.h"
 #include "version.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -67,7 +69,7 @@ options_flags;
 
 typedef struct allocation
 {
-    treenode node;        /* tree node */
+    unsigned long index;  /* allocation index */
     unsigned long addr;   /* allocation address */
     unsigned long size;   /* allocation size */
     unsigned long offset; /* log file offset */
@@ -75,10 +77,19 @@ typedef struct allocation
 allocation;
 
 
-/* The tree containing information about each memory allocation.
+/* The hash table containing information about each memory allocation,
+ * keyed by allocation index.
  */
 
-static treeroot alloctree;
+static hashtable alloctable;
+
+
+/* The slot table from which allocation records are obtained, and the chain
+ * of memory blocks that have been allocated for it.
+ */
+
+static slottable allocslots;
+static void *allocblocks;
 
 
 /* The total number of bytes currently allocated.
@@ -136,6 +147,25 @@ static option options_table[] =
 };
 
 
+/* Allocate memory for a new block of allocation records or a larger
+ * allocation hash table, exiting if there is not enough memory.
+ */
+
+static
+void *
+getmemory(size_t l)
+{
+    void *p;
+
+    if ((p = malloc(l)) == NULL)
+    {
+        fprintf(stderr, "%s: Out of memory\n", progname);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+
 /* Create a new memory allocation and record its log file offset.
  */
 
@@ -144,13 +174,35 @@ void
 newalloc(unsigned long i, unsigned long a, unsigned long l, unsigned long o)
 {
     allocation *n;
+    void *p;
+    size_t s;
 
-    if ((n = (allocation *) malloc(sizeof(allocation))) == NULL)
+    /* If an allocation with the same index has already been recorded then
+     * its details are simply replaced.
+     */
+    if ((n = (allocation *) __mp_hashsearch(&alloctable, i)) != NULL)
+        alloctotal -= n->size;
+    else
     {
-        fprintf(stderr, "%s: Out of memory\n", progname);
-        exit(EXIT_FAILURE);
+        if ((n = (allocation *) __mp_getslot(&allocslots)) == NULL)
+        {
+            s = MP_ALLOCBLOCK * sizeof(allocation);
+            p = getmemory(s);
+            *((void **) p) = allocblocks;
+            allocblocks = p;
+            __mp_initslots(&allocslots, (char *) p + sizeof(void *),
+                           s - sizeof(void *));
+            n = (allocation *) __mp_getslot(&allocslots);
+        }
+        while (!__mp_hashinsert(&alloctable, i, n))
+        {
+            s = (alloctable.mask + 1) * 2 * sizeof(hashbucket);
+            if (s < MP_ALLOCBLOCK * sizeof(hashbucket))
+                s = MP_ALLOCBLOCK * sizeof(hashbucket);
+            free(__mp_rehash(&alloctable, getmemory(s), s));
+        }
     }
-    __mp_treeinsert(&alloctree, &n->node, i);
+    n->index = i;
     n->addr = a;
     n->size = l;
     n->offset = o;
@@ -167,15 +219,33 @@ freealloc(unsigned long i)
 {
     allocation *n;
 
-    if ((n = (allocation *) __mp_search(alloctree.root, i)) != NULL)
+    if ((n = (allocation *) __mp_hashremove(&alloctable, i)) != NULL)
     {
-        __mp_treeremove(&alloctree, &n->node);
         alloctotal -= n->size;
-        free(n);
+        __mp_freeslot(&allocslots, n);
     }
 }
 
 
+/* Compare two allocation records by allocation index.
+ */
+
+static
+int
+compareallocs(const void *a, const void *b)
+{
+    unsigned long i, j;
+
+    i = (*((allocation **) a))->index;
+    j = (*((allocation **) b))->index;
+    if (i < j)
+        return -1;
+    else if (i > j)
+        return 1;
+    return 0;
+}
+
+
 /* Read an input line from the log file.
  */
 
@@ -226,7 +296,7 @@ readfile(void)
         if (strncmp(s, "ALLOC: ", 7) == 0)
         {
             /* Parse relevant details from the memory allocation and
-             * add the allocation to the allocation tree.
+             * add the allocation to the allocation table.
              */
             o = fileoffset;
             if ((s = strchr(s + 7, '(')) && (t = strchr(s + 1, ',')))
@@ -255,7 +325,7 @@ readfile(void)
         else if (strncmp(s, "FREE: ", 6) == 0)
         {
             /* Parse relevant details from the memory deallocation and
-             * remove the allocation from the allocation tree.
+             * remove the allocation from the allocation table.
              */
             if ((s = strchr(s + 6, '(')) && (t = strchr(s + 1, ')')))
             {
@@ -283,12 +353,12 @@ readfile(void)
         else if (!ignorelist && (strncmp(s, "unfreed allocations: ", 21) == 0))
             /* If we get here then there is already a list of unfreed memory
              * allocations in the log file.  In this case we just parse them
-             * anyway, adding any new entries to the allocation tree.
+             * anyway, adding any new entries to the allocation table.
              */
             while ((s = getnextline()) != NULL)
             {
                 /* Parse relevant details from the unfreed allocation and
-                 * add the allocation to the allocation tree.
+                 * add the allocation to the allocation table.
                  */
                 o = fileoffset;
                 if ((strncmp(s, "    ", 4) == 0) && (t = strchr(s + 4, ' ')))
@@ -310,7 +380,7 @@ readfile(void)
                              */
                             *t = '\0';
                             n = strtoul(s + 1, NULL, 0);
-                            if (!__mp_search(alloctree.root, n))
+                            if (!__mp_hashsearch(&alloctable, n))
                                 newalloc(n, a, l, o);
                         }
                     }
@@ -327,15 +397,29 @@ static
 void
 printallocs(void)
 {
-    allocation *n, *p;
+    allocation **a;
+    allocation *n;
     char *r, *s, *t;
-    size_t i;
+    size_t i, j, k;
+    void *p;
 
-    printf("unfreed allocations: %lu (%lu byte%s)\n", alloctree.size,
+    printf("unfreed allocations: %lu (%lu byte%s)\n", alloctable.size,
            alloctotal, (alloctotal == 1) ? "" : "s");
-    for (n = (allocation *) __mp_minimum(alloctree.root); n != NULL; n = p)
+    /* The hash table does not keep the allocations in any particular order,
+     * so we must sort them by allocation index before we display them.
+     */
+    a = NULL;
+    if (alloctable.size > 0)
     {
-        p = (allocation *) __mp_successor(&n->node);
+        a = (allocation **) getmemory(alloctable.size * sizeof(allocation *));
+        for (j = k = 0; j <= alloctable.mask; j++)
+            if (alloctable.buckets[j].data != NULL)
+                a[k++] = (allocation *) alloctable.buckets[j].data;
+        qsort(a, k, sizeof(allocation *), compareallocs);
+    }
+    for (j = 0; j < alloctable.size; j++)
+    {
+        n = a[j];
         /* Move to the position in the log file that records the original
          * allocation.
          */
@@ -360,11 +444,11 @@ printallocs(void)
                     i = 0;
                     printf("    " MP_POINTER " (%lu byte%s) {%s:%lu:0} %s\n",
                            n->addr, n->size, (n->size == 1) ? "" : "s", r,
-                           n->node.key, s);
+                           n->index, s);
                     while ((s = getnextline()) && (*s != '\0'))
                         if (i++ < maxstack)
                             puts(s);
-                    if ((alloctree.size > 1) && (maxstack != 0))
+                    if ((j + 1 < alloctable.size) && (maxstack != 0))
                         putchar('\n');
                 }
             }
@@ -375,13 +459,21 @@ printallocs(void)
                 while ((s = getnextline()) && (*s != '\0'))
                     if (i++ < maxstack)
                         puts(s);
-                if ((alloctree.size > 1) && (maxstack != 0))
+                if ((j + 1 < alloctable.size) && (maxstack != 0))
                     putchar('\n');
             }
         }
-        __mp_treeremove(&alloctree, &n->node);
-        free(n);
     }
+    if (a != NULL)
+        free(a);
+    while ((p = allocblocks) != NULL)
+    {
+        allocblocks = *((void **) p);
+        free(p);
+    }
+    if (alloctable.buckets != NULL)
+        free(alloctable.buckets);
+    __mp_newhash(&alloctable);
 }
 
 
@@ -391,8 +483,10 @@ printallocs(void)
 int
 main(int argc, char **argv)
 {
+    struct { char x; allocation y; } z;
     char b[256];
     char *f;
+    long n;
     int c, e, h, v;
 
     e = h = v = 0;
@@ -450,7 +544,10 @@ main(int argc, char **argv)
         f = argv[0];
     else
         f = MP_LOGFILE;
-    __mp_newtree(&alloctree);
+    __mp_newhash(&alloctable);
+    n = (char *) &z.y - &z.x;
+    __mp_newslots(&allocslots, sizeof(allocation), __mp_poweroftwo(n));
+    allocblocks = NULL;
     alloctotal = 0;
     if (strcmp(f, "-") == 0)
         logfile = stdin;
@@ -831,6 +831,39 @@ __mp_stats(heapinfo *d)
 }
 
 
+/* Return statistics about the memory allocated and freed by each thread.
+ */
+
+MP_API
+size_t
+__mp_threadstats(threadinfo *d, size_t l)
+{
+    return 0;
+}
+
+
+/* Return the latencies of each entry point and each phase of processing.
+ */
+
+MP_API
+size_t
+__mp_latencystats(latencyinfo *d, size_t l)
+{
+    return 0;
+}
+
+
+/* Return as much free memory in the heap to the system as possible.
+ */
+
+MP_API
+size_t
+__mp_trim(void)
+{
+    return 0;
+}
+
+
 /* Check the validity of all memory blocks that have been filled with
  * a predefined pattern.
  */
@@ -103,19 +103,28 @@ typedef enum options_flags
     OF_CHECKFREES,
     OF_CHECKMEMORY,
     OF_CHECKREALLOCS,
+    OF_GUARDFREQ,
+    OF_GUARDPOOL,
+    OF_HUGEPAGES,
     OF_LARGEBOUND,
+    OF_LATENCY,
     OF_LEAKTABLE,
     OF_LOGALLOCS,
     OF_LOGFREES,
     OF_LOGMEMORY,
     OF_LOGREALLOCS,
     OF_MEDIUMBOUND,
+    OF_PROFCHECKPOINT,
+    OF_PROFSAMPLE,
+    OF_QUARANTINE,
     OF_SHOWFREE,
     OF_SHOWFREED,
     OF_SHOWMAP,
     OF_SHOWSYMBOLS,
     OF_SHOWUNFREED,
-    OF_SMALLBOUND
+    OF_SMALLBOUND,
+    OF_STATSFILE,
+    OF_TRIM
 }
 options_flags;
 
@@ -148,11 +157,13 @@ static char *allocbyte, *freebyte;
 static char *oflowbyte, *oflowsize;
 static char *defalign, *limit;
 static char *failfreq, *failseed, *unfreedabort;
-static char *logfile, *proffile;
+static char *guardfreq, *guardpool;
+static char *logfile, *proffile, *profsample, *profcheckpoint;
 static char *tracefile, *progfile;
 static char *autosave, *check;
-static char *nofree, *pagealloc;
+static char *nofree, *quarantine, *pagealloc;
 static char *smallbound, *mediumbound, *largebound;
+static char *statsfile, *trim;
 
 
 /* The following boolean options correspond to their uppercase equivalents when
@@ -171,6 +182,7 @@ static int safesignals, noprotect;
 static int checkfork, preserve;
 static int oflowwatch, usemmap;
 static int usedebug, editlist, html;
+static int latency, hugepages;
 
 
 /* The table describing all recognised options.
@@ -234,13 +246,28 @@ static option options_table[] =
     {"free-stop", OF_FREESTOP, "unsigned integer",
      "\tSpecifies an allocation index at which to stop the program when it is\n"
      "\tbeing freed.\n"},
+    {"guard-freq", OF_GUARDFREQ, "unsigned integer",
+     "\tSpecifies that an average of one in every number of memory\n"
+     "\tallocations that fit within a page should be placed at the end of a\n"
+     "\tpage in the guard page pool, followed by an inaccessible page.\n"},
+    {"guard-pool", OF_GUARDPOOL, "unsigned integer",
+     "\tSpecifies the number of slots in the guard page pool, each of which\n"
+     "\toccupies two pages.\n"},
     {"help", OF_HELP, NULL,
      "\tDisplays this quick-reference option summary.\n"},
     {"html", OF_HTML, NULL,
      "\tSpecifies that the log file should be formatted in HTML.\n"},
+    {"huge-pages", OF_HUGEPAGES, NULL,
+     "\tSpecifies that the memory allocations should be placed in regions of\n"
+     "\tmemory that are backed by transparent huge pages where supported.\n"},
     {"large-bound", OF_LARGEBOUND, "unsigned integer",
      "\tSpecifies the limit in bytes up to which memory allocations should be\n"
      "\tclassified as large allocations for profiling purposes.\n"},
+    {"latency", OF_LATENCY, NULL,
+     "\tSpecifies that the time taken by each mpatrol library entry point and\n"
+     "\tby each phase of processing within the library should be recorded and\n"
+     "\ta summary of their latencies displayed at the end of program\n"
+     "\texecution.\n"},
     {"leak-table", OF_LEAKTABLE, NULL,
      "\tSpecifies that the leak table should be automatically used and a leak\n"
      "\ttable summary should be displayed at the end of program execution.\n"},
@@ -302,12 +329,22 @@ static option options_table[] =
     {"prof", OF_PROF, NULL,
      "\tSpecifies that all memory allocations are to be profiled and sent to\n"
      "\tthe profiling output file.\n"},
+    {"prof-checkpoint", OF_PROFCHECKPOINT, "unsigned integer",
+     "\tSpecifies the number of times the profiling output file is written\n"
+     "\tbefore a complete profile is appended to it.\n"},
     {"prof-file", OF_PROFFILE, "string",
      "\tSpecifies an alternative file in which to place all memory allocation\n"
      "\tprofiling information from the mpatrol library.\n"},
+    {"prof-sample", OF_PROFSAMPLE, "unsigned integer",
+     "\tSpecifies the average number of bytes of memory that must be allocated\n"
+     "\tbefore an allocation is sampled for profiling.\n"},
     {"prog-file", OF_PROGFILE, "string",
      "\tSpecifies an alternative filename with which to locate the executable\n"
      "\tfile containing the program's symbols.\n"},
+    {"quarantine", OF_QUARANTINE, "unsigned integer",
+     "\tSpecifies that recently-freed memory allocations should be prevented\n"
+     "\tfrom being returned to the free memory pool until their total size\n"
+     "\texceeds a number of bytes, which may have a K, M or G suffix.\n"},
     {"read-env", OF_READENV, NULL,
      "\tReads and passes through the contents of the " MP_OPTIONS "\n"
      "\tenvironment variable.\n"},
@@ -342,6 +379,10 @@ static option options_table[] =
     {"small-bound", OF_SMALLBOUND, "unsigned integer",
      "\tSpecifies the limit in bytes up to which memory allocations should be\n"
      "\tclassified as small allocations for profiling purposes.\n"},
+    {"stats-file", OF_STATSFILE, "string",
+     "\tSpecifies the name of a shared memory object in which to publish the\n"
+     "\tlive heap statistics so that they can be read by the mpstat command\n"
+     "\twhile the program is running.\n"},
     {"threads", OF_THREADS, NULL,
      "\tSpecifies that the program to be run is multithreaded if the\n"
      "\t--dynamic option is used.\n"},
@@ -351,6 +392,11 @@ static option options_table[] =
     {"trace-file", OF_TRACEFILE, "string",
      "\tSpecifies an alternative file in which to place all memory allocation\n"
      "\ttracing information from the mpatrol library.\n"},
+    {"trim", OF_TRIM, "unsigned integer",
+     "\tSpecifies that free memory should be returned to the system whenever\n"
+     "\tthe total size of the free memory blocks has grown by a number of\n"
+     "\tbytes, which may have a K, M or G suffix, since it was last\n"
+     "\treturned.\n"},
     {"unfreed-abort", OF_UNFREEDABORT, "unsigned integer",
      "\tSpecifies the minimum number of unfreed allocations at which to abort\n"
      "\tthe program just before program termination.\n"},
@@ -461,10 +507,18 @@ setoptions(int r, int s)
         addoption("FREEBYTE", freebyte, 0);
     if (freestop)
         addoption("FREESTOP", freestop, 0);
+    if (guardfreq)
+        addoption("GUARDFREQ", guardfreq, 0);
+    if (guardpool)
+        addoption("GUARDPOOL", guardpool, 0);
     if (html)
         addoption("HTML", NULL, 0);
+    if (hugepages)
+        addoption("HUGEPAGES", NULL, 0);
     if (largebound)
         addoption("LARGEBOUND", largebound, 0);
+    if (latency)
+        addoption("LATENCY", NULL, 0);
     if (leaktable)
         addoption("LEAKTABLE", NULL, 0);
     if (limit)
@@ -502,10 +556,16 @@ setoptions(int r, int s)
         addoption("PRESERVE", NULL, 0);
     if (prof)
         addoption("PROF", NULL, 0);
+    if (profcheckpoint)
+        addoption("PROFCHECKPOINT", profcheckpoint, 0);
     if (proffile)
         addoption("PROFFILE", proffile, 0);
+    if (profsample)
+        addoption("PROFSAMPLE", profsample, 0);
     if (progfile)
         addoption("PROGFILE", progfile, 0);
+    if (quarantine)
+        addoption("QUARANTINE", quarantine, 0);
     if (reallocstop)
         addoption("REALLOCSTOP", reallocstop, 0);
     if (safesignals)
@@ -527,10 +587,14 @@ setoptions(int r, int s)
     }
     if (smallbound)
         addoption("SMALLBOUND", smallbound, 0);
+    if (statsfile)
+        addoption("STATSFILE", statsfile, 0);
     if (trace)
         addoption("TRACE", NULL, 0);
     if (tracefile)
         addoption("TRACEFILE", tracefile, 0);
+    if (trim)
+        addoption("TRIM", trim, 0);
     if (unfreedabort)
         addoption("UNFREEDABORT", unfreedabort, 0);
     if (usedebug)
@@ -713,15 +777,27 @@ main(int argc, char **argv)
           case OF_FREESTOP:
             freestop = __mp_optarg;
             break;
+          case OF_GUARDFREQ:
+            guardfreq = __mp_optarg;
+            break;
+          case OF_GUARDPOOL:
+            guardpool = __mp_optarg;
+            break;
           case OF_HELP:
             h = 1;
             break;
           case OF_HTML:
             html = 1;
             break;
+          case OF_HUGEPAGES:
+            hugepages = 1;
+            break;
           case OF_LARGEBOUND:
             largebound = __mp_optarg;
             break;
+          case OF_LATENCY:
+            latency = 1;
+            break;
           case OF_LEAKTABLE:
             leaktable = 1;
             break;
@@ -785,9 +861,18 @@ main(int argc, char **argv)
           case OF_PROFFILE:
             proffile = __mp_optarg;
             break;
+          case OF_PROFCHECKPOINT:
+            profcheckpoint = __mp_optarg;
+            break;
+          case OF_PROFSAMPLE:
+            profsample = __mp_optarg;
+            break;
           case OF_PROGFILE:
             progfile = __mp_optarg;
             break;
+          case OF_QUARANTINE:
+            quarantine = __mp_optarg;
+            break;
           case OF_READENV:
             x = 1;
             break;
@@ -825,6 +910,9 @@ main(int argc, char **argv)
           case OF_SMALLBOUND:
             smallbound = __mp_optarg;
             break;
+          case OF_STATSFILE:
+            statsfile = __mp_optarg;
+            break;
           case OF_THREADS:
             t = 1;
             break;
@@ -834,6 +922,9 @@ main(int argc, char **argv)
           case OF_TRACEFILE:
             tracefile = __mp_optarg;
             break;
+          case OF_TRIM:
+            trim = __mp_optarg;
+            break;
           case OF_UNFREEDABORT:
             unfreedabort = __mp_optarg;
             break;
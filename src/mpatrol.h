@@ -447,6 +447,42 @@ typedef struct __mp_heapinfo
 __mp_heapinfo;
 
 
+/* The details of the memory allocated and freed by a thread.
+ */
+
+typedef struct __mp_threadinfo
+{
+    unsigned long id;   /* thread identifier */
+    size_t acount;      /* total number of allocations */
+    size_t atotal;      /* total size of allocations */
+    size_t dcount;      /* total number of deallocations */
+    size_t dtotal;      /* total size of deallocations */
+    size_t ucount;      /* total number of unfreed allocations */
+    size_t utotal;      /* total size of unfreed allocations */
+    size_t upeak;       /* peak size of unfreed allocations */
+    size_t rcount;      /* number of allocations freed by other threads */
+    unsigned long secs; /* seconds since first allocation or deallocation */
+}
+__mp_threadinfo;
+
+
+/* The latencies in nanoseconds of a library entry point or of a phase of
+ * processing within the library.
+ */
+
+typedef struct __mp_latencyinfo
+{
+    MP_CONST char *name; /* entry point or phase name */
+    unsigned long count; /* number of measurements */
+    unsigned long total; /* total time */
+    unsigned long p50;   /* median time */
+    unsigned long p90;   /* 90th percentile time */
+    unsigned long p99;   /* 99th percentile time */
+    unsigned long max;   /* maximum time */
+}
+__mp_latencyinfo;
+
+
 /* The structure filled by mallinfo().
  */
 #ifndef __ANDROID__
@@ -787,6 +823,9 @@ void __mp_leaktable(size_t, int, unsigned char);
 void __mp_memorymap(int);
 void __mp_summary(void);
 int __mp_stats(__mp_heapinfo *);
+size_t __mp_threadstats(__mp_threadinfo *, size_t);
+size_t __mp_latencystats(__mp_latencyinfo *, size_t);
+size_t __mp_trim(void);
 void __mp_checkheap(MP_CONST char *, MP_CONST char *, unsigned long);
 __mp_prologuehandler __mp_prologue(MP_CONST __mp_prologuehandler);
 __mp_epiloguehandler __mp_epilogue(MP_CONST __mp_epiloguehandler);
@@ -880,6 +919,9 @@ static int __mp_errno;
 #define __mp_memorymap(s) ((void) 0)
 #define __mp_summary() ((void) 0)
 #define __mp_stats(d) ((int) 0)
+#define __mp_threadstats(d, n) ((size_t) 0)
+#define __mp_latencystats(d, n) ((size_t) 0)
+#define __mp_trim() ((size_t) 0)
 #define __mp_checkheap(s, t, u) ((void) 0)
 #define __mp_check() ((void) 0)
 #define __mp_prologue(h) ((__mp_prologuehandler) NULL)
@@ -969,6 +1011,9 @@ __mp_locprintf(MP_CONST char *m, ...)
 #define mpatrol_memorymap __mp_memorymap
 #define mpatrol_summary __mp_summary
 #define mpatrol_stats __mp_stats
+#define mpatrol_threadstats __mp_threadstats
+#define mpatrol_latencystats __mp_latencystats
+#define mpatrol_trim __mp_trim
 #define mpatrol_checkheap __mp_checkheap
 #define mpatrol_check __mp_check
 #define mpatrol_prologue __mp_prologue
@@ -50,10 +50,15 @@ typedef enum options_flags
 {
     OF_ADDRESSES  = 'a',
     OF_COUNTS     = 'c',
+    OF_FLAMEFILE  = 'F',
+    OF_FOLDEDFILE = 'f',
     OF_GRAPHFILE  = 'g',
     OF_HELP       = 'h',
+    OF_LIFETIME   = 'L',
     OF_LEAKS      = 'l',
     OF_STACKDEPTH = 'n',
+    OF_PPROFFILE  = 'p',
+    OF_FLAMETYPE  = 't',
     OF_VERSION    = 'V',
     OF_CALLGRAPH  = 'v'
 }
@@ -62,15 +67,18 @@ options_flags;
 
 /* Structure containing statistics about the counts and totals of all of the
  * small, medium, large and extra large allocations and deallocations for a
- * particular call site.
+ * particular call site, along with the counts and totals of its deallocations
+ * by lifetime.
  */
 
 typedef struct profiledata
 {
-    size_t acount[4]; /* total numbers of allocations */
-    size_t dcount[4]; /* total numbers of deallocations */
-    size_t atotal[4]; /* total numbers of allocated bytes */
-    size_t dtotal[4]; /* total numbers of deallocated bytes */
+    size_t acount[4];               /* total numbers of allocations */
+    size_t dcount[4];               /* total numbers of deallocations */
+    size_t atotal[4];               /* total numbers of allocated bytes */
+    size_t dtotal[4];               /* total numbers of deallocated bytes */
+    size_t lcount[MP_LIFEBIN_SIZE]; /* deallocations by lifetime */
+    size_t ltotal[MP_LIFEBIN_SIZE]; /* deallocated bytes by lifetime */
 }
 profiledata;
 
@@ -119,6 +127,101 @@ typedef struct edge
 edge;
 
 
+/* Structure used to locate a symbol by its address when merging sets of
+ * changes from the profiling output file.
+ */
+
+typedef struct symbolnode
+{
+    treenode node;           /* tree node */
+    struct symbolnode *next; /* next symbol */
+    unsigned long index;     /* symbol index */
+    unsigned long name;      /* symbol name */
+}
+symbolnode;
+
+
+/* Structure containing the overall statistics after reading a complete
+ * profile or a set of changes from the profiling output file.
+ */
+
+typedef struct snapshot
+{
+    size_t acount; /* total number of allocations */
+    size_t atotal; /* total number of allocated bytes */
+    size_t dcount; /* total number of deallocations */
+    size_t dtotal; /* total number of deallocated bytes */
+    size_t sites;  /* number of call sites */
+    int full;      /* complete profile */
+}
+snapshot;
+
+
+/* Structure containing the allocation summary for a particular thread.
+ */
+
+typedef struct threaddata
+{
+    unsigned long id; /* thread identifier */
+    size_t acount;    /* total number of allocations */
+    size_t atotal;    /* total number of allocated bytes */
+    size_t dcount;    /* total number of deallocations */
+    size_t dtotal;    /* total number of deallocated bytes */
+    size_t ucount;    /* total number of unfreed allocations */
+    size_t utotal;    /* total number of unfreed bytes */
+    size_t upeak;     /* peak number of unfreed bytes */
+    size_t rcount;    /* number of allocations freed by other threads */
+}
+threaddata;
+
+
+/* Structure containing a growable buffer used to build up a protocol buffer
+ * message before it is written out.
+ */
+
+typedef struct buffer
+{
+    unsigned char *data; /* contents of buffer */
+    size_t size;         /* number of bytes used */
+    size_t max;          /* number of bytes allocated */
+}
+buffer;
+
+
+/* Structure representing a frame in the folded call stacks and flame graph.
+ * All call sites with the same label and the same parent frame share the
+ * same frame.
+ */
+
+typedef struct frame
+{
+    unsigned long parent; /* parent frame */
+    unsigned long label;  /* label of call site */
+    profilenode *pnode;   /* first profiling node */
+    size_t total;         /* value including children */
+    size_t self;          /* value excluding children */
+    size_t depth;         /* depth in call stack */
+    unsigned long child;  /* first child frame */
+    unsigned long next;   /* next sibling frame */
+}
+frame;
+
+
+/* The indices of the fixed entries at the start of the string table in the
+ * pprof profile.  The function names follow these entries in the order of
+ * their symbol indices.
+ */
+
+#define PS_EMPTY        0
+#define PS_ALLOCOBJECTS 1
+#define PS_COUNT        2
+#define PS_ALLOCSPACE   3
+#define PS_BYTES        4
+#define PS_INUSEOBJECTS 5
+#define PS_INUSESPACE   6
+#define PS_NAMES        7
+
+
 /* The version of the mpatrol library which produced the profiling output file.
  */
 
@@ -191,6 +294,44 @@ static void **addrs;
 static char *symbols;
 
 
+/* The number of symbol addresses and the size of the string table.
+ */
+
+static size_t symsize, strsize;
+
+
+/* The tree and list of symbols used when merging sets of changes.
+ */
+
+static treeroot symtree;
+static symbolnode *symlist;
+
+
+/* The overall statistics after each complete profile or set of changes.
+ */
+
+static snapshot *snapshots;
+
+
+/* The number of snapshot structures.
+ */
+
+static size_t snapsize;
+
+
+/* The allocation summary for each thread from the most recent complete
+ * profile or set of changes.
+ */
+
+static threaddata *threads;
+
+
+/* The number of threaddata structures.
+ */
+
+static size_t threadsize;
+
+
 /* The small, medium and large allocation boundaries.
  */
 
@@ -233,6 +374,36 @@ static FILE *proffile;
 static FILE *graphfile;
 
 
+/* The pprof profile file optionally produced by mprof.
+ */
+
+static FILE *pproffile;
+
+
+/* The folded call stacks file optionally produced by mprof.
+ */
+
+static FILE *foldedfile;
+
+
+/* The flame graph file optionally produced by mprof.
+ */
+
+static FILE *flamefile;
+
+
+/* The frames used when writing the folded call stacks and flame graph.
+ */
+
+static frame *frames;
+
+
+/* The number of frames and the maximum depth of any frame.
+ */
+
+static size_t framesize, flamedepth;
+
+
 /* The filename used to invoke this tool.
  */
 
@@ -267,12 +438,27 @@ static int showleaks;
 static unsigned long maxstack;
 
 
+/* Indicates if the short-lived allocation table should be displayed, and if
+ * so, the maximum lifetime in events of the allocations that it includes.
+ */
+
+static int showlife;
+static unsigned long maxlife;
+
+
 /* Indicates if the allocation call graph should be displayed.
  */
 
 static int showgraph;
 
 
+/* Indicates if allocated, unfreed or freed memory should be written to the
+ * folded call stacks and flame graph files.
+ */
+
+static int flametype;
+
+
 /* The table describing all recognised options.
  */
 
@@ -288,6 +474,15 @@ static option options_table[] =
      "\tSpecifies that certain tables should be sorted by the number of\n"
      "\tallocations or deallocations rather than the total number of bytes\n"
      "\tallocated or deallocated.\n"},
+    {"flame-file", OF_FLAMEFILE, "file",
+     "\tSpecifies that a flame graph of the call stacks should be written to\n"
+     "\ta file in SVG format.\n"},
+    {"flame-type", OF_FLAMETYPE, "allocated|unfreed|freed",
+     "\tSpecifies whether allocated, unfreed or freed memory should be written\n"
+     "\tto the folded call stacks and flame graph files.\n"},
+    {"folded-file", OF_FOLDEDFILE, "file",
+     "\tSpecifies that the call stacks should be written to a file in folded\n"
+     "\tformat for use with flame graph tools.\n"},
     {"graph-file", OF_GRAPHFILE, "file",
      "\tSpecifies that the allocation call graph should also be written to a\n"
      "\tgraph specification file for later visualisation with dot.\n"},
@@ -296,6 +491,12 @@ static option options_table[] =
     {"leaks", OF_LEAKS, NULL,
      "\tSpecifies that memory leaks rather than memory allocations are to be\n"
      "\twritten to the graph specification file.\n"},
+    {"lifetime", OF_LIFETIME, "events",
+     "\tSpecifies that a table of the call sites which allocated memory that\n"
+     "\twas freed within the given number of events should be displayed.\n"},
+    {"pprof-file", OF_PPROFFILE, "file",
+     "\tSpecifies that the profiling data should also be written to a file\n"
+     "\tin the gzip-compressed protocol buffer format used by pprof.\n"},
     {"stack-depth", OF_STACKDEPTH, "depth",
      "\tSpecifies the maximum stack depth to display and also use when\n"
      "\tcalculating if one call site has the same call stack as another call\n"
@@ -322,6 +523,11 @@ cleardata(profiledata *a)
         a->atotal[i] = 0;
         a->dtotal[i] = 0;
     }
+    for (i = 0; i < MP_LIFEBIN_SIZE; i++)
+    {
+        a->lcount[i] = 0;
+        a->ltotal[i] = 0;
+    }
 }
 
 
@@ -341,6 +547,11 @@ sumdata(profiledata *a, profiledata *b)
         a->atotal[i] += b->atotal[i];
         a->dtotal[i] += b->dtotal[i];
     }
+    for (i = 0; i < MP_LIFEBIN_SIZE; i++)
+    {
+        a->lcount[i] += b->lcount[i];
+        a->ltotal[i] += b->ltotal[i];
+    }
 }
 
 
@@ -413,34 +624,185 @@ getentry(void *d, size_t l, size_t n, int b)
 }
 
 
-/* Read all of the data from the profiling output file.
+/* Resize a block of memory used by this tool and abort if there is no memory
+ * left.
+ */
+
+static
+void *
+resize(void *p, size_t l)
+{
+    void *q;
+
+    if (l == 0)
+        l = 1;
+    if ((q = realloc(p, l)) == NULL)
+    {
+        fprintf(stderr, "%s: Out of memory\n", progname);
+        exit(EXIT_FAILURE);
+    }
+    return q;
+}
+
+
+/* Read the allocation and deallocation bins from the profiling output file
+ * and calculate the total allocations and deallocations from them.
  */
 
 static
 void
-readfile(void)
+readbins(int b)
+{
+    size_t i;
+
+    acount = dcount = 0;
+    atotal = dtotal = 0;
+    getentry(&binsize, sizeof(size_t), 1, b);
+    if (binsize > 0)
+    {
+        acounts = (size_t *) resize(acounts, binsize * sizeof(size_t));
+        dcounts = (size_t *) resize(dcounts, binsize * sizeof(size_t));
+        getentry(acounts, sizeof(size_t), binsize, b);
+        getentry(&atotals, sizeof(size_t), 1, b);
+        getentry(dcounts, sizeof(size_t), binsize, b);
+        getentry(&dtotals, sizeof(size_t), 1, b);
+        for (i = 0; i < binsize; i++)
+        {
+            acount += acounts[i];
+            dcount += dcounts[i];
+            if (i == binsize - 1)
+            {
+                atotal += atotals;
+                dtotal += dtotals;
+            }
+            else
+            {
+                atotal += acounts[i] * (i + 1);
+                dtotal += dcounts[i] * (i + 1);
+            }
+        }
+    }
+}
+
+
+/* Forget about all of the symbols that have been located by address.
+ */
+
+static
+void
+freesymbols(void)
+{
+    symbolnode *s;
+
+    while ((s = symlist) != NULL)
+    {
+        symlist = s->next;
+        free(s);
+    }
+    __mp_newtree(&symtree);
+}
+
+
+/* Locate a symbol by its address, or add a new symbol if it has not been seen
+ * before.  The tree of symbols is only built when it is first required.
+ */
+
+static
+symbolnode *
+addsymbol(void *a, unsigned long n)
+{
+    symbolnode *s;
+
+    if ((s = (symbolnode *) __mp_search(symtree.root, (unsigned long) a)) !=
+        NULL)
+        return s;
+    if ((s = (symbolnode *) malloc(sizeof(symbolnode))) == NULL)
+    {
+        fprintf(stderr, "%s: Out of memory\n", progname);
+        exit(EXIT_FAILURE);
+    }
+    __mp_treeinsert(&symtree, &s->node, (unsigned long) a);
+    s->next = symlist;
+    symlist = s;
+    s->index = n;
+    s->name = 0;
+    return s;
+}
+
+
+/* Read the lifetime bins for a set of profiling data from the profiling
+ * output file.  If the file contains more lifetime bins than we know about
+ * then the extra bins are added to the highest bin.
+ */
+
+static
+void
+readlife(profiledata *d, size_t n, int b)
+{
+    size_t i, k;
+
+    for (i = 0; i < n; i++)
+    {
+        getentry(&k, sizeof(size_t), 1, b);
+        d->lcount[(i < MP_LIFEBIN_SIZE) ? i : MP_LIFEBIN_SIZE - 1] += k;
+    }
+    for (i = 0; i < n; i++)
+    {
+        getentry(&k, sizeof(size_t), 1, b);
+        d->ltotal[(i < MP_LIFEBIN_SIZE) ? i : MP_LIFEBIN_SIZE - 1] += k;
+    }
+}
+
+
+/* Read the allocation summary for every thread from the profiling output
+ * file, replacing any that we have already read.
+ */
+
+static
+void
+readthreads(int b)
+{
+    threaddata *t;
+    size_t i;
+
+    getentry(&threadsize, sizeof(size_t), 1, b);
+    if (threadsize > 0)
+    {
+        threads = (threaddata *) resize(threads, threadsize *
+                                        sizeof(threaddata));
+        for (i = 0; i < threadsize; i++)
+        {
+            t = &threads[i];
+            getentry(&t->id, sizeof(unsigned long), 1, b);
+            getentry(&t->acount, sizeof(size_t), 1, b);
+            getentry(&t->atotal, sizeof(size_t), 1, b);
+            getentry(&t->dcount, sizeof(size_t), 1, b);
+            getentry(&t->dtotal, sizeof(size_t), 1, b);
+            getentry(&t->ucount, sizeof(size_t), 1, b);
+            getentry(&t->utotal, sizeof(size_t), 1, b);
+            getentry(&t->upeak, sizeof(size_t), 1, b);
+            getentry(&t->rcount, sizeof(size_t), 1, b);
+        }
+    }
+}
+
+
+/* Read a complete profile from the profiling output file, replacing any
+ * profiling data that has already been read.  The magic sequence of
+ * characters at the start has already been read.
+ */
+
+static
+int
+readprofile(void)
 {
     char s[4];
     profiledata *d;
     profilenode *p;
-    size_t i;
+    size_t i, k, l;
     unsigned long n;
     int b;
 
-    /* When reading the profiling output file, we assume that if it begins and
-     * ends with the magic sequence of characters then it is a valid profiling
-     * output file from the mpatrol library.  There are probably an infinite
-     * number of checks we could do to ensure that the rest of the data in the
-     * file is valid, but that would be overcomplicated and probably slow this
-     * program down.  However, if the file is only partially written then the
-     * getentry() function will catch the error before we do something silly.
-     */
-    getentry(s, sizeof(char), 4, 0);
-    if (memcmp(s, MP_PROFMAGIC, 4) != 0)
-    {
-        fprintf(stderr, "%s: Invalid file format\n", progname);
-        exit(EXIT_FAILURE);
-    }
     /* The following test allows us to read profiling output files that were
      * produced on a different processor architecture.  If the next word in the
      * file does not contain the value 1 then we have to byte-swap any further
@@ -471,50 +833,18 @@ readfile(void)
     getentry(&lbound, sizeof(size_t), 1, b);
     /* Read the allocation and deallocation bins.
      */
-    getentry(&binsize, sizeof(size_t), 1, b);
-    if (binsize > 0)
-    {
-        if (((acounts = (size_t *) malloc(binsize * sizeof(size_t))) == NULL) ||
-            ((dcounts = (size_t *) malloc(binsize * sizeof(size_t))) == NULL))
-        {
-            fprintf(stderr, "%s: Out of memory\n", progname);
-            exit(EXIT_FAILURE);
-        }
-        getentry(acounts, sizeof(size_t), binsize, b);
-        getentry(&atotals, sizeof(size_t), 1, b);
-        getentry(dcounts, sizeof(size_t), binsize, b);
-        getentry(&dtotals, sizeof(size_t), 1, b);
-        for (i = 0; i < binsize; i++)
-        {
-            acount += acounts[i];
-            dcount += dcounts[i];
-            if (i == binsize - 1)
-            {
-                atotal += atotals;
-                dtotal += dtotals;
-            }
-            else
-            {
-                atotal += acounts[i] * (i + 1);
-                dtotal += dcounts[i] * (i + 1);
-            }
-        }
-    }
+    readbins(b);
     /* Read the profiling data structures.
      */
     getentry(&datasize, sizeof(size_t), 1, b);
     if (datasize > 0)
     {
-        if ((data = (profiledata *) malloc(datasize * sizeof(profiledata))) ==
-            NULL)
-        {
-            fprintf(stderr, "%s: Out of memory\n", progname);
-            exit(EXIT_FAILURE);
-        }
+        data = (profiledata *) resize(data, datasize * sizeof(profiledata));
         for (i = 0; i < datasize; i++)
         {
             getentry(&n, sizeof(unsigned long), 1, b);
             d = &data[n - 1];
+            cleardata(d);
             getentry(d->acount, sizeof(size_t), 4, b);
             getentry(d->atotal, sizeof(size_t), 4, b);
             getentry(d->dcount, sizeof(size_t), 4, b);
@@ -526,12 +856,7 @@ readfile(void)
     getentry(&nodesize, sizeof(size_t), 1, b);
     if (nodesize > 0)
     {
-        if ((nodes = (profilenode *) malloc(nodesize * sizeof(profilenode))) ==
-            NULL)
-        {
-            fprintf(stderr, "%s: Out of memory\n", progname);
-            exit(EXIT_FAILURE);
-        }
+        nodes = (profilenode *) resize(nodes, nodesize * sizeof(profilenode));
         for (i = 0; i < nodesize; i++)
         {
             getentry(&n, sizeof(unsigned long), 1, b);
@@ -541,43 +866,256 @@ readfile(void)
             getentry(&p->symbol, sizeof(unsigned long), 1, b);
             getentry(&p->name, sizeof(unsigned long), 1, b);
             getentry(&p->data, sizeof(unsigned long), 1, b);
-            __mp_treeinsert(&proftree, &p->node, (unsigned long) p->addr);
-            cleardata(&p->tdata);
-            p->flags = 0;
         }
     }
     /* Read the table containing the symbol addresses.
      */
-    getentry(&i, sizeof(size_t), 1, b);
-    if (i > 0)
+    getentry(&symsize, sizeof(size_t), 1, b);
+    if (symsize > 0)
     {
-        if ((addrs = (void **) malloc(i * sizeof(void *))) == NULL)
-        {
-            fprintf(stderr, "%s: Out of memory\n", progname);
-            exit(EXIT_FAILURE);
-        }
-        getentry(addrs, sizeof(void *), i, b);
+        addrs = (void **) resize(addrs, symsize * sizeof(void *));
+        getentry(addrs, sizeof(void *), symsize, b);
     }
     /* Read the string table containing the symbol names.
      */
-    getentry(&i, sizeof(size_t), 1, b);
-    if (i > 0)
+    getentry(&strsize, sizeof(size_t), 1, b);
+    if (strsize > 0)
     {
-        if ((symbols = (char *) malloc(i * sizeof(char))) == NULL)
-        {
-            fprintf(stderr, "%s: Out of memory\n", progname);
-            exit(EXIT_FAILURE);
-        }
-        getentry(symbols, sizeof(char), i, 0);
+        symbols = (char *) resize(symbols, strsize * sizeof(char));
+        getentry(symbols, sizeof(char), strsize, 0);
     }
+    /* Read the lifetime bins for every profiling data structure if they are
+     * present.  Profiling output files produced before they were recorded
+     * will not contain them.
+     */
     getentry(s, sizeof(char), 4, 0);
-    if (memcmp(s, MP_PROFMAGIC, 4) != 0)
+    if (memcmp(s, MP_LIFEMAGIC, 4) == 0)
     {
-        fprintf(stderr, "%s: Invalid file format\n", progname);
-        exit(EXIT_FAILURE);
-    }
-}
-
+        getentry(&l, sizeof(size_t), 1, b);
+        getentry(&k, sizeof(size_t), 1, b);
+        while (k-- > 0)
+        {
+            getentry(&n, sizeof(unsigned long), 1, b);
+            if ((n == 0) || (n > datasize))
+            {
+                fprintf(stderr, "%s: Invalid file format\n", progname);
+                exit(EXIT_FAILURE);
+            }
+            readlife(&data[n - 1], l, b);
+        }
+        getentry(s, sizeof(char), 4, 0);
+    }
+    /* Likewise, read the allocation summary for every thread if it is
+     * present.
+     */
+    if (memcmp(s, MP_THREADMAGIC, 4) == 0)
+    {
+        readthreads(b);
+        getentry(s, sizeof(char), 4, 0);
+    }
+    if (memcmp(s, MP_PROFMAGIC, 4) != 0)
+    {
+        fprintf(stderr, "%s: Invalid file format\n", progname);
+        exit(EXIT_FAILURE);
+    }
+    freesymbols();
+    return b;
+}
+
+
+/* Read a set of changes from the profiling output file and merge them with
+ * the profiling data that has already been read.  Every call site that is
+ * new or has changed is written in full along with the name of its symbol,
+ * so we only need to overwrite or add to the existing entries.
+ */
+
+static
+void
+readdelta(int b)
+{
+    char s[4];
+    symbolnode *y;
+    profilenode *p;
+    void *a;
+    size_t i, k, l, m;
+    unsigned long n;
+
+    /* Ensure that every symbol that we already know about can be found by
+     * its address before we read any new symbols.
+     */
+    if ((symlist == NULL) && (symsize > 0))
+        for (i = 0; i < nodesize; i++)
+            if (nodes[i].symbol != 0)
+                addsymbol(addrs[nodes[i].symbol - 1],
+                          nodes[i].symbol)->name = nodes[i].name;
+    readbins(b);
+    getentry(&k, sizeof(size_t), 1, b);
+    getentry(&m, sizeof(size_t), 1, b);
+    while (k-- > 0)
+    {
+        getentry(&n, sizeof(unsigned long), 1, b);
+        if (n > nodesize)
+        {
+            nodes = (profilenode *) resize(nodes, n * sizeof(profilenode));
+            memset(nodes + nodesize, 0, (n - nodesize) * sizeof(profilenode));
+            nodesize = n;
+        }
+        p = &nodes[n - 1];
+        getentry(&p->parent, sizeof(unsigned long), 1, b);
+        getentry(&p->addr, sizeof(void *), 1, b);
+        getentry(&a, sizeof(void *), 1, b);
+        getentry(&l, sizeof(size_t), 1, b);
+        p->symbol = p->name = 0;
+        if (a != NULL)
+        {
+            y = addsymbol(a, symsize + 1);
+            if (y->index > symsize)
+            {
+                /* This is a new symbol so add its address and name to the end
+                 * of the existing tables.  The string table always begins
+                 * with an empty string.
+                 */
+                addrs = (void **) resize(addrs, (symsize + 1) * sizeof(void *));
+                addrs[symsize++] = a;
+                if (strsize == 0)
+                {
+                    symbols = (char *) resize(symbols, 1);
+                    symbols[strsize++] = '\0';
+                }
+                symbols = (char *) resize(symbols, strsize + l + 1);
+                y->name = strsize;
+                getentry(symbols + strsize, sizeof(char), l, 0);
+                symbols[strsize + l] = '\0';
+                strsize += l + 1;
+            }
+            else if (l > 0)
+            {
+                /* We already know about this symbol so skip over its name.
+                 */
+                for (i = 0; i < l; i++)
+                    getentry(s, sizeof(char), 1, 0);
+            }
+            p->symbol = y->index;
+            p->name = y->name;
+        }
+        getentry(&p->data, sizeof(unsigned long), 1, b);
+        if ((n = p->data) != 0)
+        {
+            if (n > datasize)
+            {
+                data = (profiledata *) resize(data, n * sizeof(profiledata));
+                memset(data + datasize, 0, (n - datasize) *
+                       sizeof(profiledata));
+                datasize = n;
+            }
+            cleardata(&data[n - 1]);
+            getentry(data[n - 1].acount, sizeof(size_t), 4, b);
+            getentry(data[n - 1].atotal, sizeof(size_t), 4, b);
+            getentry(data[n - 1].dcount, sizeof(size_t), 4, b);
+            getentry(data[n - 1].dtotal, sizeof(size_t), 4, b);
+            readlife(&data[n - 1], m, b);
+        }
+    }
+    getentry(s, sizeof(char), 4, 0);
+    if (memcmp(s, MP_THREADMAGIC, 4) == 0)
+    {
+        readthreads(b);
+        getentry(s, sizeof(char), 4, 0);
+    }
+    if (memcmp(s, MP_DELTAMAGIC, 4) != 0)
+    {
+        fprintf(stderr, "%s: Invalid file format\n", progname);
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+/* Note the overall statistics after reading a complete profile or a set of
+ * changes so that the evolution of the profile can be displayed.
+ */
+
+static
+void
+addsnapshot(int f)
+{
+    snapshot *s;
+
+    snapshots = (snapshot *) resize(snapshots, (snapsize + 1) *
+                                    sizeof(snapshot));
+    s = &snapshots[snapsize++];
+    s->acount = acount;
+    s->atotal = atotal;
+    s->dcount = dcount;
+    s->dtotal = dtotal;
+    s->sites = nodesize;
+    s->full = f;
+}
+
+
+/* Read all of the data from the profiling output file.
+ */
+
+static
+void
+readfile(void)
+{
+    char s[4];
+    profilenode *p;
+    size_t i;
+    int b;
+
+    /* When reading the profiling output file, we assume that if it begins and
+     * ends with the magic sequence of characters then it is a valid profiling
+     * output file from the mpatrol library.  There are probably an infinite
+     * number of checks we could do to ensure that the rest of the data in the
+     * file is valid, but that would be overcomplicated and probably slow this
+     * program down.  However, if the file is only partially written then the
+     * getentry() function will catch the error before we do something silly.
+     */
+    getentry(s, sizeof(char), 4, 0);
+    if (memcmp(s, MP_PROFMAGIC, 4) != 0)
+    {
+        fprintf(stderr, "%s: Invalid file format\n", progname);
+        exit(EXIT_FAILURE);
+    }
+    b = readprofile();
+    addsnapshot(1);
+    /* The mpatrol library may have appended sets of changes or further
+     * complete profiles to the file if the autosave feature was enabled.
+     */
+    while ((i = fread(s, sizeof(char), 4, proffile)) > 0)
+    {
+        if (i != 4)
+        {
+            fprintf(stderr, "%s: Error reading file\n", progname);
+            exit(EXIT_FAILURE);
+        }
+        if (memcmp(s, MP_PROFMAGIC, 4) == 0)
+        {
+            b = readprofile();
+            addsnapshot(1);
+        }
+        else if (memcmp(s, MP_DELTAMAGIC, 4) == 0)
+        {
+            readdelta(b);
+            addsnapshot(0);
+        }
+        else
+        {
+            fprintf(stderr, "%s: Invalid file format\n", progname);
+            exit(EXIT_FAILURE);
+        }
+    }
+    freesymbols();
+    for (i = 0; i < nodesize; i++)
+    {
+        p = &nodes[i];
+        __mp_treeinsert(&proftree, &p->node, (unsigned long) p->addr);
+        cleardata(&p->tdata);
+        p->flags = 0;
+    }
+}
+
 
 /* Count the number of decimal digits in a number.
  */
@@ -1181,6 +1719,217 @@ leaktable(void)
 }
 
 
+/* Display the call sites which allocated memory that was freed within a
+ * given number of events, sorted by the number of bytes or allocations.
+ * Since lifetimes are recorded in bins whose bounds are powers of two, only
+ * the lifetime bins that lie entirely within the given number of events are
+ * included.
+ */
+
+static
+void
+lifetable(void)
+{
+    profiledata *d;
+    profilenode *n, *p;
+    treenode *t;
+    profiledata m;
+    size_t i, j;
+    unsigned long a, b, c, k, l;
+    double e, f;
+
+    for (j = 0, k = 1; (j < MP_LIFEBIN_SIZE - 1) && ((k << 1) - 1 <= maxlife);
+         j++, k <<= 1);
+    cleardata(&m);
+    printchar(' ', 28);
+    fputs("SHORT-LIVED ALLOCATIONS\n\n", stdout);
+    printchar(' ', 27);
+    fprintf(stdout, "(lifetime < %lu events)\n\n", k);
+    if (showcounts)
+        fputs(" count       %   freed       %     bytes  function\n\n",
+              stdout);
+    else
+        fputs("   bytes       %     freed       %   count  function\n\n",
+              stdout);
+    for (n = (profilenode *) __mp_minimum(proftree.root); n != NULL; n = p)
+    {
+        p = (profilenode *) __mp_successor(&n->node);
+        if (n->data != 0)
+        {
+            d = &n->tdata;
+            sumdata(d, &data[n->data - 1]);
+            while ((p != NULL) && ((p->addr == n->addr) || (!useaddresses &&
+                     (p->symbol != 0) && (p->symbol == n->symbol))))
+            {
+                if (p->data != 0)
+                    sumdata(d, &data[p->data - 1]);
+                p = (profilenode *) __mp_successor(&p->node);
+            }
+            a = 0;
+            for (i = 0; i < j; i++)
+                if (showcounts)
+                    a += d->lcount[i];
+                else
+                    a += d->ltotal[i];
+            sumdata(&m, d);
+            if (a > 0)
+                __mp_treeinsert(&temptree, &n->tnode, a);
+            else
+                cleardata(d);
+        }
+    }
+    k = l = 0;
+    for (i = 0; i < j; i++)
+    {
+        k += m.lcount[i];
+        l += m.ltotal[i];
+    }
+    for (t = __mp_maximum(temptree.root); t != NULL; t = __mp_predecessor(t))
+    {
+        n = (profilenode *) ((char *) t - offsetof(profilenode, tnode));
+        d = &n->tdata;
+        a = t->key;
+        b = c = 0;
+        for (i = 0; i < 4; i++)
+            if (showcounts)
+                b += d->dcount[i];
+            else
+                b += d->dtotal[i];
+        for (i = 0; i < j; i++)
+            if (showcounts)
+                c += d->ltotal[i];
+            else
+                c += d->lcount[i];
+        if (showcounts)
+            e = ((double) a / (double) k) * 100.0;
+        else
+            e = ((double) a / (double) l) * 100.0;
+        f = ((double) a / (double) b) * 100.0;
+        if (showcounts)
+            fprintf(stdout, "%6lu  %6.2f  %6lu  %6.2f  %8lu  ", a, e, b, f, c);
+        else
+            fprintf(stdout, "%8lu  %6.2f  %8lu  %6.2f  %6lu  ", a, e, b, f, c);
+        printsymbol(stdout, n);
+        fputc('\n', stdout);
+        cleardata(d);
+    }
+    if (temptree.size != 0)
+        fputc('\n', stdout);
+    if (showcounts)
+    {
+        if (dcount != 0)
+            f = ((double) k / (double) dcount) * 100.0;
+        else
+            f = 0.0;
+        fprintf(stdout, "%6lu          %6lu  %6.2f  %8lu  total\n", k, dcount,
+                f, l);
+    }
+    else
+    {
+        if (dtotal != 0)
+            f = ((double) l / (double) dtotal) * 100.0;
+        else
+            f = 0.0;
+        fprintf(stdout, "%8lu          %8lu  %6.2f  %6lu  total\n", l, dtotal,
+                f, k);
+    }
+    __mp_newtree(&temptree);
+}
+
+
+/* Compare the unfreed bytes of two threads for qsort().
+ */
+
+static
+int
+comparethreads(const void *a, const void *b)
+{
+    size_t x, y;
+
+    x = ((const threaddata *) a)->utotal;
+    y = ((const threaddata *) b)->utotal;
+    if (x > y)
+        return -1;
+    else if (x < y)
+        return 1;
+    return 0;
+}
+
+
+/* Display the allocation summary for every thread, sorted by the number of
+ * unfreed bytes.
+ */
+
+static
+void
+threadtable(void)
+{
+    threaddata *t;
+    size_t i;
+
+    qsort(threads, threadsize, sizeof(threaddata), comparethreads);
+    printchar(' ', 39);
+    fputs("THREAD SUMMARY\n\n", stdout);
+    printchar(' ', 36);
+    fprintf(stdout, "(number of threads: %lu)\n\n", threadsize);
+    printchar(' ', 12);
+    fputs("unfreed", stdout);
+    printchar(' ', 20);
+    fputs("allocated", stdout);
+    printchar(' ', 15);
+    fputs("freed\n", stdout);
+    printchar('-', 32);
+    fputs("  ", stdout);
+    printchar('-', 20);
+    fputs("  ", stdout);
+    printchar('-', 20);
+    fputs("\n   count       bytes        peak     count       bytes     "
+          "count       bytes  remote  thread\n\n", stdout);
+    for (i = 0; i < threadsize; i++)
+    {
+        t = &threads[i];
+        fprintf(stdout, "%8lu  %10lu  %10lu  %8lu  %10lu  %8lu  %10lu  %6lu  "
+                "%lu\n", t->ucount, t->utotal, t->upeak, t->acount, t->atotal,
+                t->dcount, t->dtotal, t->rcount, t->id);
+    }
+}
+
+
+/* Display the evolution of the profile over all of the times that the
+ * profiling output file was written.
+ */
+
+static
+void
+snapshottable(void)
+{
+    snapshot *s;
+    size_t i;
+
+    printchar(' ', 31);
+    fputs("PROFILE SNAPSHOTS\n\n", stdout);
+    printchar(' ', 27);
+    fprintf(stdout, "(number of snapshots: %lu)\n\n", snapsize);
+    printchar(' ', 25);
+    fputs("allocated", stdout);
+    printchar(' ', 19);
+    fputs("unfreed\n", stdout);
+    printchar(' ', 18);
+    printchar('-', 24);
+    fputs("  ", stdout);
+    printchar('-', 24);
+    fputs("\nsnapshot   sites         count       bytes         "
+          "count       bytes\n\n", stdout);
+    for (i = 0; i < snapsize; i++)
+    {
+        s = &snapshots[i];
+        fprintf(stdout, "%8lu%c %6lu  %12lu  %10lu  %12lu  %10lu\n", i + 1,
+                s->full ? ' ' : '+', s->sites, s->acount, s->atotal,
+                s->acount - s->dcount, s->atotal - s->dtotal);
+    }
+}
+
+
 /* Display the allocation call graph.
  */
 
@@ -1420,6 +2169,599 @@ writegraph(profilenode *p, graphnode *n)
 }
 
 
+/* Add a byte to the end of a buffer, enlarging it if necessary.
+ */
+
+static
+void
+putbyte(buffer *b, unsigned char c)
+{
+    unsigned char *p;
+    size_t n;
+
+    if (b->size == b->max)
+    {
+        if ((n = b->max * 2) == 0)
+            n = 256;
+        if ((p = (unsigned char *) realloc(b->data, n)) == NULL)
+        {
+            fprintf(stderr, "%s: Out of memory\n", progname);
+            exit(EXIT_FAILURE);
+        }
+        b->data = p;
+        b->max = n;
+    }
+    b->data[b->size++] = c;
+}
+
+
+/* Add an unsigned number to a buffer in protocol buffer varint format.
+ */
+
+static
+void
+putvarint(buffer *b, unsigned long n)
+{
+    while (n > 0x7F)
+    {
+        putbyte(b, (unsigned char) ((n & 0x7F) | 0x80));
+        n >>= 7;
+    }
+    putbyte(b, (unsigned char) n);
+}
+
+
+/* Add a numeric field to a protocol buffer message.
+ */
+
+static
+void
+putnumber(buffer *b, unsigned long f, unsigned long n)
+{
+    putvarint(b, f << 3);
+    putvarint(b, n);
+}
+
+
+/* Add a length-delimited field to a protocol buffer message.
+ */
+
+static
+void
+putbytes(buffer *b, unsigned long f, void *p, size_t l)
+{
+    size_t i;
+
+    putvarint(b, (f << 3) | 2);
+    putvarint(b, l);
+    for (i = 0; i < l; i++)
+        putbyte(b, ((unsigned char *) p)[i]);
+}
+
+
+/* Add an embedded protocol buffer message to another message and empty the
+ * buffer containing the embedded message so that it can be reused.
+ */
+
+static
+void
+putmessage(buffer *b, unsigned long f, buffer *m)
+{
+    putbytes(b, f, m->data, m->size);
+    m->size = 0;
+}
+
+
+/* Calculate the CRC-32 checksum of a block of memory as required by the gzip
+ * file format.
+ */
+
+static
+unsigned long
+crc32(unsigned char *p, size_t l)
+{
+    static unsigned long t[256];
+    unsigned long c;
+    size_t i, j;
+
+    if (t[1] == 0)
+        for (i = 0; i < 256; i++)
+        {
+            for (c = i, j = 0; j < 8; j++)
+                if (c & 1)
+                    c = 0xEDB88320UL ^ (c >> 1);
+                else
+                    c >>= 1;
+            t[i] = c;
+        }
+    for (c = 0xFFFFFFFFUL, i = 0; i < l; i++)
+        c = t[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFUL;
+}
+
+
+/* Write a 32-bit number to a file in little-endian byte order.
+ */
+
+static
+void
+putword(FILE *f, unsigned long n)
+{
+    fputc((int) (n & 0xFF), f);
+    fputc((int) ((n >> 8) & 0xFF), f);
+    fputc((int) ((n >> 16) & 0xFF), f);
+    fputc((int) ((n >> 24) & 0xFF), f);
+}
+
+
+/* Write the contents of a buffer to a file in gzip format.  We don't want
+ * to depend on a compression library so the data is written as a sequence
+ * of stored deflate blocks, which every gzip decoder must accept.
+ */
+
+static
+void
+writegzip(FILE *f, buffer *b)
+{
+    static unsigned char h[10] = {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF};
+    size_t i, l;
+
+    fwrite(h, sizeof(unsigned char), 10, f);
+    i = 0;
+    do
+    {
+        if ((l = b->size - i) > 0xFFFF)
+            l = 0xFFFF;
+        fputc(i + l == b->size, f);
+        fputc((int) (l & 0xFF), f);
+        fputc((int) (l >> 8), f);
+        fputc((int) (~l & 0xFF), f);
+        fputc((int) ((~l >> 8) & 0xFF), f);
+        fwrite(b->data + i, sizeof(unsigned char), l, f);
+        i += l;
+    }
+    while (i < b->size);
+    putword(f, crc32(b->data, b->size));
+    putword(f, b->size & 0xFFFFFFFFUL);
+}
+
+
+/* Write out the profiling data in pprof profile format.  Every call site that
+ * has profiling data becomes a sample whose call stack is made up of locations
+ * that are shared between all call sites with the same return address, and
+ * every symbol becomes a function.
+ */
+
+static
+void
+writepprof(void)
+{
+    static char *s[PS_NAMES] =
+    {
+        "", "alloc_objects", "count", "alloc_space", "bytes", "inuse_objects",
+        "inuse_space"
+    };
+    static unsigned long u[4][2] =
+    {
+        {PS_ALLOCOBJECTS, PS_COUNT}, {PS_ALLOCSPACE, PS_BYTES},
+        {PS_INUSEOBJECTS, PS_COUNT}, {PS_INUSESPACE, PS_BYTES}
+    };
+    buffer b, m, t;
+    profiledata *d;
+    profilenode *n, *p;
+    unsigned long *l, *o;
+    size_t a[4];
+    size_t i, j, k;
+
+    b.data = m.data = t.data = NULL;
+    b.size = m.size = t.size = 0;
+    b.max = m.max = t.max = 0;
+    if (((l = (unsigned long *) calloc(nodesize + 1,
+           sizeof(unsigned long))) == NULL) ||
+        ((o = (unsigned long *) calloc(nodesize + 1,
+           sizeof(unsigned long))) == NULL))
+    {
+        fprintf(stderr, "%s: Out of memory\n", progname);
+        exit(EXIT_FAILURE);
+    }
+    /* Write out the sample types.
+     */
+    for (i = 0; i < 4; i++)
+    {
+        putnumber(&m, 1, u[i][0]);
+        putnumber(&m, 2, u[i][1]);
+        putmessage(&b, 1, &m);
+    }
+    /* Write out one location for every distinct return address.  The call
+     * sites are sorted by return address in the profiling tree so we only
+     * need to compare each one with its predecessor.  We also note the name
+     * of every symbol that is referenced.
+     */
+    for (n = (profilenode *) __mp_minimum(proftree.root), p = NULL, k = 0;
+         n != NULL; p = n, n = (profilenode *) __mp_successor(&n->node))
+    {
+        if ((p == NULL) || (p->addr != n->addr))
+        {
+            putnumber(&m, 1, ++k);
+            putnumber(&m, 3, (unsigned long) n->addr);
+            if (n->symbol != 0)
+            {
+                putnumber(&t, 1, n->symbol);
+                putmessage(&m, 4, &t);
+            }
+            putmessage(&b, 4, &m);
+        }
+        l[n - nodes] = k;
+        if ((n->symbol != 0) && (n->symbol <= nodesize))
+            o[n->symbol] = n->name;
+    }
+    /* Write out one sample for every call site that has profiling data.
+     */
+    for (i = 0; i < nodesize; i++)
+    {
+        n = &nodes[i];
+        if (n->data == 0)
+            continue;
+        for (p = n; p != NULL;
+             p = (p->parent != 0) ? &nodes[p->parent - 1] : NULL)
+            putvarint(&t, l[p - nodes]);
+        putmessage(&m, 1, &t);
+        d = &data[n->data - 1];
+        for (j = 0; j < 4; j++)
+            a[j] = 0;
+        for (j = 0; j < 4; j++)
+        {
+            a[0] += d->acount[j];
+            a[1] += d->atotal[j];
+            a[2] += d->acount[j] - d->dcount[j];
+            a[3] += d->atotal[j] - d->dtotal[j];
+        }
+        for (j = 0; j < 4; j++)
+            putvarint(&t, a[j]);
+        putmessage(&m, 2, &t);
+        putmessage(&b, 2, &m);
+    }
+    /* Write out the functions and the string table.
+     */
+    for (i = 1, k = 0; i <= nodesize; i++)
+        if (o[i] != 0)
+        {
+            putnumber(&m, 1, i);
+            putnumber(&m, 2, PS_NAMES + k);
+            putnumber(&m, 3, PS_NAMES + k);
+            putmessage(&b, 5, &m);
+            k++;
+        }
+    for (i = 0; i < PS_NAMES; i++)
+        putbytes(&b, 6, s[i], strlen(s[i]));
+    for (i = 1; i <= nodesize; i++)
+        if (o[i] != 0)
+            putbytes(&b, 6, symbols + o[i], strlen(symbols + o[i]));
+    putnumber(&b, 14, PS_INUSESPACE);
+    writegzip(pproffile, &b);
+    free(l);
+    free(o);
+    if (b.data != NULL)
+        free(b.data);
+    if (m.data != NULL)
+        free(m.data);
+    if (t.data != NULL)
+        free(t.data);
+}
+
+
+/* Determine the value of a call site for the folded stacks and flame graph.
+ */
+
+static
+size_t
+framevalue(profiledata *d)
+{
+    size_t i, t;
+
+    for (i = t = 0; i < 4; i++)
+        if (showcounts)
+        {
+            if (flametype == 0)
+                t += d->acount[i];
+            else if (flametype == 1)
+                t += d->acount[i] - d->dcount[i];
+            else
+                t += d->dcount[i];
+        }
+        else
+        {
+            if (flametype == 0)
+                t += d->atotal[i];
+            else if (flametype == 1)
+                t += d->atotal[i] - d->dtotal[i];
+            else
+                t += d->dtotal[i];
+        }
+    return t;
+}
+
+
+/* Locate or create the frame that corresponds to a call site.  Call sites
+ * with the same caller frame and the same function share a frame unless
+ * different call sites within a function are being differentiated.  The
+ * frames are kept in an open-addressed hash table keyed on the caller frame
+ * and the label of the call site.
+ */
+
+static
+unsigned long
+getframe(profilenode *n, unsigned long *l, unsigned long *f,
+         unsigned long *h, size_t m)
+{
+    frame *r;
+    unsigned long k, p;
+    size_t i;
+
+    if (f[n - nodes] != 0)
+        return f[n - nodes];
+    if (n->parent != 0)
+        p = getframe(&nodes[n->parent - 1], l, f, h, m);
+    else
+        p = 0;
+    if (!useaddresses && (n->symbol != 0))
+        k = n->symbol;
+    else
+        k = nodesize + l[n - nodes];
+    for (i = ((p * 0x9E3779B1UL) ^ k) & m; h[i] != 0; i = (i + 1) & m)
+    {
+        r = &frames[h[i]];
+        if ((r->parent == p) && (r->label == k))
+            return f[n - nodes] = h[i];
+    }
+    h[i] = framesize;
+    r = &frames[framesize];
+    r->parent = p;
+    r->label = k;
+    r->pnode = n;
+    r->total = r->self = 0;
+    r->depth = frames[p].depth + 1;
+    r->child = 0;
+    r->next = frames[p].child;
+    frames[p].child = framesize;
+    if (r->depth > flamedepth)
+        flamedepth = r->depth;
+    return f[n - nodes] = framesize++;
+}
+
+
+/* Build the tree of frames for the folded stacks and flame graph and
+ * calculate the inclusive and exclusive value of every frame.  Every step
+ * takes time proportional to the number of call sites.
+ */
+
+static
+void
+buildframes(void)
+{
+    profilenode *n, *p;
+    unsigned long *f, *h, *l;
+    size_t i, k, m;
+
+    for (m = 1; m < (nodesize + 1) * 2; m <<= 1);
+    if (((frames = (frame *) malloc((nodesize + 1) * sizeof(frame))) ==
+         NULL) ||
+        ((l = (unsigned long *) calloc(nodesize + 1, sizeof(unsigned long))) ==
+         NULL) ||
+        ((f = (unsigned long *) calloc(nodesize + 1, sizeof(unsigned long))) ==
+         NULL) ||
+        ((h = (unsigned long *) calloc(m, sizeof(unsigned long))) == NULL))
+    {
+        fprintf(stderr, "%s: Out of memory\n", progname);
+        exit(EXIT_FAILURE);
+    }
+    /* The first frame is the root of the tree and represents all of the
+     * call stacks.
+     */
+    frames[0].parent = frames[0].label = 0;
+    frames[0].pnode = NULL;
+    frames[0].total = frames[0].self = 0;
+    frames[0].depth = 0;
+    frames[0].child = frames[0].next = 0;
+    framesize = 1;
+    flamedepth = 0;
+    /* Give every distinct return address a label, which is used for call
+     * sites that have no symbol or when call site offsets are displayed.
+     */
+    for (n = (profilenode *) __mp_minimum(proftree.root), p = NULL, k = 0;
+         n != NULL; p = n, n = (profilenode *) __mp_successor(&n->node))
+    {
+        if ((p == NULL) || (p->addr != n->addr))
+            k++;
+        l[n - nodes] = k;
+    }
+    for (i = 0; i < nodesize; i++)
+    {
+        n = &nodes[i];
+        if (n->data != 0)
+            frames[getframe(n, l, f, h, m - 1)].self +=
+                framevalue(&data[n->data - 1]);
+    }
+    /* A frame is always created after its parent frame so we can calculate
+     * the inclusive values by visiting the frames in reverse order.
+     */
+    for (i = framesize - 1; i > 0; i--)
+    {
+        frames[i].total += frames[i].self;
+        frames[frames[i].parent].total += frames[i].total;
+    }
+    free(l);
+    free(f);
+    free(h);
+}
+
+
+/* Write out the call stack of a frame in folded format.
+ */
+
+static
+void
+printframes(frame *r)
+{
+    if (r->parent != 0)
+    {
+        printframes(&frames[r->parent]);
+        fputc(';', foldedfile);
+    }
+    printsymbol(foldedfile, r->pnode);
+}
+
+
+/* Write out one line in folded format for every frame that has a value of
+ * its own.
+ */
+
+static
+void
+writefolded(void)
+{
+    size_t i;
+
+    for (i = 1; i < framesize; i++)
+        if (frames[i].self > 0)
+        {
+            printframes(&frames[i]);
+            fprintf(foldedfile, " %lu\n", frames[i].self);
+        }
+}
+
+
+/* Write out up to a specified number of characters from a string with any
+ * characters that are special in XML escaped.
+ */
+
+static
+void
+printxml(FILE *f, char *s, size_t l)
+{
+    for (; (*s != '\0') && (l > 0); s++, l--)
+        if (*s == '&')
+            fputs("&amp;", f);
+        else if (*s == '<')
+            fputs("&lt;", f);
+        else if (*s == '>')
+            fputs("&gt;", f);
+        else if (*s == '"')
+            fputs("&quot;", f);
+        else
+            fputc(*s, f);
+}
+
+
+/* Write out the name of a frame in a flame graph, truncating it if it will
+ * not fit within the specified number of characters.
+ */
+
+static
+void
+printlabel(FILE *f, profilenode *n, size_t l)
+{
+    char b[64];
+    char *s;
+
+    if (n->name != 0)
+        s = symbols + n->name;
+    else
+    {
+        sprintf(b, MP_POINTER, n->addr);
+        s = b;
+    }
+    if (strlen(s) <= l)
+        printxml(f, s, l);
+    else if (l > 2)
+    {
+        printxml(f, s, l - 2);
+        fputs("..", f);
+    }
+}
+
+
+/* Write out a frame and all of its children in a flame graph.
+ */
+
+static
+void
+writeflame(frame *r, size_t x, double s)
+{
+    frame *c;
+    unsigned long h, i;
+    char *p;
+    double w;
+
+    w = r->total * s;
+    if (w < 0.1)
+        return;
+    if (r->pnode != NULL)
+    {
+        /* The colour of each frame is derived from its name so that the same
+         * function always has the same colour.
+         */
+        h = 0;
+        if (r->pnode->name != 0)
+            for (p = symbols + r->pnode->name; *p != '\0'; p++)
+                h = (h * 31) + (unsigned char) *p;
+        else
+            h = (unsigned long) r->pnode->addr >> 4;
+        fputs("<g><title>", flamefile);
+        printlabel(flamefile, r->pnode, (size_t) -1);
+        fprintf(flamefile, " (%lu %s, %.2f%%)</title>", r->total,
+                showcounts ? "allocations" : "bytes",
+                frames[0].total ? r->total * 100.0 / frames[0].total : 0.0);
+        fprintf(flamefile, "<rect x=\"%.1f\" y=\"%lu\" width=\"%.1f\" "
+                "height=\"15\" fill=\"rgb(%lu,%lu,%lu)\" rx=\"2\"/>",
+                10.0 + x * s, (flamedepth - r->depth) * 16 + 40, w,
+                205 + (h % 50), 80 + ((h >> 8) % 150), (h >> 16) % 55);
+        if (w >= 21.0)
+        {
+            fprintf(flamefile, "<text x=\"%.1f\" y=\"%lu\">", 13.0 + x * s,
+                    (flamedepth - r->depth) * 16 + 51);
+            printlabel(flamefile, r->pnode, (size_t) ((w - 6.0) / 7.0));
+            fputs("</text>", flamefile);
+        }
+        fputs("</g>\n", flamefile);
+    }
+    for (i = r->child; i != 0; i = c->next)
+    {
+        c = &frames[i];
+        writeflame(c, x, s);
+        x += c->total;
+    }
+}
+
+
+/* Write out the flame graph in SVG format.  The frames have no particular
+ * order within their parent since sorting them would make this slower than
+ * linear in the number of call sites.
+ */
+
+static
+void
+writesvg(void)
+{
+    static char *t[3] = {"allocated", "unfreed", "freed"};
+    size_t h;
+
+    h = flamedepth * 16 + 60;
+    fprintf(flamefile, "<?xml version=\"1.0\" standalone=\"no\"?>\n"
+            "<svg version=\"1.1\" width=\"1200\" height=\"%lu\" "
+            "xmlns=\"http://www.w3.org/2000/svg\">\n", h);
+    fprintf(flamefile, "<rect x=\"0\" y=\"0\" width=\"1200\" height=\"%lu\" "
+            "fill=\"#f8f8f8\"/>\n", h);
+    fputs("<g font-family=\"monospace\" font-size=\"12\">\n", flamefile);
+    fprintf(flamefile, "<text x=\"600\" y=\"24\" text-anchor=\"middle\" "
+            "font-size=\"17\">%s %s</text>\n", t[flametype],
+            showcounts ? "allocations" : "bytes");
+    if (frames[0].total > 0)
+        writeflame(&frames[0], 0, 1180.0 / frames[0].total);
+    fputs("</g>\n</svg>\n", flamefile);
+}
+
+
 /* Read the profiling output file and display all specified information.
  */
 
@@ -1427,10 +2769,10 @@ int
 main(int argc, char **argv)
 {
     char b[256];
-    char *f, *g;
+    char *f, *g, *k, *l, *p;
     int c, e, h, r, v;
 
-    g = NULL;
+    g = k = l = p = NULL;
     e = h = v = 0;
     r = EXIT_SUCCESS;
     maxstack = 1;
@@ -1448,6 +2790,26 @@ main(int argc, char **argv)
           case OF_COUNTS:
             showcounts = 1;
             break;
+          case OF_FLAMEFILE:
+            l = __mp_optarg;
+            break;
+          case OF_FLAMETYPE:
+            if (strcmp(__mp_optarg, "allocated") == 0)
+                flametype = 0;
+            else if (strcmp(__mp_optarg, "unfreed") == 0)
+                flametype = 1;
+            else if (strcmp(__mp_optarg, "freed") == 0)
+                flametype = 2;
+            else
+            {
+                fprintf(stderr, "%s: Unrecognised flame graph type `%s'\n",
+                        progname, __mp_optarg);
+                e = 1;
+            }
+            break;
+          case OF_FOLDEDFILE:
+            k = __mp_optarg;
+            break;
           case OF_GRAPHFILE:
             g = __mp_optarg;
             break;
@@ -1457,6 +2819,15 @@ main(int argc, char **argv)
           case OF_LEAKS:
             showleaks = 1;
             break;
+          case OF_LIFETIME:
+            if (!__mp_getnum(progname, __mp_optarg, (long *) &maxlife, 1))
+                e = 1;
+            else
+                showlife = 1;
+            break;
+          case OF_PPROFFILE:
+            p = __mp_optarg;
+            break;
           case OF_STACKDEPTH:
             if (!__mp_getnum(progname, __mp_optarg, (long *) &maxstack, 1))
                 e = 1;
@@ -1510,8 +2881,15 @@ main(int argc, char **argv)
     nodesize = 0;
     addrs = NULL;
     symbols = NULL;
+    symsize = strsize = 0;
+    symlist = NULL;
+    snapshots = NULL;
+    threads = NULL;
+    threadsize = 0;
+    snapsize = 0;
     sbound = mbound = lbound = 0;
     __mp_newtree(&proftree);
+    __mp_newtree(&symtree);
     __mp_newtree(&temptree);
     __mp_newlist(&edgelist);
     __mp_newgraph(&graph);
@@ -1529,6 +2907,21 @@ main(int argc, char **argv)
     directtable();
     fputs("\n\n", stdout);
     leaktable();
+    if (showlife)
+    {
+        fputs("\n\n", stdout);
+        lifetable();
+    }
+    if (threadsize > 1)
+    {
+        fputs("\n\n", stdout);
+        threadtable();
+    }
+    if (snapsize > 1)
+    {
+        fputs("\n\n", stdout);
+        snapshottable();
+    }
     /* The reason that the allocation call graph is not used for the direct
      * allocation and memory leak tables is that the code to build and display
      * the allocation call graph was added much later.  Rather than convert
@@ -1566,6 +2959,64 @@ main(int argc, char **argv)
                 fclose(graphfile);
         }
     }
+    if (p != NULL)
+    {
+        if (strcmp(p, "stdout") == 0)
+            pproffile = stdout;
+        else if (strcmp(p, "stderr") == 0)
+            pproffile = stderr;
+        else if ((pproffile = fopen(p, "wb")) == NULL)
+        {
+            fprintf(stderr, "%s: Cannot open file `%s'\n", progname, p);
+            r = EXIT_FAILURE;
+        }
+        if (pproffile != NULL)
+        {
+            writepprof();
+            if ((pproffile != stdout) && (pproffile != stderr))
+                fclose(pproffile);
+        }
+    }
+    if ((k != NULL) || (l != NULL))
+        buildframes();
+    if (k != NULL)
+    {
+        if (strcmp(k, "stdout") == 0)
+            foldedfile = stdout;
+        else if (strcmp(k, "stderr") == 0)
+            foldedfile = stderr;
+        else if ((foldedfile = fopen(k, "w")) == NULL)
+        {
+            fprintf(stderr, "%s: Cannot open file `%s'\n", progname, k);
+            r = EXIT_FAILURE;
+        }
+        if (foldedfile != NULL)
+        {
+            writefolded();
+            if ((foldedfile != stdout) && (foldedfile != stderr))
+                fclose(foldedfile);
+        }
+    }
+    if (l != NULL)
+    {
+        if (strcmp(l, "stdout") == 0)
+            flamefile = stdout;
+        else if (strcmp(l, "stderr") == 0)
+            flamefile = stderr;
+        else if ((flamefile = fopen(l, "w")) == NULL)
+        {
+            fprintf(stderr, "%s: Cannot open file `%s'\n", progname, l);
+            r = EXIT_FAILURE;
+        }
+        if (flamefile != NULL)
+        {
+            writesvg();
+            if ((flamefile != stdout) && (flamefile != stderr))
+                fclose(flamefile);
+        }
+    }
+    if (frames != NULL)
+        free(frames);
     deletegraph();
     if (acounts != NULL)
         free(acounts);
@@ -1579,5 +3030,9 @@ main(int argc, char **argv)
         free(addrs);
     if (symbols != NULL)
         free(symbols);
+    if (snapshots != NULL)
+        free(snapshots);
+    if (threads != NULL)
+        free(threads);
     return r;
 }
@@ -0,0 +1,363 @@
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * A tool designed to read the live statistics page published by the
+ * mpatrol library when the STATSFILE option is used, and to display
+ * the heap statistics of the running program at regular intervals.
+ * The statistics page is read without entering the mpatrol library,
+ * so the program being monitored is never stopped.
+ */
+
+
+#include "getopt.h"
+#include "stats.h"
+#include "version.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if MP_SHM_SUPPORT
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif /* MP_SHM_SUPPORT */
+
+
+#if MP_IDENT_SUPPORT
+#ident "$Id$"
+#else /* MP_IDENT_SUPPORT */
+static MP_CONST MP_VOLATILE char *mpstat_id = "$Id$";
+#endif /* MP_IDENT_SUPPORT */
+
+
+#define PROGVERSION "1.0" /* the current version of this program */
+
+
+/* The flags used to parse the command line options.
+ */
+
+typedef enum options_flags
+{
+    OF_CLASSES  = 'c',
+    OF_HELP     = 'h',
+    OF_INTERVAL = 'i',
+    OF_COUNT    = 'n',
+    OF_VERSION  = 'V'
+}
+options_flags;
+
+
+/* The statistics page that is mapped from the shared memory object.
+ */
+
+static statspage *page;
+
+
+/* The filename used to invoke this tool.
+ */
+
+static char *progname;
+
+
+/* Indicates that the size classes should be displayed with each sample.
+ */
+
+static int showclasses;
+
+
+/* The number of milliseconds between each sample.
+ */
+
+static unsigned long interval;
+
+
+/* The number of samples to display, or zero if samples should be displayed
+ * until the program being monitored terminates.
+ */
+
+static unsigned long count;
+
+
+/* The table describing all recognised options.
+ */
+
+static option options_table[] =
+{
+    {"classes", OF_CLASSES, NULL,
+     "\tSpecifies that the number of live memory allocations in each size\n"
+     "\tclass should be displayed with each sample.\n"},
+    {"count", OF_COUNT, "number",
+     "\tSpecifies the number of samples to display before exiting.\n"},
+    {"help", OF_HELP, NULL,
+     "\tDisplays this quick-reference option summary.\n"},
+    {"interval", OF_INTERVAL, "milliseconds",
+     "\tSpecifies the number of milliseconds to wait between each sample.\n"},
+    {"version", OF_VERSION, NULL,
+     "\tDisplays the version number of this program.\n"},
+    {NULL, 0, NULL, NULL}
+};
+
+
+#if MP_SHM_SUPPORT
+/* Map the statistics page from the shared memory object and check that it
+ * was written by a compatible version of the mpatrol library.
+ */
+
+static
+void
+openpage(char *s)
+{
+    char b[256];
+    struct stat t;
+    void *a;
+    int f;
+
+    if (*s == '/')
+        strncpy(b, s, sizeof(b) - 1);
+    else
+    {
+        b[0] = '/';
+        strncpy(b + 1, s, sizeof(b) - 2);
+    }
+    b[sizeof(b) - 1] = '\0';
+    if ((f = shm_open(b, O_RDONLY, 0)) == -1)
+    {
+        fprintf(stderr, "%s: Cannot open shared memory object `%s'\n",
+                progname, b);
+        exit(EXIT_FAILURE);
+    }
+    if ((fstat(f, &t) == -1) || (t.st_size < (off_t) sizeof(statspage)) ||
+        ((a = mmap(NULL, sizeof(statspage), PROT_READ, MAP_SHARED, f, 0)) ==
+         (void *) MAP_FAILED))
+    {
+        fprintf(stderr, "%s: Cannot map shared memory object `%s'\n",
+                progname, b);
+        exit(EXIT_FAILURE);
+    }
+    close(f);
+    page = (statspage *) a;
+    if (memcmp(page->magic, MP_STATSMAGIC, 4) != 0)
+    {
+        fprintf(stderr, "%s: Invalid statistics page `%s'\n", progname, b);
+        exit(EXIT_FAILURE);
+    }
+    __mp_membarrier();
+    if ((page->size != sizeof(statspage)) || (page->bins != MP_STATBIN_SIZE))
+    {
+        fprintf(stderr, "%s: Statistics page `%s' was written by a different "
+                "version of mpatrol\n", progname, b);
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+/* Take a consistent copy of the statistics page.  If the sequence number is
+ * odd or changes while the page is being copied then the library was in the
+ * middle of updating it, so we must try again.
+ */
+
+static
+void
+readpage(statspage *p)
+{
+    struct timespec t;
+    unsigned long s;
+    size_t i;
+
+    for (i = 0; ; i++)
+    {
+        if (!((s = page->seq) & 1))
+        {
+            __mp_membarrier();
+            memcpy(p, (void *) page, sizeof(statspage));
+            __mp_membarrier();
+            if (page->seq == s)
+                break;
+        }
+        /* Give the program being monitored a chance to finish updating the
+         * page if it appears to have been preempted during an update.
+         */
+        if (i % 1000 == 999)
+        {
+            t.tv_sec = 0;
+            t.tv_nsec = 1000;
+            nanosleep(&t, NULL);
+        }
+    }
+}
+
+
+/* Wait for the specified number of milliseconds.
+ */
+
+static
+void
+waitfor(unsigned long n)
+{
+    struct timespec t;
+
+    t.tv_sec = n / 1000;
+    t.tv_nsec = (n % 1000) * 1000000;
+    while ((nanosleep(&t, &t) == -1) && (errno == EINTR));
+}
+
+
+/* Display the live memory allocations in each size class.
+ */
+
+static
+void
+printclasses(statspage *p)
+{
+    size_t i;
+
+    for (i = 0; i < MP_STATBIN_SIZE; i++)
+        if (p->ccount[i] != 0)
+        {
+            if (i == MP_STATBIN_SIZE - 1)
+                fprintf(stdout, "    %10lu+           ", 1UL << i);
+            else
+                fprintf(stdout, "    %10lu - %-10lu", 1UL << i,
+                        (1UL << (i + 1)) - 1);
+            fprintf(stdout, " %10lu %12lu\n", (unsigned long) p->ccount[i],
+                    (unsigned long) p->ctotal[i]);
+        }
+    fputc('\n', stdout);
+}
+
+
+/* Display the heap statistics at regular intervals until the program being
+ * monitored terminates or the requested number of samples have been shown.
+ */
+
+static
+void
+monitor(void)
+{
+    statspage p;
+    unsigned long e, n, r;
+    size_t i;
+
+    e = 0;
+    for (n = 0; (count == 0) || (n < count); n++)
+    {
+        if (n > 0)
+            waitfor(interval);
+        readpage(&p);
+        if (n % 20 == 0)
+            fprintf(stdout, "%10s %10s %10s %12s %12s %10s\n", "events",
+                    "events/s", "blocks", "bytes", "peak", "internal");
+        r = (n == 0) ? 0 : (p.event - e) * 1000 / (interval ? interval : 1);
+        e = p.event;
+        i = p.hsize + p.tsize + p.ssize + p.lsize + p.psize + p.isize;
+        fprintf(stdout, "%10lu %10lu %10lu %12lu %12lu %10lu\n", p.event, r,
+                (unsigned long) p.acount, (unsigned long) p.atotal,
+                (unsigned long) p.peak, (unsigned long) i);
+        if (showclasses)
+            printclasses(&p);
+        fflush(stdout);
+        /* Stop once the program being monitored has terminated, since the
+         * statistics page will no longer change.
+         */
+        if ((kill((pid_t) p.pid, 0) == -1) && (errno == ESRCH))
+            break;
+    }
+}
+#endif /* MP_SHM_SUPPORT */
+
+
+int
+main(int argc, char **argv)
+{
+    char b[256];
+    int c, e, h, v;
+
+    e = h = v = 0;
+    interval = 1000;
+    count = 0;
+    progname = __mp_basename(argv[0]);
+    while ((c = __mp_getopt(argc, argv, __mp_shortopts(b, options_table),
+             options_table)) != EOF)
+        switch (c)
+        {
+          case OF_CLASSES:
+            showclasses = 1;
+            break;
+          case OF_COUNT:
+            if (!__mp_getnum(progname, __mp_optarg, (long *) &count, 1))
+                e = 1;
+            break;
+          case OF_HELP:
+            h = 1;
+            break;
+          case OF_INTERVAL:
+            if (!__mp_getnum(progname, __mp_optarg, (long *) &interval, 1))
+                e = 1;
+            break;
+          case OF_VERSION:
+            v = 1;
+            break;
+          default:
+            e = 1;
+            break;
+        }
+    argc -= __mp_optindex;
+    argv += __mp_optindex;
+    if (v == 1)
+    {
+        fprintf(stdout, "%s %s\n%s %s\n\n", progname, PROGVERSION,
+                __mp_copyright, __mp_author);
+        fputs("This is free software, and you are welcome to redistribute it "
+              "under certain\n", stdout);
+        fputs("conditions; see the GNU Lesser General Public License for "
+              "details.\n\n", stdout);
+        fputs("For the latest mpatrol release and documentation,\n", stdout);
+        fprintf(stdout, "visit %s.\n\n", __mp_homepage);
+    }
+    if ((argc != 1) && ((v == 0) || (argc > 1)))
+        e = 1;
+    if ((e == 1) || (h == 1))
+    {
+        fprintf(stdout, "Usage: %s [options] name\n\n", progname);
+        if (h == 0)
+            fprintf(stdout, "Type `%s --help' for a complete list of "
+                    "options.\n", progname);
+        else
+            __mp_showopts(options_table);
+        if (e == 1)
+            exit(EXIT_FAILURE);
+        exit(EXIT_SUCCESS);
+    }
+    if (argc == 0)
+        exit(EXIT_SUCCESS);
+#if MP_SHM_SUPPORT
+    openpage(argv[0]);
+    monitor();
+    return EXIT_SUCCESS;
+#else /* MP_SHM_SUPPORT */
+    fprintf(stderr, "%s: Shared memory objects are not supported on this "
+            "system\n", progname);
+    return EXIT_FAILURE;
+#endif /* MP_SHM_SUPPORT */
+}
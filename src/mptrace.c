@@ -23,11 +23,11 @@
  * library and display the tracing information that was obtained.  It can
  * also produce a C source file containing a trace-driven memory allocation
  * simulation of the program which produced the corresponding tracing output
- * file.
+ * file, or a Chrome trace event file for viewing alongside other timelines.
  */
 
 
-#include "tree.h"
+#include "hash.h"
 #include "slots.h"
 #include "getopt.h"
 #include "utils.h"
@@ -56,13 +56,15 @@ static MP_CONST MP_VOLATILE char *mptrace_id = "$Id$";
 
 typedef enum options_flags
 {
-    OF_HATFFILE = 'H',
-    OF_HELP     = 'h',
-    OF_SIMFILE  = 'S',
-    OF_SOURCE   = 's',
-    OF_VERSION  = 'V',
-    OF_VERBOSE  = 'v',
-    OF_GUI      = 'w'
+    OF_CHROMEFILE = 'C',
+    OF_HATFFILE   = 'H',
+    OF_HELP       = 'h',
+    OF_LARGESIZE  = 'L',
+    OF_SIMFILE    = 'S',
+    OF_SOURCE     = 's',
+    OF_VERSION    = 'V',
+    OF_VERBOSE    = 'v',
+    OF_GUI        = 'w'
 }
 options_flags;
 
@@ -72,16 +74,28 @@ options_flags;
 
 typedef struct allocation
 {
-    treenode node;       /* tree node */
     unsigned long event; /* event number */
     void *entry;         /* pointer array entry */
     void *addr;          /* allocation address */
     size_t size;         /* allocation size */
     unsigned long time;  /* allocation lifetime */
+    unsigned long thread; /* allocating thread */
 }
 allocation;
 
 
+/* Structure containing the number and total size of the allocations made by
+ * a single thread that are still in use.
+ */
+
+typedef struct threadinfo
+{
+    size_t count; /* number of allocated blocks */
+    size_t total; /* total size of allocated blocks */
+}
+threadinfo;
+
+
 /* Structure containing the statistics for a tracing output file.
  */
 
@@ -109,10 +123,27 @@ statistics;
 static unsigned long version;
 
 
-/* The tree containing information about each memory allocation.
+/* The hash table containing information about each memory allocation,
+ * keyed by allocation index.
  */
 
-static treeroot alloctree;
+static hashtable alloctable;
+
+
+/* The slot table from which allocation records are obtained, and the chain
+ * of memory blocks that have been allocated for it.  Records are recycled
+ * as soon as their allocations are freed so that the memory used by this
+ * program depends only on the number of allocations in use at any one time.
+ */
+
+static slottable allocslots;
+static void *allocblocks;
+
+
+/* The highest allocation index that has been seen so far.
+ */
+
+static unsigned long maxindex;
 
 
 /* The number of the current event in the tracing output file.
@@ -165,6 +196,28 @@ static FILE *tracefile;
 static FILE *hatffile;
 
 
+/* The Chrome trace event file produced from the tracing output file, and the
+ * number of trace events that have been written to it so far.
+ */
+
+static FILE *chromefile;
+static unsigned long chromeevents;
+
+
+/* The hash table containing the allocation totals for each thread, keyed by
+ * thread identifier, for use when writing the Chrome trace event file.
+ */
+
+static hashtable threadtable;
+
+
+/* The minimum size of an allocation that will be marked with an instant event
+ * in the Chrome trace event file.
+ */
+
+static unsigned long largesize;
+
+
 /* The simulation file produced from the tracing output file.
  */
 
@@ -315,6 +368,9 @@ static XrmOptionDescRec options[] =
 
 static option options_table[] =
 {
+    {"chrome-file", OF_CHROMEFILE, "file",
+     "\tSpecifies that the trace should also be written to a file in Chrome\n"
+     "\ttrace event format.\n"},
     {"gui", OF_GUI, NULL,
      "\tDisplays the GUI (if supported).\n"},
     {"hatf-file", OF_HATFFILE, "file",
@@ -322,6 +378,9 @@ static option options_table[] =
      "\tAllocation Trace Format (HATF).\n"},
     {"help", OF_HELP, NULL,
      "\tDisplays this quick-reference option summary.\n"},
+    {"large-size", OF_LARGESIZE, "size",
+     "\tSpecifies the minimum size of an allocation that will be marked with\n"
+     "\tan instant event in the Chrome trace event file.\n"},
     {"sim-file", OF_SIMFILE, "file",
      "\tSpecifies that a trace-driven memory allocation simulation program\n"
      "\twritten in C should be written to a file.\n"},
@@ -341,6 +400,25 @@ static option options_table[] =
        (char *) tableslots)) / sizeof(void *))
 
 
+/* Allocate memory for a new block of allocation records or a larger
+ * allocation hash table, exiting if there is not enough memory.
+ */
+
+static
+void *
+getmemory(size_t l)
+{
+    void *p;
+
+    if ((p = malloc(l)) == NULL)
+    {
+        fprintf(stderr, "%s: Out of memory\n", progname);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+
 /* Create a new memory allocation.
  */
 
@@ -349,22 +427,38 @@ allocation *
 newalloc(unsigned long i, unsigned long e, void *a, size_t l)
 {
     allocation *n;
+    void *p;
+    size_t s;
 
-    if ((n = (allocation *) __mp_search(alloctree.root, i)) != NULL)
-    {
-        if (n->time == 0)
-            fprintf(stderr, "%s: Allocation index `%lu' has been allocated "
-                    "twice without being freed\n", progname, i);
-    }
+    if ((n = (allocation *) __mp_hashsearch(&alloctable, i)) != NULL)
+        fprintf(stderr, "%s: Allocation index `%lu' has been allocated "
+                "twice without being freed\n", progname, i);
     else
     {
-        if ((n = (allocation *) malloc(sizeof(allocation))) == NULL)
+        /* Obtain a record from the slot table, adding a new block of memory
+         * to it if it is full, and then insert the record into the hash
+         * table, doubling the size of the hash table if it is full.
+         */
+        if ((n = (allocation *) __mp_getslot(&allocslots)) == NULL)
         {
-            fprintf(stderr, "%s: Out of memory\n", progname);
-            exit(EXIT_FAILURE);
+            s = MP_ALLOCBLOCK * sizeof(allocation);
+            p = getmemory(s);
+            *((void **) p) = allocblocks;
+            allocblocks = p;
+            __mp_initslots(&allocslots, (char *) p + sizeof(void *),
+                           s - sizeof(void *));
+            n = (allocation *) __mp_getslot(&allocslots);
+        }
+        while (!__mp_hashinsert(&alloctable, i, n))
+        {
+            s = (alloctable.mask + 1) * 2 * sizeof(hashbucket);
+            if (s < MP_ALLOCBLOCK * sizeof(hashbucket))
+                s = MP_ALLOCBLOCK * sizeof(hashbucket);
+            free(__mp_rehash(&alloctable, getmemory(s), s));
         }
-        __mp_treeinsert(&alloctree, &n->node, i);
         n->event = e;
+        if (maxindex < i)
+            maxindex = i;
     }
     if (simfile != NULL)
     {
@@ -383,6 +477,45 @@ newalloc(unsigned long i, unsigned long e, void *a, size_t l)
 }
 
 
+/* Return the record for an existing memory allocation, displaying a warning
+ * if the allocation index is not known.
+ */
+
+static
+allocation *
+findalloc(unsigned long i)
+{
+    allocation *n;
+
+    if ((n = (allocation *) __mp_hashsearch(&alloctable, i)) == NULL)
+    {
+        /* Allocation indices are assigned in increasing order by the mpatrol
+         * library, so if we have already seen a higher index then this
+         * allocation must have been freed and its record recycled.
+         */
+        if ((i != 0) && (i <= maxindex))
+            fprintf(stderr, "%s: Allocation index `%lu' has already been "
+                    "freed\n", progname, i);
+        else
+            fprintf(stderr, "%s: Unknown allocation index `%lu'\n", progname,
+                    i);
+    }
+    return n;
+}
+
+
+/* Free an existing memory allocation and recycle its record.
+ */
+
+static
+void
+freealloc(unsigned long i, allocation *n)
+{
+    __mp_hashremove(&alloctable, i);
+    __mp_freeslot(&allocslots, n);
+}
+
+
 /* Free all existing memory allocations.
  */
 
@@ -390,14 +523,25 @@ static
 void
 freeallocs(void)
 {
-    allocation *n, *p;
+    void *p;
+    size_t i;
 
-    for (n = (allocation *) __mp_minimum(alloctree.root); n != NULL; n = p)
+    while ((p = allocblocks) != NULL)
+    {
+        allocblocks = *((void **) p);
+        free(p);
+    }
+    if (alloctable.buckets != NULL)
+        free(alloctable.buckets);
+    __mp_newhash(&alloctable);
+    if (threadtable.buckets != NULL)
     {
-        p = (allocation *) __mp_successor(&n->node);
-        __mp_treeremove(&alloctree, &n->node);
-        free(n);
+        for (i = 0; i <= threadtable.mask; i++)
+            if (threadtable.buckets[i].data != NULL)
+                free(threadtable.buckets[i].data);
+        free(threadtable.buckets);
     }
+    __mp_newhash(&threadtable);
 }
 
 
@@ -810,6 +954,169 @@ printsource(unsigned long i, char *s, char *t, unsigned long u)
 }
 
 
+/* Write a string to the Chrome trace event file as a JSON string.
+ */
+
+static
+void
+chromestring(char *s)
+{
+    fputc('"', chromefile);
+    while (*s != '\0')
+    {
+        if ((*s == '"') || (*s == '\\'))
+            fprintf(chromefile, "\\%c", *s);
+        else if ((unsigned char) *s < ' ')
+            fprintf(chromefile, "\\u%04x", (unsigned char) *s);
+        else
+            fputc(*s, chromefile);
+        s++;
+    }
+    fputc('"', chromefile);
+}
+
+
+/* Begin a new trace event in the Chrome trace event file.  Each trace event
+ * is written as soon as it is read so that the size of the tracing output
+ * file does not affect the amount of memory used by this program.
+ */
+
+static
+void
+chromebegin(void)
+{
+    if (chromeevents++ > 0)
+        fputs(",\n", chromefile);
+    fputc('{', chromefile);
+}
+
+
+/* Return the allocation totals for a thread, creating them and naming the
+ * track for the thread in the Chrome trace event file if necessary.
+ */
+
+static
+threadinfo *
+getthread(unsigned long i)
+{
+    threadinfo *t;
+    size_t s;
+
+    if ((t = (threadinfo *) __mp_hashsearch(&threadtable, i)) == NULL)
+    {
+        t = (threadinfo *) getmemory(sizeof(threadinfo));
+        t->count = t->total = 0;
+        while (!__mp_hashinsert(&threadtable, i, t))
+        {
+            s = (threadtable.mask + 1) * 2 * sizeof(hashbucket);
+            free(__mp_rehash(&threadtable, getmemory(s), s));
+        }
+        chromebegin();
+        fprintf(chromefile, "\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"tid\":%lu,\"args\":{\"name\":\"thread %lu\"}}", i, i);
+    }
+    return t;
+}
+
+
+/* Remove an allocation from the totals for the thread that made it before it
+ * is replaced by another allocation with the same allocation index, which can
+ * only happen if the tracing output file is corrupt.
+ */
+
+static
+void
+chromeforget(allocation *f)
+{
+    threadinfo *p;
+
+    if (f->thread != 0)
+    {
+        p = getthread(f->thread);
+        p->count--;
+        p->total -= f->size;
+    }
+}
+
+
+/* Write a memory event to the Chrome trace event file.  There are no
+ * timestamps in the tracing output file, so the event number is used as the
+ * timestamp for each trace event.  The number and total size of allocations
+ * in use are written as counters after every event, along with the totals for
+ * the thread that made the allocation if thread identifiers are present, and
+ * an instant event is written on the track for the current thread for every
+ * large allocation or reallocation.
+ */
+
+static
+void
+chromeevent(char e, allocation *f, unsigned long n, void *a, size_t l,
+            unsigned long i, char *s, char *t, unsigned long u)
+{
+    threadinfo *p;
+
+    if (e == 'A')
+        f->thread = i;
+    if (f->thread != 0)
+    {
+        p = getthread(f->thread);
+        if (e == 'A')
+        {
+            p->count++;
+            p->total += l;
+        }
+        else if (e == 'R')
+            p->total = p->total - f->size + l;
+        else
+        {
+            p->count--;
+            p->total -= f->size;
+        }
+    }
+    else
+        p = NULL;
+    chromebegin();
+    fprintf(chromefile, "\"name\":\"live bytes\",\"ph\":\"C\",\"ts\":%lu,"
+            "\"pid\":1,\"args\":{\"bytes\":%lu}}", currentevent,
+            stats.atotal - stats.ftotal);
+    chromebegin();
+    fprintf(chromefile, "\"name\":\"live count\",\"ph\":\"C\",\"ts\":%lu,"
+            "\"pid\":1,\"args\":{\"count\":%lu}}", currentevent,
+            stats.acount - stats.fcount);
+    if (p != NULL)
+    {
+        chromebegin();
+        fprintf(chromefile, "\"name\":\"live bytes (thread %lu)\",\"ph\":\"C\","
+                "\"ts\":%lu,\"pid\":1,\"args\":{\"bytes\":%lu}}", f->thread,
+                currentevent, p->total);
+        chromebegin();
+        fprintf(chromefile, "\"name\":\"live count (thread %lu)\",\"ph\":\"C\","
+                "\"ts\":%lu,\"pid\":1,\"args\":{\"count\":%lu}}", f->thread,
+                currentevent, p->count);
+    }
+    if ((e != 'F') && (largesize != 0) && (l >= largesize))
+    {
+        chromebegin();
+        fprintf(chromefile, "\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\","
+                "\"ts\":%lu,\"pid\":1,\"tid\":%lu,\"args\":{\"index\":%lu,"
+                "\"address\":\"0x%lx\",\"size\":%lu", (e == 'A') ? "alloc" :
+                "realloc", currentevent, i, n, a, l);
+        if (s != NULL)
+        {
+            fputs(",\"function\":", chromefile);
+            chromestring(s);
+        }
+        if ((t != NULL) && (u != 0))
+        {
+            fputs(",\"file\":", chromefile);
+            chromestring(t);
+            fprintf(chromefile, ",\"line\":%lu", u);
+        }
+        fputs("}}", chromefile);
+    }
+}
+
+
 /* Display the statistics gathered from the tracing output file.
  */
 
@@ -875,6 +1182,9 @@ readevent(void)
             a = (void *) getuleb128();
             l = getuleb128();
             getsource(&t, &g, &h, &u);
+            if ((chromefile != NULL) &&
+                ((f = (allocation *) __mp_hashsearch(&alloctable, n)) != NULL))
+                chromeforget(f);
             f = newalloc(n, currentevent, a, l);
             stats.acount++;
             stats.atotal += l;
@@ -897,6 +1207,8 @@ readevent(void)
             }
             if (hatffile != NULL)
                 fprintf(hatffile, "1 %lu 0x%lx\n", l, a);
+            if (chromefile != NULL)
+                chromeevent('A', f, n, a, l, t, g, h, u);
             if (f->entry != NULL)
             {
                 if ((m = slotentry(f)) > maxslots)
@@ -921,11 +1233,8 @@ readevent(void)
             a = (void *) getuleb128();
             l = getuleb128();
             getsource(&t, &g, &h, &u);
-            if ((f = (allocation *) __mp_search(alloctree.root, n)) != NULL)
+            if ((f = findalloc(n)) != NULL)
             {
-                if (f->time != 0)
-                    fprintf(stderr, "%s: Allocation index `%lu' has already "
-                            "been freed\n", progname, n);
                 stats.acount++;
                 stats.atotal += l;
                 stats.fcount++;
@@ -949,6 +1258,8 @@ readevent(void)
                 }
                 if (hatffile != NULL)
                     fprintf(hatffile, "4 %lu 0x%lx 0x%lx\n", l, f->addr, a);
+                if (chromefile != NULL)
+                    chromeevent('R', f, n, a, l, t, g, h, u);
                 if (f->entry != NULL)
                 {
                     m = slotentry(f);
@@ -964,9 +1275,6 @@ readevent(void)
                 f->addr = a;
                 f->size = l;
             }
-            else
-                fprintf(stderr, "%s: Unknown allocation index `%lu'\n",
-                        progname, n);
 #if MP_GUI_SUPPORT
             if (usegui)
                 return 0;
@@ -978,11 +1286,8 @@ readevent(void)
             currentevent++;
             n = getuleb128();
             getsource(&t, &g, &h, &u);
-            if ((f = (allocation *) __mp_search(alloctree.root, n)) != NULL)
+            if ((f = findalloc(n)) != NULL)
             {
-                if (f->time != 0)
-                    fprintf(stderr, "%s: Allocation index `%lu' has already "
-                            "been freed\n", progname, n);
                 f->time = currentevent - f->event;
                 stats.fcount++;
                 stats.ftotal += f->size;
@@ -997,6 +1302,8 @@ readevent(void)
                 }
                 if (hatffile != NULL)
                     fprintf(hatffile, "2 0x%lx\n", f->addr);
+                if (chromefile != NULL)
+                    chromeevent('F', f, n, f->addr, f->size, t, g, h, u);
                 if (f->entry != NULL)
                 {
                     fprintf(simfile, "    {%lu, 0, 0},\n", slotentry(f));
@@ -1007,10 +1314,8 @@ readevent(void)
                 if (usegui)
                     drawmemory(f->addr, f->size, frgc);
 #endif /* MP_GUI_SUPPORT */
+                freealloc(n, f);
             }
-            else
-                fprintf(stderr, "%s: Unknown allocation index `%lu'\n",
-                        progname, n);
 #if MP_GUI_SUPPORT
             if (usegui)
                 return 0;
@@ -1059,6 +1364,12 @@ readevent(void)
         }
     if ((hatffile != NULL) && (hatffile != stdout) && (hatffile != stderr))
         fclose(hatffile);
+    if (chromefile != NULL)
+    {
+        fputs("\n]\n", chromefile);
+        if ((chromefile != stdout) && (chromefile != stderr))
+            fclose(chromefile);
+    }
     if (simfile != NULL)
     {
         fputs("    {0, 0, 0}\n};\n\n\n", simfile);
@@ -1195,9 +1506,10 @@ readfile(void)
 int
 main(int argc, char **argv)
 {
+    struct { char x; allocation y; } w;
     struct { char x; void *y; } z;
     char b[256];
-    char *f, *s, *t;
+    char *f, *k, *s, *t;
 #if MP_GUI_SUPPORT
     XGCValues g;
 #endif /* MP_GUI_SUPPORT */
@@ -1210,13 +1522,17 @@ main(int argc, char **argv)
     XtVaGetApplicationResources(appwidget, NULL, resources, XtNumber(resources),
                                 NULL);
 #endif /* MP_GUI_SUPPORT */
-    s = t = NULL;
+    k = s = t = NULL;
     e = h = v = 0;
+    largesize = 65536;
     progname = __mp_basename(argv[0]);
     while ((c = __mp_getopt(argc, argv, __mp_shortopts(b, options_table),
              options_table)) != EOF)
         switch (c)
         {
+          case OF_CHROMEFILE:
+            k = __mp_optarg;
+            break;
           case OF_GUI:
 #if MP_GUI_SUPPORT
             usegui = 1;
@@ -1228,6 +1544,10 @@ main(int argc, char **argv)
           case OF_HELP:
             h = 1;
             break;
+          case OF_LARGESIZE:
+            if (!__mp_getnum(progname, __mp_optarg, (long *) &largesize, 1))
+                e = 1;
+            break;
           case OF_SIMFILE:
             s = __mp_optarg;
             break;
@@ -1275,7 +1595,12 @@ main(int argc, char **argv)
         f = argv[0];
     else
         f = MP_TRACEFILE;
-    __mp_newtree(&alloctree);
+    __mp_newhash(&alloctable);
+    __mp_newhash(&threadtable);
+    n = (char *) &w.y - &w.x;
+    __mp_newslots(&allocslots, sizeof(allocation), __mp_poweroftwo(n));
+    allocblocks = NULL;
+    maxindex = 0;
     if (strcmp(f, "-") == 0)
         tracefile = stdin;
     else if ((tracefile = fopen(f, "rb")) == NULL)
@@ -1330,6 +1655,25 @@ main(int argc, char **argv)
         fprintf(hatffile, "## Description: Converted to HATF by %s %s.\n\n",
                 progname, PROGVERSION);
     }
+    if (k != NULL)
+    {
+        if (strcmp(k, "stdout") == 0)
+            chromefile = stdout;
+        else if (strcmp(k, "stderr") == 0)
+            chromefile = stderr;
+        else if ((chromefile = fopen(k, "w")) == NULL)
+        {
+            fprintf(stderr, "%s: Cannot open file `%s'\n", progname, k);
+            exit(EXIT_FAILURE);
+        }
+        chromeevents = 0;
+        fputs("[\n", chromefile);
+        chromebegin();
+        fputs("\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+              "\"args\":{\"name\":", chromefile);
+        chromestring(f);
+        fputs("}}", chromefile);
+    }
     readfile();
 #if MP_GUI_SUPPORT
     if (usegui)
@@ -115,13 +115,29 @@ static char *options_help[] =
     "FREESTOP", "unsigned integer",
     "", "Specifies an allocation index at which to stop the program when it is",
     "", "being freed.",
+    "GUARDFREQ", "unsigned integer",
+    "", "Specifies that an average of one in every number of memory allocations",
+    "", "that fit within a page should be placed at the end of a page in the",
+    "", "guard page pool, followed by an inaccessible page.",
+    "GUARDPOOL", "unsigned integer",
+    "", "Specifies the number of slots in the guard page pool, each of which",
+    "", "occupies two pages.",
     "HELP", NULL,
     "", "Displays this quick-reference option summary.",
     "HTML", NULL,
     "", "Specifies that the log file should be formatted in HTML.",
+    "HUGEPAGES", NULL,
+    "", "Specifies that the memory allocations should be placed in regions of",
+    "", "memory that are backed by transparent huge pages where supported.",
+    "", "This is ignored if the PAGEALLOC option is used.",
     "LARGEBOUND", "unsigned integer",
     "", "Specifies the limit in bytes up to which memory allocations should be",
     "", "classified as large allocations for profiling purposes.",
+    "LATENCY", NULL,
+    "", "Specifies that the time taken by each mpatrol library entry point and",
+    "", "by each phase of processing within the library should be recorded and",
+    "", "a summary of their latencies displayed at the end of program",
+    "", "execution.",
     "LEAKTABLE", NULL,
     "", "Specifies that the leak table should be automatically used and a leak",
     "", "table summary should be displayed at the end of program execution.",
@@ -179,12 +195,26 @@ static char *options_help[] =
     "PROF", NULL,
     "", "Specifies that all memory allocations are to be profiled and sent to",
     "", "the profiling output file.",
+    "PROFCHECKPOINT", "unsigned integer",
+    "", "Specifies the number of times the profiling output file is written",
+    "", "before a complete profile is appended to it.  In between, only the",
+    "", "call sites that have changed are appended to the file.",
     "PROFFILE", "string",
     "", "Specifies an alternative file in which to place all memory allocation",
     "", "profiling information from the mpatrol library.",
+    "PROFSAMPLE", "unsigned integer",
+    "", "Specifies the average number of bytes of memory that must be allocated",
+    "", "before an allocation is sampled for profiling.  Each sampled allocation",
+    "", "is weighted so that the profiling output file contains estimates of the",
+    "", "total numbers of allocations and bytes for each call site.",
     "PROGFILE", "string",
     "", "Specifies an alternative filename with which to locate the executable",
     "", "file containing the program's symbols.",
+    "QUARANTINE", "unsigned integer",
+    "", "Specifies that recently-freed memory allocations should be prevented",
+    "", "from being returned to the free memory pool until their total size",
+    "", "exceeds a number of bytes, which may have a K, M or G suffix.  Whole",
+    "", "pages within them are returned to the system in the meantime.",
     "REALLOCSTOP", "unsigned integer",
     "", "Specifies an allocation index at which to stop the program when a",
     "", "memory allocation is being reallocated.",
@@ -213,12 +243,29 @@ static char *options_help[] =
     "SMALLBOUND", "unsigned integer",
     "", "Specifies the limit in bytes up to which memory allocations should be",
     "", "classified as small allocations for profiling purposes.",
+    "STATSFILE", "string",
+    "", "Specifies the name of a shared memory object in which to publish the",
+    "", "live heap statistics so that they can be read by the mpstat command",
+    "", "while the program is running.",
     "TRACE", NULL,
     "", "Specifies that all memory allocations are to be traced and sent to",
     "", "the tracing output file.",
     "TRACEFILE", "string",
     "", "Specifies an alternative file in which to place all memory allocation",
     "", "tracing information from the mpatrol library.",
+    "TRACERANGE", "unsigned range",
+    "", "Specifies a range of allocation indices at which to trace memory",
+    "", "allocations, and the frequency at which to sample them.",
+    "TRACESIZE", "unsigned range",
+    "", "Specifies a range of allocation sizes in bytes at which to trace",
+    "", "memory allocations.",
+    "TRACESOURCE", "string",
+    "", "Specifies a comma-separated list of source file and function names",
+    "", "from which memory allocations should be traced.",
+    "TRIM", "unsigned integer",
+    "", "Specifies that free memory should be returned to the system whenever",
+    "", "the total size of the free memory blocks has grown by a number of",
+    "", "bytes, which may have a K, M or G suffix, since it was last returned.",
     "UNFREEDABORT", "unsigned integer",
     "", "Specifies the minimum number of unfreed allocations at which to abort",
     "", "the program just before program termination.",
@@ -308,6 +355,38 @@ readnumber(char *s, long *n, int u)
 }
 
 
+/* Convert a string representation of a size in bytes to an unsigned integer,
+ * allowing an optional K, M or G suffix to specify kilobytes, megabytes or
+ * gigabytes.
+ */
+
+static
+size_t
+readsize(char *s, unsigned long *n)
+{
+    size_t i;
+
+    i = readnumber(s, (long *) n, 1);
+    switch (s[i])
+    {
+      case 'G':
+      case 'g':
+        *n <<= 10;
+      case 'M':
+      case 'm':
+        *n <<= 10;
+      case 'K':
+      case 'k':
+        *n <<= 10;
+        i++;
+        break;
+      default:
+        break;
+    }
+    return i;
+}
+
+
 /* Convert a string representation of a numeric range to two unsigned integers,
  * ensuring that the first integer is less than or equal to the second.  An
  * open range at either end is represented by -1.
@@ -387,6 +466,40 @@ readrange(char *s, unsigned long *l, unsigned long *u, unsigned long *d)
 }
 
 
+/* Add a comma-separated list of source file and function names to the list
+ * of names from which memory allocations should be traced.  The names are
+ * placed in the string table so that they can be compared with any names
+ * obtained from debugging information by pointer.
+ */
+
+static
+void
+addsources(infohead *h, char *s)
+{
+    char *p, *t;
+
+    while (*s != '\0')
+    {
+        for (p = s; (*p != ',') && (*p != '\0'); p++);
+        if (*p != '\0')
+            *p++ = '\0';
+        if (*s != '\0')
+        {
+            if (h->trace.nsources == MP_TRACESOURCES)
+                __mp_warn(ET_MAX, AT_MAX, NULL, 0, "ignoring source name "
+                          "`%s' for option `TRACESOURCE'\n", s);
+            else
+            {
+                if ((t = __mp_addstring(&h->syms.strings, s)) == NULL)
+                    t = s;
+                h->trace.sources[h->trace.nsources++] = t;
+            }
+        }
+        s = p;
+    }
+}
+
+
 /* Display the quick-reference help summary.
  */
 
@@ -418,12 +531,12 @@ MP_GLOBAL
 void
 __mp_parseoptions(infohead *h)
 {
-    char *a, *f, *o, *p, *s, *t;
+    char *a, *f, *o, *p, *s, *t, *w;
     unsigned long d, m, n;
     int i, l, q;
 
     l = 0;
-    f = p = t = NULL;
+    f = p = t = w = NULL;
     if (((s = __mp_getenv(MP_OPTIONS)) == NULL) || (*s == '\0'))
         return;
     if (strlen(s) + 1 > sizeof(options))
@@ -677,6 +790,33 @@ __mp_parseoptions(infohead *h)
                     }
                 }
                 break;
+              case 'G':
+                if (matchoption(o, "GUARDFREQ"))
+                {
+                    if (*a == '\0')
+                        i = OE_NOARGUMENT;
+                    else if (a[readnumber(a, (long *) &n, 1)] != '\0')
+                        i = OE_BADNUMBER;
+                    else
+                    {
+                        h->alloc.sfreq = n;
+                        i = OE_RECOGNISED;
+                    }
+                }
+                else if (matchoption(o, "GUARDPOOL"))
+                {
+                    if (*a == '\0')
+                        i = OE_NOARGUMENT;
+                    else if (a[readnumber(a, (long *) &n, 1)] != '\0')
+                        i = OE_BADNUMBER;
+                    else
+                    {
+                        if (h->alloc.pool == NULL)
+                            h->alloc.pslots = n;
+                        i = OE_RECOGNISED;
+                    }
+                }
+                break;
               case 'H':
                 if (matchoption(o, "HELP"))
                 {
@@ -694,6 +834,18 @@ __mp_parseoptions(infohead *h)
                         i = OE_RECOGNISED;
                     __mp_diagflags |= FLG_HTMLNEXT;
                 }
+                else if (matchoption(o, "HUGEPAGES"))
+                {
+                    if (*a != '\0')
+                        i = OE_IGNARGUMENT;
+                    else
+                        i = OE_RECOGNISED;
+#if MP_HUGEPAGE_SUPPORT
+                    if ((h->alloc.list.size == 0) &&
+                        !(h->alloc.flags & FLG_PAGEALLOC))
+                        h->alloc.heap.memory.flags |= FLG_HUGEPAGES;
+#endif /* MP_HUGEPAGE_SUPPORT */
+                }
                 break;
               case 'L':
                 if (matchoption(o, "LARGEBOUND"))
@@ -709,6 +861,14 @@ __mp_parseoptions(infohead *h)
                             h->prof.lbound = n;
                         i = OE_RECOGNISED;
                     }
+                else if (matchoption(o, "LATENCY"))
+                {
+                    if (*a != '\0')
+                        i = OE_IGNARGUMENT;
+                    else
+                        i = OE_RECOGNISED;
+                    h->stats.timing = 1;
+                }
                 else if (matchoption(o, "LEAKTABLE"))
                 {
                     if (*a != '\0')
@@ -813,7 +973,8 @@ __mp_parseoptions(infohead *h)
                         i = OE_BADNUMBER;
                     else
                     {
-                        if ((h->alloc.fmax = n) != 0UL)
+                        if (((h->alloc.fmax = n) != 0UL) ||
+                            (h->alloc.gmax != 0))
                             h->alloc.flags |= FLG_NOFREE;
                         else
                             h->alloc.flags &= ~FLG_NOFREE;
@@ -874,6 +1035,7 @@ __mp_parseoptions(infohead *h)
                     {
 #if MP_PROTECT_SUPPORT
                         h->alloc.flags |= FLG_PAGEALLOC;
+                        h->alloc.heap.memory.flags &= ~FLG_HUGEPAGES;
                         if (h->alloc.oflow == 0)
                             h->alloc.oflow = 1;
                         h->alloc.oflow = __mp_roundup(h->alloc.oflow,
@@ -885,6 +1047,7 @@ __mp_parseoptions(infohead *h)
                     {
 #if MP_PROTECT_SUPPORT
                         h->alloc.flags |= FLG_PAGEALLOC | FLG_ALLOCUPPER;
+                        h->alloc.heap.memory.flags &= ~FLG_HUGEPAGES;
                         if (h->alloc.oflow == 0)
                             h->alloc.oflow = 1;
                         h->alloc.oflow = __mp_roundup(h->alloc.oflow,
@@ -910,6 +1073,18 @@ __mp_parseoptions(infohead *h)
                         i = OE_RECOGNISED;
                     h->prof.profiling = 1;
                 }
+                else if (matchoption(o, "PROFCHECKPOINT"))
+                {
+                    if (*a == '\0')
+                        i = OE_NOARGUMENT;
+                    else if (a[readnumber(a, (long *) &n, 1)] != '\0')
+                        i = OE_BADNUMBER;
+                    else
+                    {
+                        h->prof.checkpoint = n;
+                        i = OE_RECOGNISED;
+                    }
+                }
                 else if (matchoption(o, "PROFFILE"))
                     if (*a == '\0')
                         i = OE_NOARGUMENT;
@@ -918,6 +1093,18 @@ __mp_parseoptions(infohead *h)
                         p = a;
                         i = OE_RECOGNISED;
                     }
+                else if (matchoption(o, "PROFSAMPLE"))
+                {
+                    if (*a == '\0')
+                        i = OE_NOARGUMENT;
+                    else if (a[readnumber(a, (long *) &n, 1)] != '\0')
+                        i = OE_BADNUMBER;
+                    else
+                    {
+                        h->prof.sample = n;
+                        i = OE_RECOGNISED;
+                    }
+                }
                 else if (matchoption(o, "PROGFILE"))
                 {
                     if (*a == '\0')
@@ -929,6 +1116,24 @@ __mp_parseoptions(infohead *h)
                     }
                 }
                 break;
+              case 'Q':
+                if (matchoption(o, "QUARANTINE"))
+                {
+                    if (*a == '\0')
+                        i = OE_NOARGUMENT;
+                    else if (a[readsize(a, &n)] != '\0')
+                        i = OE_BADNUMBER;
+                    else
+                    {
+                        if (((h->alloc.gmax = n) != 0UL) ||
+                            (h->alloc.fmax != 0))
+                            h->alloc.flags |= FLG_NOFREE;
+                        else
+                            h->alloc.flags &= ~FLG_NOFREE;
+                        i = OE_RECOGNISED;
+                    }
+                }
+                break;
               case 'R':
                 if (matchoption(o, "REALLOCSTOP"))
                 {
@@ -1016,6 +1221,16 @@ __mp_parseoptions(infohead *h)
                         i = OE_RECOGNISED;
                     }
                 }
+                else if (matchoption(o, "STATSFILE"))
+                {
+                    if (*a == '\0')
+                        i = OE_NOARGUMENT;
+                    else
+                    {
+                        w = a;
+                        i = OE_RECOGNISED;
+                    }
+                }
                 break;
               case 'T':
                 if (matchoption(o, "TRACE"))
@@ -1028,7 +1243,6 @@ __mp_parseoptions(infohead *h)
                     h->alloc.heap.tracing = 1;
                 }
                 else if (matchoption(o, "TRACEFILE"))
-                {
                     if (*a == '\0')
                         i = OE_NOARGUMENT;
                     else
@@ -1036,6 +1250,51 @@ __mp_parseoptions(infohead *h)
                         t = a;
                         i = OE_RECOGNISED;
                     }
+                else if (matchoption(o, "TRACERANGE"))
+                    if (*a == '\0')
+                        i = OE_NOARGUMENT;
+                    else if (!readrange(a, &m, &n, &d))
+                        i = OE_BADRANGE;
+                    else
+                    {
+                        h->trace.lrange = (m == (unsigned long) -1) ? 0 : m;
+                        h->trace.urange = n;
+                        h->trace.freq = d;
+                        h->trace.count = 0;
+                        i = OE_RECOGNISED;
+                    }
+                else if (matchoption(o, "TRACESIZE"))
+                    if (*a == '\0')
+                        i = OE_NOARGUMENT;
+                    else if (!readrange(a, &m, &n, &d) || (d != 1))
+                        i = OE_BADRANGE;
+                    else
+                    {
+                        h->trace.lsize = (m == (unsigned long) -1) ? 0 : m;
+                        h->trace.usize = n;
+                        i = OE_RECOGNISED;
+                    }
+                else if (matchoption(o, "TRACESOURCE"))
+                {
+                    if (*a == '\0')
+                        i = OE_NOARGUMENT;
+                    else
+                    {
+                        addsources(h, a);
+                        i = OE_RECOGNISED;
+                    }
+                }
+                else if (matchoption(o, "TRIM"))
+                {
+                    if (*a == '\0')
+                        i = OE_NOARGUMENT;
+                    else if (a[readsize(a, &n)] != '\0')
+                        i = OE_BADNUMBER;
+                    else
+                    {
+                        h->alloc.tmax = n;
+                        i = OE_RECOGNISED;
+                    }
                 }
                 break;
               case 'U':
@@ -1141,7 +1400,8 @@ __mp_parseoptions(infohead *h)
     if (l != 0)
         showoptions();
     /* Set up the filenames of the log, profiling and tracing files if they
-     * were overridden.
+     * were overridden, and the name of the live statistics page if one was
+     * requested.
      */
     if (f != NULL)
         h->log = __mp_logfile(&h->alloc.heap.memory, f);
@@ -1149,6 +1409,8 @@ __mp_parseoptions(infohead *h)
         h->prof.file = __mp_proffile(&h->alloc.heap.memory, p);
     if (t != NULL)
         h->trace.file = __mp_tracefile(&h->alloc.heap.memory, t);
+    if (w != NULL)
+        h->stats.file = __mp_statsfile(&h->alloc.heap.memory, w);
 }
 
 
@@ -1310,12 +1572,14 @@ setflags(infohead *h, unsigned long f, int u)
 }
 
 
-/* Set an mpatrol option after the library has been initialised.
+/* Set an mpatrol option after the library has been initialised.  Any freed
+ * allocations that have to be recycled as a result are checked first and are
+ * reported as if they were detected by the call described by l.
  */
 
 MP_GLOBAL
 unsigned long
-__mp_set(infohead *h, unsigned long o, unsigned long v)
+__mp_set(infohead *h, unsigned long o, unsigned long v, loginfo *l)
 {
     unsigned long r;
 
@@ -1383,9 +1647,9 @@ __mp_set(infohead *h, unsigned long o, unsigned long v)
         h->check = v;
         break;
       case OPT_NOFREE:
-        while (h->alloc.flist.size > v)
-            __mp_recyclefreed(&h->alloc);
-        if ((h->alloc.fmax = v) != 0UL)
+        if ((v != 0) || (h->alloc.gmax == 0))
+            __mp_flushfreed(h, v, l);
+        if (((h->alloc.fmax = v) != 0UL) || (h->alloc.gmax != 0))
             h->alloc.flags |= FLG_NOFREE;
         else
             h->alloc.flags &= ~FLG_NOFREE;
@@ -136,7 +136,8 @@ extern "C"
 
 
 MP_EXPORT void __mp_parseoptions(infohead *);
-MP_EXPORT unsigned long __mp_set(infohead *, unsigned long, unsigned long);
+MP_EXPORT unsigned long __mp_set(infohead *, unsigned long, unsigned long,
+                                 loginfo *);
 MP_EXPORT int __mp_get(infohead *, unsigned long, unsigned long *);
 
 
@@ -53,7 +53,8 @@ extern "C"
 
 MP_GLOBAL
 void
-__mp_newprofile(profhead *p, heaphead *h, symhead *s)
+__mp_newprofile(profhead *p, heaphead *h, symhead *s, leaktab *t,
+                statshead *a)
 {
     struct { char x; profdata y; } w;
     struct { char x; profnode y; } z;
@@ -62,6 +63,8 @@ __mp_newprofile(profhead *p, heaphead *h, symhead *s)
 
     p->heap = h;
     p->syms = s;
+    p->ltable = t;
+    p->stats = a;
     /* Determine the minimum alignment for a profdata structure and a
      * profnode on this system and force the alignments to be a power
      * of two.  This information is used when initialising the slot
@@ -74,6 +77,10 @@ __mp_newprofile(profhead *p, heaphead *h, symhead *s)
     __mp_newlist(&p->ilist);
     __mp_newlist(&p->list);
     __mp_newtree(&p->tree);
+    for (i = 0; i < MP_PROFTAB_SIZE; i++)
+        p->slots[i] = NULL;
+    p->dlist = NULL;
+    p->dsize = 0;
     p->size = 0;
     for (i = 0; i < MP_BIN_SIZE; i++)
         p->acounts[i] = p->dcounts[i] = 0;
@@ -82,6 +89,10 @@ __mp_newprofile(profhead *p, heaphead *h, symhead *s)
     p->mbound = MP_MEDIUMBOUND;
     p->lbound = MP_LARGEBOUND;
     p->autosave = p->autocount = 0;
+    p->sample = p->snext = 0;
+    p->sseed = MP_PROFSEED;
+    p->checkpoint = MP_PROFCHECKPOINT;
+    p->saves = p->nextfull = p->firstsave = 0;
     p->file = __mp_proffile(&h->memory, NULL);
     p->prot = MA_NOACCESS;
     p->protrecur = 0;
@@ -103,6 +114,7 @@ __mp_deleteprofile(profhead *p)
      */
     p->heap = NULL;
     p->syms = NULL;
+    p->ltable = NULL;
     p->dtable.free = NULL;
     p->dtable.size = 0;
     p->ntable.free = NULL;
@@ -110,11 +122,17 @@ __mp_deleteprofile(profhead *p)
     __mp_newlist(&p->ilist);
     __mp_newlist(&p->list);
     __mp_newtree(&p->tree);
+    for (i = 0; i < MP_PROFTAB_SIZE; i++)
+        p->slots[i] = NULL;
+    p->dlist = NULL;
+    p->dsize = 0;
     p->size = 0;
     for (i = 0; i < MP_BIN_SIZE; i++)
         p->acounts[i] = p->dcounts[i] = 0;
     p->atotals = p->dtotals = 0;
     p->autocount = 0;
+    p->snext = 0;
+    p->saves = p->nextfull = p->firstsave = 0;
     p->file = NULL;
     p->prot = MA_NOACCESS;
     p->protrecur = 0;
@@ -130,26 +148,11 @@ profdata *
 getprofdata(profhead *p)
 {
     profdata *d;
-    heapnode *h;
     size_t i;
 
-    /* If we have no more profiling data structure slots left then we must
-     * allocate some more memory for them.  An extra MP_ALLOCFACTOR pages
-     * of memory should suffice.
-     */
-    if ((d = (profdata *) __mp_getslot(&p->dtable)) == NULL)
-    {
-        if ((h = __mp_heapalloc(p->heap, p->heap->memory.page * MP_ALLOCFACTOR,
-              p->dtable.entalign, 1)) == NULL)
-            return NULL;
-        __mp_initslots(&p->dtable, h->block, h->size);
-        d = (profdata *) __mp_getslot(&p->dtable);
-        __mp_addtail(&p->ilist, &d->index.node);
-        d->index.block = h->block;
-        d->index.size = h->size;
-        p->size += h->size;
-        d = (profdata *) __mp_getslot(&p->dtable);
-    }
+    if ((d = (profdata *) __mp_heapslot(p->heap, &p->dtable, &p->ilist,
+          &p->size)) == NULL)
+        return NULL;
     __mp_addtail(&p->list, &d->data.node);
     d->data.index = p->list.size;
     for (i = 0; i < 4; i++)
@@ -157,6 +160,8 @@ getprofdata(profhead *p)
         d->data.acount[i] = d->data.dcount[i] = 0;
         d->data.atotal[i] = d->data.dtotal[i] = 0;
     }
+    for (i = 0; i < MP_LIFEBIN_SIZE; i++)
+        d->data.lcount[i] = d->data.ltotal[i] = 0;
     return d;
 }
 
@@ -168,27 +173,41 @@ static
 profnode *
 getprofnode(profhead *p)
 {
-    profnode *n;
-    heapnode *h;
+    return (profnode *) __mp_heapslot(p->heap, &p->ntable, &p->ilist,
+                                      &p->size);
+}
 
-    /* If we have no more profnode slots left then we must allocate
-     * some more memory for them.  An extra MP_ALLOCFACTOR pages of memory
-     * should suffice.
-     */
-    if ((n = (profnode *) __mp_getslot(&p->ntable)) == NULL)
+
+/* Calculate the hash value of a call stack from its return addresses.
+ */
+
+static
+unsigned long
+hashstack(addrnode *a)
+{
+    unsigned long h;
+
+    for (h = 0; a != NULL; a = a->data.next)
+        h = (h << 5) + h + ((unsigned long) a->data.addr >> 2);
+    return h;
+}
+
+
+/* Note that a call site has changed since the profiling information was last
+ * written.
+ */
+
+static
+void
+markcallsite(profhead *p, profnode *n)
+{
+    if (n->data.change != p->saves + 1)
     {
-        if ((h = __mp_heapalloc(p->heap, p->heap->memory.page * MP_ALLOCFACTOR,
-              p->ntable.entalign, 1)) == NULL)
-            return NULL;
-        __mp_initslots(&p->ntable, h->block, h->size);
-        n = (profnode *) __mp_getslot(&p->ntable);
-        __mp_addtail(&p->ilist, &n->index.node);
-        n->index.block = h->block;
-        n->index.size = h->size;
-        p->size += h->size;
-        n = (profnode *) __mp_getslot(&p->ntable);
+        n->data.change = p->saves + 1;
+        n->data.dnext = p->dlist;
+        p->dlist = n;
+        p->dsize++;
     }
-    return n;
 }
 
 
@@ -201,25 +220,26 @@ getcallsite(profhead *p, addrnode *a)
 {
     profnode *n, *t;
     addrnode *d;
+    unsigned long h, k;
 
-    if ((n = (profnode *) __mp_search(p->tree.root,
-        (unsigned long) a->data.addr)) != NULL)
-    {
-        while ((t = (profnode *) __mp_predecessor(&n->data.node)) &&
-               (t->data.addr == a->data.addr))
-            n = t;
-        while ((n != NULL) && (n->data.addr == a->data.addr))
+    /* Call sites are found by hashing the entire call stack so that we
+     * only need to compare the parent chains of the call sites in a single
+     * hash bucket whose hash values match exactly.  The tree of call sites
+     * is still maintained since it determines the order in which they are
+     * written to the profiling output file.
+     */
+    h = hashstack(a);
+    k = h % MP_PROFTAB_SIZE;
+    for (n = p->slots[k]; n != NULL; n = n->data.next)
+        if (n->data.hash == h)
         {
-            for (t = n->data.parent, d = a->data.next;
-                 (t != NULL) && (d != NULL);
+            for (t = n, d = a; (t != NULL) && (d != NULL);
                  t = t->data.parent, d = d->data.next)
                 if (t->data.addr != d->data.addr)
                     break;
             if ((t == NULL) && (d == NULL))
                 return n;
-            n = (profnode *) __mp_successor(&n->data.node);
         }
-    }
     t = NULL;
     if (((n = getprofnode(p)) == NULL) || ((a->data.next != NULL) &&
          ((t = getcallsite(p, a->data.next)) == NULL)))
@@ -230,14 +250,159 @@ getcallsite(profhead *p, addrnode *a)
     }
     __mp_treeinsert(&p->tree, &n->data.node, (unsigned long) a->data.addr);
     n->data.parent = t;
+    n->data.next = p->slots[k];
+    p->slots[k] = n;
+    n->data.hash = h;
     n->data.index = p->tree.size;
     n->data.addr = a->data.addr;
     n->data.symbol = __mp_findsymbol(p->syms, a->data.addr);
     n->data.data = NULL;
+    n->data.change = 0;
+    markcallsite(p, n);
     return n;
 }
 
 
+/* Calculate the natural logarithm of a number between 0 and 1.  We don't
+ * want the mpatrol library to depend on the maths library so we scale the
+ * number to lie between 0.5 and 1 and then sum the first few terms of a
+ * rapidly converging series.
+ */
+
+static
+double
+lognumber(double x)
+{
+    double r, t, z;
+    unsigned int i, e;
+
+    for (e = 0; x < 0.5; e++)
+        x *= 2.0;
+    z = (x - 1.0) / (x + 1.0);
+    for (i = 1, r = 0.0, t = z; i < 32; i += 2, t *= z * z)
+        r += t / i;
+    return (2.0 * r) - (e * 0.69314718055994530942);
+}
+
+
+/* Calculate e raised to the power of a negative number, again without using
+ * the maths library.  The exponent is halved until it is small enough for a
+ * short Taylor series to be accurate and then the result is squared back up.
+ */
+
+static
+double
+expnumber(double x)
+{
+    double r, t;
+    unsigned int i, k;
+
+    if (x > 64.0)
+        return 0.0;
+    for (k = 0; x > 0.5; k++)
+        x /= 2.0;
+    for (i = 1, r = t = 1.0; i < 16; i++)
+    {
+        t *= -x / i;
+        r += t;
+    }
+    while (k-- > 0)
+        r *= r;
+    return r;
+}
+
+
+/* Return a pseudo-random number in the range (0, 1].
+ */
+
+static
+double
+uniformnumber(profhead *p)
+{
+    /* This is a 32-bit xorshift generator, which is good enough for this
+     * purpose and avoids disturbing the sequence returned by rand().
+     */
+    p->sseed ^= (p->sseed << 13) & 0xFFFFFFFFUL;
+    p->sseed ^= p->sseed >> 17;
+    p->sseed ^= (p->sseed << 5) & 0xFFFFFFFFUL;
+    return ((double) (p->sseed & 0xFFFFFFFFUL) + 1.0) / 4294967296.0;
+}
+
+
+/* Choose the number of bytes that must be allocated before the next
+ * allocation is sampled.  The intervals between samples are exponentially
+ * distributed with the requested mean so that every byte allocated has the
+ * same chance of causing a sample.
+ */
+
+static
+unsigned long
+nextsample(profhead *p)
+{
+    return (unsigned long) (-lognumber(uniformnumber(p)) * p->sample) + 1;
+}
+
+
+/* Calculate the estimated number of allocations and bytes that a sampled
+ * allocation of l bytes represents.  An allocation that was s bytes in size
+ * when it was sampled was chosen with a probability of 1 - exp(-s / sample)
+ * so we must scale its contribution by the reciprocal of that in order for
+ * the profiling totals to be unbiased, even if it has since been resized.
+ * The profiling totals are integers, so the scaled contributions are rounded
+ * up or down at random with a probability given by their fractional parts.
+ * That keeps every call site and allocation bin unbiased, which would not be
+ * the case if the fractions were carried over from one event to the next.
+ */
+
+static
+void
+sampleweight(profhead *p, size_t l, size_t s, size_t *c, size_t *t)
+{
+    double u, w;
+
+    if (p->sample == 0)
+    {
+        *c = 1;
+        *t = l;
+        return;
+    }
+    w = 1.0 / (1.0 - expnumber((double) s / (double) p->sample));
+    u = uniformnumber(p);
+    *c = (size_t) w;
+    if (u <= w - *c)
+        (*c)++;
+    w *= l;
+    *t = (size_t) w;
+    if (u <= w - *t)
+        (*t)++;
+}
+
+
+/* Determine if a memory allocation should be recorded for profiling.
+ */
+
+MP_GLOBAL
+int
+__mp_profilesample(profhead *p, size_t l)
+{
+    if (p->sample == 0)
+        return 1;
+    /* The first sampling interval is chosen when we see the first allocation
+     * since the sampling interval may be changed after the profhead has been
+     * initialised.
+     */
+    if (p->snext == 0)
+        p->snext = nextsample(p);
+    if (l < p->snext)
+    {
+        p->snext -= l;
+        return 0;
+    }
+    p->snext = nextsample(p);
+    return 1;
+}
+
+
 /* Record a memory allocation for profiling.
  */
 
@@ -247,13 +412,14 @@ __mp_profilealloc(profhead *p, size_t l, void *d, int w)
 {
     profnode *n;
     infonode *m;
-    size_t i;
+    size_t c, i, t;
 
+    m = (infonode *) d;
+    sampleweight(p, l, m->data.psize, &c, &t);
     /* Try to associate the allocation with a previous call site, or create
      * a new call site if no such site exists.  This information is not
      * recorded if the return address could not be determined.
      */
-    m = (infonode *) d;
     if ((m->data.stack != NULL) && (m->data.stack->data.addr != NULL))
     {
         if (((n = getcallsite(p, m->data.stack)) == NULL) ||
@@ -268,19 +434,20 @@ __mp_profilealloc(profhead *p, size_t l, void *d, int w)
             i = 2;
         else
             i = 3;
-        n->data.data->data.acount[i]++;
-        n->data.data->data.atotal[i] += l;
+        n->data.data->data.acount[i] += c;
+        n->data.data->data.atotal[i] += t;
+        markcallsite(p, n);
     }
     /* Note the size of the allocation in one of the allocation bins.
      * The highest allocation bin stores a count of all the allocations
      * that are larger than the largest bin.
      */
     if (l < MP_BIN_SIZE)
-        p->acounts[l - 1]++;
+        p->acounts[l - 1] += c;
     else
     {
-        p->acounts[MP_BIN_SIZE - 1]++;
-        p->atotals += l;
+        p->acounts[MP_BIN_SIZE - 1] += c;
+        p->atotals += t;
     }
     /* If the autosave feature is enabled then we may need to write out
      * all of the current profiling information to the output file before
@@ -298,17 +465,19 @@ __mp_profilealloc(profhead *p, size_t l, void *d, int w)
 
 MP_GLOBAL
 int
-__mp_profilefree(profhead *p, size_t l, void *d, int w)
+__mp_profilefree(profhead *p, size_t l, void *d, unsigned long e, int w)
 {
     profnode *n;
     infonode *m;
-    size_t i;
+    size_t c, i, t;
+    unsigned long k;
 
+    m = (infonode *) d;
+    sampleweight(p, l, m->data.psize, &c, &t);
     /* Try to associate the deallocation with a previous call site, or create
      * a new call site if no such site exists.  This information is not
      * recorded if the return address could not be determined.
      */
-    m = (infonode *) d;
     if ((m->data.stack != NULL) && (m->data.stack->data.addr != NULL))
     {
         if (((n = getcallsite(p, m->data.stack)) == NULL) ||
@@ -323,19 +492,28 @@ __mp_profilefree(profhead *p, size_t l, void *d, int w)
             i = 2;
         else
             i = 3;
-        n->data.data->data.dcount[i]++;
-        n->data.data->data.dtotal[i] += l;
+        n->data.data->data.dcount[i] += c;
+        n->data.data->data.dtotal[i] += t;
+        /* The lifetime of the allocation is the number of events that have
+         * occurred since it was last modified, and it is recorded in the
+         * lifetime bin corresponding to its base 2 logarithm.
+         */
+        for (i = 0, k = (e - m->data.event) >> 1;
+             (k > 0) && (i < MP_LIFEBIN_SIZE - 1); i++, k >>= 1);
+        n->data.data->data.lcount[i] += c;
+        n->data.data->data.ltotal[i] += t;
+        markcallsite(p, n);
     }
     /* Note the size of the deallocation in one of the deallocation bins.
      * The highest deallocation bin stores a count of all the deallocations
      * that are larger than the largest bin.
      */
     if (l < MP_BIN_SIZE)
-        p->dcounts[l - 1]++;
+        p->dcounts[l - 1] += c;
     else
     {
-        p->dcounts[MP_BIN_SIZE - 1]++;
-        p->dtotals += l;
+        p->dcounts[MP_BIN_SIZE - 1] += c;
+        p->dtotals += t;
     }
     /* If the autosave feature is enabled then we may need to write out
      * all of the current profiling information to the output file before
@@ -348,45 +526,50 @@ __mp_profilefree(profhead *p, size_t l, void *d, int w)
 }
 
 
-/* Write the profiling information to the output file.
+/* Write the allocation summary for every thread to the output file.  This is
+ * written in a separate section at the end of every full or partial write so
+ * that the rest of the file can be read without knowing about it.
  */
 
-MP_GLOBAL
-int
-__mp_writeprofile(profhead *p, int w)
+static
+void
+writethreads(profhead *p, FILE *f)
 {
     char s[4];
+    threadnode *n;
+
+    __mp_memcopy(s, (char *) MP_THREADMAGIC, 4);
+    fwrite(s, sizeof(char), 4, f);
+    fwrite(&p->ltable->tlist.size, sizeof(size_t), 1, f);
+    for (n = (threadnode *) p->ltable->tlist.head; n->data.node.next != NULL;
+         n = (threadnode *) n->data.node.next)
+    {
+        fwrite(&n->data.id, sizeof(unsigned long), 1, f);
+        fwrite(&n->data.acount, sizeof(size_t), 1, f);
+        fwrite(&n->data.atotal, sizeof(size_t), 1, f);
+        fwrite(&n->data.dcount, sizeof(size_t), 1, f);
+        fwrite(&n->data.dtotal, sizeof(size_t), 1, f);
+        fwrite(&n->data.ucount, sizeof(size_t), 1, f);
+        fwrite(&n->data.utotal, sizeof(size_t), 1, f);
+        fwrite(&n->data.upeak, sizeof(size_t), 1, f);
+        fwrite(&n->data.rcount, sizeof(size_t), 1, f);
+    }
+}
+
+
+/* Write all of the profiling information to the output file.
+ */
+
+static
+void
+writefull(profhead *p, FILE *f)
+{
+    char s[4], t[4];
     profdata *d;
     profnode *n;
-    FILE *f;
     size_t i, j, l;
     unsigned long v;
 
-    p->autocount = 0;
-    /* The profiling file name can also be named as stderr and stdout which
-     * will go to the standard error and standard output streams respectively.
-     */
-    if (p->file == NULL)
-        return 0;
-    else if (strcmp(p->file, "stderr") == 0)
-        f = stderr;
-    else if (strcmp(p->file, "stdout") == 0)
-        f = stdout;
-    else if ((f = fopen(p->file, "wb")) == NULL)
-    {
-        __mp_error(ET_MAX, AT_MAX, NULL, 0, "%s: cannot open file\n", p->file);
-        p->file = NULL;
-        return 0;
-    }
-    if (w != 0)
-        __mp_protectsymbols(p->syms, MA_READWRITE);
-    /* Technically, we should check the return values from each of the calls
-     * to fwrite().  However, that would increase the complexity of this
-     * function and would make the code extremely hard to follow.  Instead,
-     * we just assume that each write to the output file succeeds and hope
-     * that if an error does occur then it will not be too drastic if we
-     * continue writing the rest of the file.
-     */
     i = 1;
     v = MP_VERNUM;
     __mp_memcopy(s, (char *) MP_PROFMAGIC, 4);
@@ -475,9 +658,160 @@ __mp_writeprofile(profhead *p, int w)
                 fputs(n->data.symbol->data.name, f);
                 fputc('\0', f);
             }
+    /* Write out the lifetime bins for every profiling data structure.  These
+     * are written in a separate section so that the rest of the file can be
+     * read without knowing about them.
+     */
+    __mp_memcopy(t, (char *) MP_LIFEMAGIC, 4);
+    fwrite(t, sizeof(char), 4, f);
+    i = MP_LIFEBIN_SIZE;
+    fwrite(&i, sizeof(size_t), 1, f);
+    fwrite(&p->list.size, sizeof(size_t), 1, f);
+    for (d = (profdata *) p->list.head; d->data.node.next != NULL;
+         d = (profdata *) d->data.node.next)
+    {
+        fwrite(&d->data.index, sizeof(unsigned long), 1, f);
+        fwrite(d->data.lcount, sizeof(size_t), MP_LIFEBIN_SIZE, f);
+        fwrite(d->data.ltotal, sizeof(size_t), MP_LIFEBIN_SIZE, f);
+    }
+    writethreads(p, f);
     fwrite(s, sizeof(char), 4, f);
+}
+
+
+/* Write the profiling information that has changed since the last time the
+ * output file was written.  The allocation bins are always written in full
+ * since their size does not depend on the number of call sites, but only the
+ * call sites that are new or whose profiling data has changed are written,
+ * along with the names of their symbols.
+ */
+
+static
+void
+writedelta(profhead *p, FILE *f)
+{
+    char s[4];
+    profnode *n;
+    size_t i, l;
+    void *a;
+
+    i = MP_BIN_SIZE;
+    __mp_memcopy(s, (char *) MP_DELTAMAGIC, 4);
+    fwrite(s, sizeof(char), 4, f);
+    fwrite(&i, sizeof(size_t), 1, f);
+    fwrite(p->acounts, sizeof(size_t), MP_BIN_SIZE, f);
+    fwrite(&p->atotals, sizeof(size_t), 1, f);
+    fwrite(p->dcounts, sizeof(size_t), MP_BIN_SIZE, f);
+    fwrite(&p->dtotals, sizeof(size_t), 1, f);
+    fwrite(&p->dsize, sizeof(size_t), 1, f);
+    i = MP_LIFEBIN_SIZE;
+    fwrite(&i, sizeof(size_t), 1, f);
+    i = 0;
+    for (n = p->dlist; n != NULL; n = n->data.dnext)
+    {
+        fwrite(&n->data.index, sizeof(unsigned long), 1, f);
+        if (n->data.parent != NULL)
+            fwrite(&n->data.parent->data.index, sizeof(unsigned long), 1, f);
+        else
+            fwrite(&i, sizeof(unsigned long), 1, f);
+        fwrite(&n->data.addr, sizeof(void *), 1, f);
+        if (n->data.symbol != NULL)
+        {
+            a = n->data.symbol->data.addr;
+            l = strlen(n->data.symbol->data.name);
+        }
+        else
+        {
+            a = NULL;
+            l = 0;
+        }
+        fwrite(&a, sizeof(void *), 1, f);
+        fwrite(&l, sizeof(size_t), 1, f);
+        if (l > 0)
+            fwrite(n->data.symbol->data.name, sizeof(char), l, f);
+        if (n->data.data != NULL)
+        {
+            fwrite(&n->data.data->data.index, sizeof(unsigned long), 1, f);
+            fwrite(n->data.data->data.acount, sizeof(size_t), 4, f);
+            fwrite(n->data.data->data.atotal, sizeof(size_t), 4, f);
+            fwrite(n->data.data->data.dcount, sizeof(size_t), 4, f);
+            fwrite(n->data.data->data.dtotal, sizeof(size_t), 4, f);
+            fwrite(n->data.data->data.lcount, sizeof(size_t), MP_LIFEBIN_SIZE,
+                   f);
+            fwrite(n->data.data->data.ltotal, sizeof(size_t), MP_LIFEBIN_SIZE,
+                   f);
+        }
+        else
+            fwrite(&i, sizeof(unsigned long), 1, f);
+    }
+    writethreads(p, f);
+    fwrite(s, sizeof(char), 4, f);
+}
+
+
+/* Write the profiling information to the output file.
+ */
+
+static
+int
+writeprofile(profhead *p, int w)
+{
+    FILE *f;
+    int a, d;
+
+    p->autocount = 0;
+    /* Unless a checkpoint is due, only the changes since the last time the
+     * profiling information was written are appended to the output file.
+     * This avoids having to write out every call site each time the file is
+     * saved when the autosave feature is enabled.
+     */
+    d = (p->saves != p->nextfull);
+    /* A complete profile that is written at a checkpoint is also appended to
+     * the output file so that the earlier changes are kept, allowing mprof to
+     * show the evolution of the profile over the whole run.  The file is only
+     * truncated when it is written to for the first time.
+     */
+    a = (p->saves != p->firstsave);
+    /* The profiling file name can also be named as stderr and stdout which
+     * will go to the standard error and standard output streams respectively.
+     */
+    if (p->file == NULL)
+        return 0;
+    else if (strcmp(p->file, "stderr") == 0)
+        f = stderr;
+    else if (strcmp(p->file, "stdout") == 0)
+        f = stdout;
+    else if ((f = fopen(p->file, a ? "ab" : "wb")) == NULL)
+    {
+        __mp_error(ET_MAX, AT_MAX, NULL, 0, "%s: cannot open file\n", p->file);
+        p->file = NULL;
+        return 0;
+    }
+    if (w != 0)
+        __mp_protectsymbols(p->syms, MA_READWRITE);
+    /* Technically, we should check the return values from each of the calls
+     * to fwrite().  However, that would increase the complexity of this
+     * function and would make the code extremely hard to follow.  Instead,
+     * we just assume that each write to the output file succeeds and hope
+     * that if an error does occur then it will not be too drastic if we
+     * continue writing the rest of the file.
+     */
+    if (d)
+        writedelta(p, f);
+    else
+        writefull(p, f);
     if (w != 0)
         __mp_protectsymbols(p->syms, MA_READONLY);
+    /* Forget about all of the changes that have just been written.  Any
+     * call sites that change after this will have a different write number
+     * to the one they were last noted with, so there is no need to visit
+     * them here.
+     */
+    if (!d)
+        p->nextfull = p->saves + ((p->checkpoint > 1) ? p->checkpoint : 1);
+    p->dlist = NULL;
+    p->dsize = 0;
+    p->saves++;
     if (ferror(f))
     {
         __mp_error(ET_MAX, AT_MAX, NULL, 0, "%s: problem writing profiling "
@@ -493,6 +827,24 @@ __mp_writeprofile(profhead *p, int w)
 }
 
 
+/* Write the profiling information to the output file, recording the time
+ * taken if latencies are being recorded.
+ */
+
+MP_GLOBAL
+int
+__mp_writeprofile(profhead *p, int w)
+{
+    unsigned long t;
+    int r;
+
+    t = __mp_starttimer(p->stats);
+    r = writeprofile(p, w);
+    __mp_stoptimer(p->stats, &p->stats->phases[LP_OUTPUT], t);
+    return r;
+}
+
+
 /* Protect the memory blocks used by the profiling table with the supplied
  * access permission.
  */
@@ -36,11 +36,14 @@
 
 #include "config.h"
 #include "symbol.h"
+#include "leaktab.h"
+#include "stats.h"
 
 
 /* A profdata structure belongs to a list of profdata structures and contains
  * statistics about the counts and totals of all of the small, medium, large
- * and extra large allocations and deallocations for a particular call site.
+ * and extra large allocations and deallocations for a particular call site,
+ * along with the counts and totals of its deallocations by lifetime.
  * An internal profdata structure stores details of a single memory block
  * allocated for profdata structure slots.
  */
@@ -62,6 +65,8 @@ typedef union profdata
         size_t dcount[4];    /* total numbers of deallocations */
         size_t atotal[4];    /* total numbers of allocated bytes */
         size_t dtotal[4];    /* total numbers of deallocated bytes */
+        size_t lcount[MP_LIFEBIN_SIZE]; /* deallocations by lifetime */
+        size_t ltotal[MP_LIFEBIN_SIZE]; /* deallocated bytes by lifetime */
     }
     data;
 }
@@ -69,8 +74,10 @@ profdata;
 
 
 /* A profnode belongs to a tree of profnodes and contains profiling
- * details for a function in a call stack.  An internal profnode stores
- * details of a single memory block allocated for profnode slots.
+ * details for a function in a call stack.  It also belongs to a hash
+ * bucket of profnodes whose call stacks hash to the same value.  An
+ * internal profnode stores details of a single memory block allocated
+ * for profnode slots.
  */
 
 typedef union profnode
@@ -86,10 +93,14 @@ typedef union profnode
     {
         treenode node;          /* tree node */
         union profnode *parent; /* parent node */
+        union profnode *next;   /* next node in hash bucket */
+        union profnode *dnext;  /* next changed node */
+        unsigned long hash;     /* hash value of call stack */
         unsigned long index;    /* node index */
         void *addr;             /* return address */
         symnode *symbol;        /* associated symbol */
         profdata *data;         /* profiling data */
+        unsigned long change;   /* write that will contain changes */
     }
     data;
 }
@@ -104,11 +115,16 @@ typedef struct profhead
 {
     heaphead *heap;              /* pointer to heap */
     symhead *syms;               /* pointer to symbol table */
+    leaktab *ltable;             /* pointer to leak table */
+    statshead *stats;            /* pointer to live statistics */
     slottable dtable;            /* table of profdata structures */
     slottable ntable;            /* table of profnodes */
     listhead ilist;              /* internal list of memory blocks */
     listhead list;               /* list of profdata structures */
     treeroot tree;               /* tree of profnodes */
+    profnode *slots[MP_PROFTAB_SIZE]; /* hash table of profnodes */
+    profnode *dlist;             /* list of changed profnodes */
+    size_t dsize;                /* number of changed profnodes */
     size_t size;                 /* memory used by internal blocks */
     size_t acounts[MP_BIN_SIZE]; /* allocation bins */
     size_t dcounts[MP_BIN_SIZE]; /* deallocation bins */
@@ -119,6 +135,13 @@ typedef struct profhead
     size_t lbound;               /* large allocation boundary */
     unsigned long autosave;      /* autosave frequency */
     unsigned long autocount;     /* autosave count */
+    unsigned long checkpoint;    /* full write frequency */
+    unsigned long saves;         /* number of writes */
+    unsigned long nextfull;      /* next write to be written in full */
+    unsigned long firstsave;     /* first write to the current file */
+    unsigned long sample;        /* mean sampling interval in bytes */
+    unsigned long snext;         /* bytes remaining until next sample */
+    unsigned long sseed;         /* sampling random number state */
     char *file;                  /* profiling filename */
     memaccess prot;              /* protection status */
     size_t protrecur;            /* protection recursion count */
@@ -133,10 +156,12 @@ extern "C"
 #endif /* __cplusplus */
 
 
-MP_EXPORT void __mp_newprofile(profhead *, heaphead *, symhead *);
+MP_EXPORT void __mp_newprofile(profhead *, heaphead *, symhead *, leaktab *,
+                               statshead *);
 MP_EXPORT void __mp_deleteprofile(profhead *);
+MP_EXPORT int __mp_profilesample(profhead *, size_t);
 MP_EXPORT int __mp_profilealloc(profhead *, size_t, void *, int);
-MP_EXPORT int __mp_profilefree(profhead *, size_t, void *, int);
+MP_EXPORT int __mp_profilefree(profhead *, size_t, void *, unsigned long, int);
 MP_EXPORT int __mp_writeprofile(profhead *, int);
 MP_EXPORT int __mp_protectprofile(profhead *, memaccess);
 
@@ -72,6 +72,7 @@ __mp_newslots(slottable *t, size_t s, size_t a)
         s = sizeof(slotentry);
     t->entsize = s;
     t->size = 0;
+    t->blocks = 0;
 }
 
 
@@ -100,10 +101,32 @@ __mp_initslots(slottable *t, void *p, size_t s)
         e = (slotentry *) (b + l);
         b = (char *) e + t->entsize;
     }
+    t->blocks++;
     return n;
 }
 
 
+/* Return the size of the next block of memory that should be supplied to a
+ * slot table, given the system page size.  The size doubles with each block
+ * that is supplied so that the number of blocks only grows logarithmically
+ * with the number of slots.
+ */
+
+MP_GLOBAL
+size_t
+__mp_growslots(slottable *t, size_t p)
+{
+    size_t i, l;
+
+    for (i = t->blocks, l = MP_ALLOCFACTOR; (i > 0) && (l < MP_SLOTFACTOR);
+         i--)
+        l <<= 1;
+    if (l > MP_SLOTFACTOR)
+        l = MP_SLOTFACTOR;
+    return l * p;
+}
+
+
 /* Return a free slot entry from a slot table, or NULL if the table is full.
  */
 
@@ -122,6 +145,25 @@ __mp_getslot(slottable *t)
 }
 
 
+/* Fill an array with up to a given number of free slot entries from a slot
+ * table and return the number of entries that were obtained.
+ */
+
+MP_GLOBAL
+size_t
+__mp_getslots(slottable *t, void **v, size_t n)
+{
+    slotentry *e;
+    size_t i;
+
+    for (i = 0, e = t->free; (i < n) && (e != NULL); i++, e = e->next)
+        v[i] = (void *) e;
+    t->free = e;
+    t->size += i;
+    return i;
+}
+
+
 /* Free up an allocated slot entry and return it to the free chain in the
  * slot table.
  */
@@ -139,6 +181,28 @@ __mp_freeslot(slottable *t, void *p)
 }
 
 
+/* Free up an array of allocated slot entries and return them to the free
+ * chain in the slot table, in the same order as if each entry had been freed
+ * in turn.
+ */
+
+MP_GLOBAL
+void
+__mp_freeslots(slottable *t, void **v, size_t n)
+{
+    slotentry *e;
+    size_t i;
+
+    for (i = 0, e = t->free; i < n; i++)
+    {
+        ((slotentry *) v[i])->next = e;
+        e = (slotentry *) v[i];
+    }
+    t->free = e;
+    t->size -= n;
+}
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -54,7 +54,9 @@ slotentry;
 
 
 /* A slot table contains information about the minimum alignment and size of
- * each slot entry and also a pointer to the chain of free slots.
+ * each slot entry and also a pointer to the chain of free slots.  The number
+ * of blocks of memory that have been supplied for slot entries is used to
+ * determine the size of the next block.
  */
 
 typedef struct slottable
@@ -63,6 +65,7 @@ typedef struct slottable
     size_t entalign;        /* alignment for each slot entry */
     size_t entsize;         /* size of a single slot entry */
     size_t size;            /* number of slots in table */
+    size_t blocks;          /* number of blocks supplied */
 }
 slottable;
 
@@ -75,8 +78,11 @@ extern "C"
 
 MP_EXPORT void __mp_newslots(slottable *, size_t, size_t);
 MP_EXPORT size_t __mp_initslots(slottable *, void *, size_t);
+MP_EXPORT size_t __mp_growslots(slottable *, size_t);
 MP_EXPORT void *__mp_getslot(slottable *);
+MP_EXPORT size_t __mp_getslots(slottable *, void **, size_t);
 MP_EXPORT void __mp_freeslot(slottable *, void *);
+MP_EXPORT void __mp_freeslots(slottable *, void **, size_t);
 
 
 #ifdef __cplusplus
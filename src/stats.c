@@ -0,0 +1,335 @@
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Live statistics.  If a statistics file has been specified then a
+ * snapshot of the heap statistics is written to a page in a named
+ * shared memory object after every allocation event, using a sequence
+ * lock so that an external tool can read it without entering the library.
+ * The latency histograms for each entry point and each phase of processing
+ * within the library are also maintained here.
+ */
+
+
+#include "stats.h"
+#include "diag.h"
+#include "utils.h"
+#include "version.h"
+#if MP_SHM_SUPPORT
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif /* MP_SHM_SUPPORT */
+
+
+#if MP_IDENT_SUPPORT
+#ident "$Id$"
+#else /* MP_IDENT_SUPPORT */
+static MP_CONST MP_VOLATILE char *stats_id = "$Id$";
+#endif /* MP_IDENT_SUPPORT */
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+/* This array should always be kept in step with the latencyphase enumeration.
+ */
+
+MP_GLOBAL char *__mp_latencynames[LP_MAX] =
+{
+    "call stack",
+    "symbol lookup",
+    "heap check",
+    "protection",
+    "output"
+};
+
+
+/* Initialise the fields of a statshead so that there is no statistics page.
+ */
+
+MP_GLOBAL
+void
+__mp_newstats(statshead *s, memoryinfo *m)
+{
+    size_t i;
+
+    s->memory = m;
+    s->page = NULL;
+    s->file = NULL;
+    s->size = 0;
+    for (i = 0; i < MP_STATBIN_SIZE; i++)
+        s->ccount[i] = s->ctotal[i] = 0;
+    for (i = 0; i < LP_MAX; i++)
+        __mp_newlatency(&s->phases[i]);
+    s->timing = 0;
+}
+
+
+/* Create the shared memory object named in the statshead and map the
+ * statistics page into memory.
+ */
+
+MP_GLOBAL
+int
+__mp_openstats(statshead *s)
+{
+#if MP_SHM_SUPPORT
+    statspage *p;
+    void *a;
+    int f;
+
+    if ((s->page != NULL) || (s->file == NULL))
+        return 0;
+    s->size = __mp_roundup(sizeof(statspage), s->memory->page);
+    if ((f = shm_open(s->file, O_RDWR | O_CREAT | O_TRUNC, 0644)) == -1)
+    {
+        __mp_error(ET_MAX, AT_MAX, NULL, 0, "%s: cannot open shared memory "
+                   "object\n", s->file);
+        return 0;
+    }
+    if ((ftruncate(f, s->size) == -1) ||
+        ((a = mmap(NULL, s->size, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0)) ==
+         (void *) MAP_FAILED))
+    {
+        __mp_error(ET_MAX, AT_MAX, NULL, 0, "%s: cannot map shared memory "
+                   "object\n", s->file);
+        close(f);
+        shm_unlink(s->file);
+        return 0;
+    }
+    close(f);
+    /* The shared memory object is zero-filled when it is first extended, so
+     * the sequence number and all of the statistics start at zero.  The
+     * header is filled in last so that a reader will not recognise the page
+     * until it is ready.
+     */
+    p = (statspage *) a;
+    p->version = MP_VERNUM;
+    p->size = sizeof(statspage);
+    p->bins = MP_STATBIN_SIZE;
+    p->pid = __mp_processid();
+    __mp_membarrier();
+    __mp_memcopy(p->magic, (char *) MP_STATSMAGIC, 4);
+    s->page = p;
+    return 1;
+#else /* MP_SHM_SUPPORT */
+    return 0;
+#endif /* MP_SHM_SUPPORT */
+}
+
+
+/* Unmap the statistics page and optionally remove the shared memory object.
+ */
+
+MP_GLOBAL
+void
+__mp_closestats(statshead *s, int u)
+{
+#if MP_SHM_SUPPORT
+    if (s->page == NULL)
+        return;
+    munmap((void *) s->page, s->size);
+    if (u != 0)
+        shm_unlink(s->file);
+    s->page = NULL;
+    s->size = 0;
+#endif /* MP_SHM_SUPPORT */
+}
+
+
+/* Record a new live memory allocation in its size class.
+ */
+
+MP_GLOBAL
+void
+__mp_statsalloc(statshead *s, size_t l)
+{
+    size_t i;
+
+    if ((i = __mp_logtwo(l)) >= MP_STATBIN_SIZE)
+        i = MP_STATBIN_SIZE - 1;
+    s->ccount[i]++;
+    s->ctotal[i] += l;
+}
+
+
+/* Remove a live memory allocation from its size class.
+ */
+
+MP_GLOBAL
+void
+__mp_statsfree(statshead *s, size_t l)
+{
+    size_t i;
+
+    if ((i = __mp_logtwo(l)) >= MP_STATBIN_SIZE)
+        i = MP_STATBIN_SIZE - 1;
+    s->ccount[i]--;
+    s->ctotal[i] -= l;
+}
+
+
+/* Mark the statistics page as being updated and return a pointer to it so
+ * that the caller can fill in the heap statistics.
+ */
+
+MP_GLOBAL
+statspage *
+__mp_lockstats(statshead *s)
+{
+    statspage *p;
+
+    p = s->page;
+    p->seq++;
+    __mp_membarrier();
+    return p;
+}
+
+
+/* Copy the size classes to the statistics page and mark it as being
+ * consistent again.
+ */
+
+MP_GLOBAL
+void
+__mp_unlockstats(statshead *s)
+{
+    statspage *p;
+    size_t i;
+
+    p = s->page;
+    for (i = 0; i < MP_STATBIN_SIZE; i++)
+    {
+        p->ccount[i] = s->ccount[i];
+        p->ctotal[i] = s->ctotal[i];
+    }
+    __mp_membarrier();
+    p->seq++;
+}
+
+
+/* Initialise the fields of a latency so that it contains no measurements.
+ */
+
+MP_GLOBAL
+void
+__mp_newlatency(latency *l)
+{
+    size_t i;
+
+    l->count = l->total = l->max = 0;
+    for (i = 0; i < MP_LATBIN_SIZE; i++)
+        l->bins[i] = 0;
+}
+
+
+/* Return the current time if latencies are being recorded, or zero if they
+ * are not.
+ */
+
+MP_GLOBAL
+unsigned long
+__mp_starttimer(statshead *s)
+{
+    if (!s->timing)
+        return 0;
+    return __mp_timestamp();
+}
+
+
+/* Record the time that has elapsed since a timer was started.  Nothing is
+ * recorded if the timer was not started because latencies were not being
+ * recorded at the time.
+ */
+
+MP_GLOBAL
+void
+__mp_stoptimer(statshead *s, latency *l, unsigned long t)
+{
+    unsigned long d;
+    size_t i;
+    unsigned char e;
+
+    if ((t == 0) || !s->timing)
+        return;
+    /* The timestamps may have wrapped around since the timer was started, so
+     * the elapsed time must be calculated with modular arithmetic.
+     */
+    d = __mp_timestamp() - t;
+    /* The first four buckets each hold a single value and each subsequent
+     * power of two is split into four buckets using the two bits below the
+     * most significant bit.
+     */
+    if (d < 4)
+        i = d;
+    else
+    {
+        e = __mp_logtwo(d);
+        i = ((e - 1) << 2) + ((d >> (e - 2)) & 3);
+    }
+    if (i >= MP_LATBIN_SIZE)
+        i = MP_LATBIN_SIZE - 1;
+    l->bins[i]++;
+    l->count++;
+    l->total += d;
+    if (l->max < d)
+        l->max = d;
+}
+
+
+/* Return an upper bound on the given percentile of the measurements in a
+ * latency histogram.
+ */
+
+MP_GLOBAL
+unsigned long
+__mp_percentile(latency *l, unsigned long p)
+{
+    unsigned long c, n, r;
+    size_t i;
+    unsigned char e;
+
+    if (l->count == 0)
+        return 0;
+    if ((n = (l->count * p + 99) / 100) == 0)
+        n = 1;
+    for (c = 0, i = 0; i < MP_LATBIN_SIZE - 1; i++)
+        if ((c += l->bins[i]) >= n)
+            break;
+    if (i < 4)
+        r = i;
+    else
+    {
+        e = (i >> 2) + 1;
+        r = ((unsigned long) (5 + (i & 3)) << (e - 2)) - 1;
+    }
+    if ((i == MP_LATBIN_SIZE - 1) || (r > l->max))
+        r = l->max;
+    return r;
+}
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
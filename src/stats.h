@@ -0,0 +1,174 @@
+#ifndef MP_STATS_H
+#define MP_STATS_H
+
+
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Live statistics.  This interface is used by the mpatrol library to
+ * publish a snapshot of its heap statistics in a named shared memory
+ * object so that they can be read by an external monitoring tool
+ * while the program is running.
+ */
+
+
+/*
+ * $Id$
+ */
+
+
+#include "config.h"
+#include "memory.h"
+
+
+/* Ensure that all memory accesses before this point have completed before any
+ * memory accesses after this point are made.  This is used to order updates
+ * to the sequence number in the statistics page with respect to the other
+ * fields in the page.
+ */
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || \
+     ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 1)))
+#define __mp_membarrier() __sync_synchronize()
+#else /* __GNUC__ */
+#define __mp_membarrier() ((void) 0)
+#endif /* __GNUC__ */
+
+
+/* The different phases of processing within the mpatrol library that can
+ * be timed.  These are measured inclusively, so the time spent in an entry
+ * point also includes the time spent in each of its phases.
+ */
+
+typedef enum latencyphase
+{
+    LP_STACK,   /* unwinding the call stack */
+    LP_SYMBOL,  /* looking up source-level information */
+    LP_CHECK,   /* checking the heap for corruption */
+    LP_PROTECT, /* changing the protection of internal memory */
+    LP_OUTPUT,  /* writing tracing and profiling output */
+    LP_MAX
+}
+latencyphase;
+
+
+/* A latency contains a histogram of the time taken in nanoseconds by an
+ * entry point or a phase of processing.  Each power of two is divided into
+ * four buckets in the histogram so that percentiles can be calculated with
+ * a bounded relative error.
+ */
+
+typedef struct latency
+{
+    unsigned long count;                /* number of measurements */
+    unsigned long total;                /* total time */
+    unsigned long max;                  /* maximum time */
+    unsigned long bins[MP_LATBIN_SIZE]; /* histogram buckets */
+}
+latency;
+
+
+/* A statspage is placed at the start of the shared memory object and contains
+ * a snapshot of the heap statistics that is updated after every allocation
+ * event.  The sequence number is odd while the snapshot is being updated, so
+ * a reader must try again if it reads an odd sequence number or if the
+ * sequence number changes while it is reading the snapshot.
+ */
+
+typedef struct statspage
+{
+    char magic[4];                    /* magic sequence */
+    unsigned long version;            /* library version */
+    unsigned long size;               /* size of this structure */
+    unsigned long bins;               /* number of size classes */
+    unsigned long pid;                /* process identifier */
+    MP_VOLATILE unsigned long seq;    /* sequence number */
+    unsigned long event;              /* allocation event count */
+    size_t acount;                    /* allocated block count */
+    size_t atotal;                    /* allocated block total */
+    size_t cpeak;                     /* allocation count peak */
+    size_t peak;                      /* allocation peak */
+    size_t fcount;                    /* free block count */
+    size_t ftotal;                    /* free block total */
+    size_t gcount;                    /* freed block count */
+    size_t gtotal;                    /* freed block total */
+    size_t mcount;                    /* marked block count */
+    size_t mtotal;                    /* marked block total */
+    size_t hsize;                     /* heap table overhead */
+    size_t tsize;                     /* allocation table overhead */
+    size_t ssize;                     /* symbol table overhead */
+    size_t lsize;                     /* leak table overhead */
+    size_t psize;                     /* profiling overhead */
+    size_t isize;                     /* other internal overhead */
+    size_t ccount[MP_STATBIN_SIZE];   /* live counts in each size class */
+    size_t ctotal[MP_STATBIN_SIZE];   /* live totals in each size class */
+}
+statspage;
+
+
+/* A statshead contains the name of the shared memory object and a pointer to
+ * the statistics page within it.  The size classes of all live memory
+ * allocations are accumulated here and are copied to the statistics page
+ * whenever it is updated.
+ */
+
+typedef struct statshead
+{
+    memoryinfo *memory;               /* memory information */
+    statspage *page;                  /* statistics page */
+    char *file;                       /* shared memory object name */
+    size_t size;                      /* size of shared memory object */
+    size_t ccount[MP_STATBIN_SIZE];   /* live counts in each size class */
+    size_t ctotal[MP_STATBIN_SIZE];   /* live totals in each size class */
+    latency phases[LP_MAX];           /* phase latencies */
+    char timing;                      /* record latencies */
+}
+statshead;
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+MP_EXPORT char *__mp_latencynames[LP_MAX];
+
+
+MP_EXPORT void __mp_newstats(statshead *, memoryinfo *);
+MP_EXPORT int __mp_openstats(statshead *);
+MP_EXPORT void __mp_closestats(statshead *, int);
+MP_EXPORT void __mp_statsalloc(statshead *, size_t);
+MP_EXPORT void __mp_statsfree(statshead *, size_t);
+MP_EXPORT statspage *__mp_lockstats(statshead *);
+MP_EXPORT void __mp_unlockstats(statshead *);
+MP_EXPORT void __mp_newlatency(latency *);
+MP_EXPORT unsigned long __mp_starttimer(statshead *);
+MP_EXPORT void __mp_stoptimer(statshead *, latency *, unsigned long);
+MP_EXPORT unsigned long __mp_percentile(latency *, unsigned long);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+
+#endif /* MP_STATS_H */
@@ -130,27 +130,7 @@ static
 hashentry *
 gethashentry(strtab *t)
 {
-    hashentry *e;
-    heapnode *p;
-
-    /* If we have no more hash entry slots left then we must allocate
-     * some more memory for them.  An extra MP_ALLOCFACTOR pages of memory
-     * should suffice.
-     */
-    if ((e = (hashentry *) __mp_getslot(&t->table)) == NULL)
-    {
-        if ((p = __mp_heapalloc(t->heap, t->heap->memory.page * MP_ALLOCFACTOR,
-              t->table.entalign, 1)) == NULL)
-            return NULL;
-        __mp_initslots(&t->table, p->block, p->size);
-        e = (hashentry *) __mp_getslot(&t->table);
-        __mp_addtail(&t->list, &e->node);
-        e->data.block = p->block;
-        e->size = p->size;
-        t->size += p->size;
-        e = (hashentry *) __mp_getslot(&t->table);
-    }
-    return e;
+    return (hashentry *) __mp_heapslot(t->heap, &t->table, &t->list, &t->size);
 }
 
 
@@ -510,12 +510,13 @@ void _DYNAMIC(void);
 
 MP_GLOBAL
 void
-__mp_newsymbols(symhead *y, heaphead *h, void *i)
+__mp_newsymbols(symhead *y, heaphead *h, statshead *s, void *i)
 {
     struct { char x; symnode y; } z;
     long n;
 
     y->heap = h;
+    y->stats = s;
     /* Determine the minimum alignment for a symbol node on this system
      * and force the alignment to be a power of two.  This information
      * is used when initialising the slot table.
@@ -592,13 +593,13 @@ getsymnode(symhead *y)
     heapnode *p;
 
     /* If we have no more symbol node slots left then we must allocate
-     * some more memory for them.  An extra MP_ALLOCFACTOR pages of memory
-     * should suffice.
+     * some more memory for them.  The amount of memory allocated grows
+     * with the size of the slot table.
      */
     if ((n = (symnode *) __mp_getslot(&y->table)) == NULL)
     {
-        if ((p = __mp_heapalloc(y->heap, y->heap->memory.page * MP_ALLOCFACTOR,
-              y->table.entalign, 1)) == NULL)
+        if ((p = __mp_heapalloc(y->heap, __mp_growslots(&y->table,
+              y->heap->memory.page), y->table.entalign, 1)) == NULL)
             return NULL;
         __mp_initslots(&y->table, p->block, p->size);
         n = (symnode *) __mp_getslot(&y->table);
@@ -2529,9 +2530,9 @@ findsource(bfd *h, asection *p, void *d)
  * at a particular address.
  */
 
-MP_GLOBAL
+static
 int
-__mp_findsource(symhead *y, void *p, char **s, char **t, unsigned long *u)
+sourcelookup(symhead *y, void *p, char **s, char **t, unsigned long *u)
 {
 #if FORMAT == FORMAT_BFD
     objectfile *n;
@@ -2585,6 +2586,24 @@ __mp_findsource(symhead *y, void *p, char **s, char **t, unsigned long *u)
 }
 
 
+/* Attempt to find the source correspondence for a machine instruction,
+ * recording the time taken if latencies are being recorded.
+ */
+
+MP_GLOBAL
+int
+__mp_findsource(symhead *y, void *p, char **s, char **t, unsigned long *u)
+{
+    unsigned long w;
+    int r;
+
+    w = __mp_starttimer(y->stats);
+    r = sourcelookup(y, p, s, t, u);
+    __mp_stoptimer(y->stats, &y->stats->phases[LP_SYMBOL], w);
+    return r;
+}
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
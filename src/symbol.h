@@ -36,6 +36,7 @@
 
 #include "config.h"
 #include "heap.h"
+#include "stats.h"
 #include "strtab.h"
 
 
@@ -78,6 +79,7 @@ symnode;
 typedef struct symhead
 {
     heaphead *heap;   /* pointer to heap */
+    statshead *stats; /* pointer to live statistics */
     strtab strings;   /* string table */
     slottable table;  /* table of symbol nodes */
     treeroot itree;   /* internal allocation tree */
@@ -99,7 +101,7 @@ extern "C"
 #endif /* __cplusplus */
 
 
-MP_EXPORT void __mp_newsymbols(symhead *, heaphead *, void *);
+MP_EXPORT void __mp_newsymbols(symhead *, heaphead *, statshead *, void *);
 MP_EXPORT void __mp_closesymbols(symhead *);
 MP_EXPORT void __mp_deletesymbols(symhead *);
 MP_EXPORT int __mp_addsymbols(symhead *, char *, char *, size_t);
@@ -114,11 +114,19 @@ static int traceready;
 
 MP_GLOBAL
 void
-__mp_newtrace(tracehead *t, memoryinfo *m)
+__mp_newtrace(tracehead *t, memoryinfo *m, statshead *s)
 {
     size_t i;
 
+    t->stats = s;
     t->file = __mp_tracefile(m, NULL);
+    t->lsize = 0;
+    t->usize = (size_t) -1;
+    t->lrange = 0;
+    t->urange = (unsigned long) -1;
+    t->freq = 1;
+    t->count = 0;
+    t->nsources = 0;
     t->tracing = 0;
     __mp_newlist(&usedfuncs);
     __mp_newlist(&freefuncs);
@@ -428,19 +436,67 @@ writefilename(char *s)
 }
 
 
-/* Record a memory allocation for tracing.
+/* Determine if a memory allocation passes the tracing filters.  The source
+ * names given with the TRACESOURCE option are stored in the string table, as
+ * are any names obtained from debugging information, so they can usually be
+ * matched by pointer before falling back to comparing the strings.
  */
 
-MP_GLOBAL
-void
-__mp_tracealloc(tracehead *t, unsigned long n, void *a, size_t l,
-                unsigned long d, char *f, char *g, unsigned long u)
+static
+int
+tracefilter(tracehead *t, unsigned long n, size_t l, char *f, char *g)
+{
+    size_t i;
+    char *s;
+
+    if ((l < t->lsize) || (l > t->usize) || (n < t->lrange) ||
+        (n > t->urange))
+        return 0;
+    if (t->nsources > 0)
+    {
+        for (i = 0; i < t->nsources; i++)
+        {
+            s = t->sources[i];
+            if ((s == f) || (s == g))
+                break;
+        }
+        if (i == t->nsources)
+            for (i = 0; i < t->nsources; i++)
+            {
+                s = t->sources[i];
+                if (((f != NULL) && (strcmp(s, f) == 0)) ||
+                    ((g != NULL) && (strcmp(s, g) == 0)))
+                    break;
+            }
+        if (i == t->nsources)
+            return 0;
+    }
+    /* Only sample the allocations that have passed all of the other filters
+     * so that the frequency applies to the allocations that are of interest.
+     */
+    if ((t->freq > 1) && (t->count++ % t->freq != 0))
+        return 0;
+    return 1;
+}
+
+
+/* Record a memory allocation for tracing if it passes the tracing filters.
+ * This returns zero if the allocation was not recorded, in which case any
+ * subsequent reallocations and deallocations of it must not be recorded
+ * either.
+ */
+
+static
+int
+tracealloc(tracehead *t, unsigned long n, void *a, size_t l, unsigned long d,
+           char *f, char *g, unsigned long u)
 {
     void *b;
     size_t s;
 
-    if ((tracefile == NULL) && !opentracefile(t))
-        return;
+    if (!tracefilter(t, n, l, f, g) ||
+        ((tracefile == NULL) && !opentracefile(t)))
+        return 0;
     fputc('A', tracefile);
     /* Some of the following values are written as LEB128 numbers.  This is so
      * that the size of the tracing output file can be kept to a minimum.
@@ -457,17 +513,17 @@ __mp_tracealloc(tracehead *t, unsigned long n, void *a, size_t l,
     writefilename(g);
     b = __mp_encodeuleb128(u, &s);
     fwrite(b, s, 1, tracefile);
-    checktracefile(t);
+    return checktracefile(t);
 }
 
 
 /* Record a memory reallocation for tracing.
  */
 
-MP_GLOBAL
+static
 void
-__mp_tracerealloc(tracehead *t, unsigned long n, void *a, size_t l,
-                  unsigned long d, char *f, char *g, unsigned long u)
+tracerealloc(tracehead *t, unsigned long n, void *a, size_t l, unsigned long d,
+             char *f, char *g, unsigned long u)
 {
     void *b;
     size_t s;
@@ -497,10 +553,10 @@ __mp_tracerealloc(tracehead *t, unsigned long n, void *a, size_t l,
 /* Record a memory deallocation for tracing.
  */
 
-MP_GLOBAL
+static
 void
-__mp_tracefree(tracehead *t, unsigned long n, unsigned long d, char *f, char *g,
-               unsigned long u)
+tracefree(tracehead *t, unsigned long n, unsigned long d, char *f, char *g,
+          unsigned long u)
 {
     void *b;
     size_t s;
@@ -523,6 +579,51 @@ __mp_tracefree(tracehead *t, unsigned long n, unsigned long d, char *f, char *g,
 }
 
 
+/* The following functions record memory allocation events for tracing and
+ * also record the time taken to write them if latencies are being recorded.
+ */
+
+MP_GLOBAL
+int
+__mp_tracealloc(tracehead *t, unsigned long n, void *a, size_t l,
+                unsigned long d, char *f, char *g, unsigned long u)
+{
+    unsigned long w;
+    int r;
+
+    w = __mp_starttimer(t->stats);
+    r = tracealloc(t, n, a, l, d, f, g, u);
+    __mp_stoptimer(t->stats, &t->stats->phases[LP_OUTPUT], w);
+    return r;
+}
+
+
+MP_GLOBAL
+void
+__mp_tracerealloc(tracehead *t, unsigned long n, void *a, size_t l,
+                  unsigned long d, char *f, char *g, unsigned long u)
+{
+    unsigned long w;
+
+    w = __mp_starttimer(t->stats);
+    tracerealloc(t, n, a, l, d, f, g, u);
+    __mp_stoptimer(t->stats, &t->stats->phases[LP_OUTPUT], w);
+}
+
+
+MP_GLOBAL
+void
+__mp_tracefree(tracehead *t, unsigned long n, unsigned long d, char *f, char *g,
+               unsigned long u)
+{
+    unsigned long w;
+
+    w = __mp_starttimer(t->stats);
+    tracefree(t, n, d, f, g, u);
+    __mp_stoptimer(t->stats, &t->stats->phases[LP_OUTPUT], w);
+}
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
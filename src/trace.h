@@ -36,16 +36,27 @@
 
 #include "config.h"
 #include "memory.h"
+#include "stats.h"
 
 
 /* A tracehead contains all the tracing information including the
- * filename of the output file and the current tracing state.
+ * filename of the output file and the current tracing state.  It also
+ * contains the filters which determine which memory allocations are traced.
  */
 
 typedef struct tracehead
 {
-    char *file;   /* tracing filename */
-    char tracing; /* tracing status */
+    statshead *stats;                /* pointer to live statistics */
+    char *file;                      /* tracing filename */
+    size_t lsize;                    /* smallest allocation size to trace */
+    size_t usize;                    /* largest allocation size to trace */
+    unsigned long lrange;            /* lowest allocation index to trace */
+    unsigned long urange;            /* highest allocation index to trace */
+    unsigned long freq;              /* tracing frequency */
+    unsigned long count;             /* allocations passing other filters */
+    char *sources[MP_TRACESOURCES];  /* source files or functions to trace */
+    size_t nsources;                 /* number of source names */
+    char tracing;                    /* tracing status */
 }
 tracehead;
 
@@ -56,12 +67,12 @@ extern "C"
 #endif /* __cplusplus */
 
 
-MP_EXPORT void __mp_newtrace(tracehead *, memoryinfo *);
+MP_EXPORT void __mp_newtrace(tracehead *, memoryinfo *, statshead *);
 MP_EXPORT int __mp_changetrace(tracehead *, char *, int);
 MP_EXPORT int __mp_endtrace(tracehead *);
 MP_EXPORT void __mp_traceheap(void *, size_t, int);
-MP_EXPORT void __mp_tracealloc(tracehead *, unsigned long, void *, size_t,
-                               unsigned long, char *, char *, unsigned long);
+MP_EXPORT int __mp_tracealloc(tracehead *, unsigned long, void *, size_t,
+                              unsigned long, char *, char *, unsigned long);
 MP_EXPORT void __mp_tracerealloc(tracehead *, unsigned long, void *, size_t,
                                  unsigned long, char *, char *, unsigned long);
 MP_EXPORT void __mp_tracefree(tracehead *, unsigned long, unsigned long, char *,
@@ -22,7 +22,11 @@
  * Binary search trees.  This implementation is based upon the red-black
  * tree data structures and algorithms described in Introduction to
  * Algorithms, First Edition by Cormen, Leiserson and Rivest (The MIT Press,
- * 1990, ISBN 0-262-03141-8).
+ * 1990, ISBN 0-262-03141-8).  Trees can also be created as B+-trees, in
+ * which the tree nodes are referred to by wide index pages and are also
+ * linked together in key order, so that searching a tree follows one
+ * pointer per page rather than one pointer per node, and iterating over a
+ * tree follows one pointer per node.
  */
 
 
@@ -42,6 +46,21 @@ extern "C"
 #endif /* __cplusplus */
 
 
+/* The flags used to identify the nodes of a B-tree.  The flag in a node of a
+ * red-black tree is used to hold its colour and is therefore always either
+ * zero or one.
+ */
+
+#define BTREE_NODE 2 /* node belongs to a B-tree */
+#define BTREE_ROOT 3 /* sentinel leaf node of a B-tree */
+
+
+/* Return the tree root that contains a given sentinel leaf node.
+ */
+
+#define btreeroot(n) ((treeroot *) ((char *) (n) - offsetof(treeroot, null)))
+
+
 /* Initialise the fields of a tree root so that the tree becomes empty.
  * Note the sentinel leaf node which is used to make tree manipulation
  * easier and is pointed to by all real leaf nodes.
@@ -55,6 +74,428 @@ __mp_newtree(treeroot *t)
     t->null.parent = t->null.left = t->null.right = NULL;
     t->null.key = t->null.flag = 0;
     t->size = 0;
+    t->page = t->spare = NULL;
+    t->pages = t->height = 0;
+}
+
+
+/* Initialise the fields of a tree root so that the tree becomes an empty
+ * B-tree with no spare pages.
+ */
+
+MP_GLOBAL
+void
+__mp_newbtree(treeroot *t)
+{
+    __mp_newtree(t);
+    t->null.flag = BTREE_ROOT;
+}
+
+
+/* Return the number of bytes of memory that must be supplied to a B-tree
+ * before a given number of tree nodes can be inserted into it, or zero if
+ * it already has enough spare pages.  Each insertion can split every page
+ * from the bottom of the tree to the top and then add a new topmost page.
+ * A page that has just been split is only half full, so the levels that are
+ * added by those insertions split far less often than once per insertion and
+ * only a couple of extra pages are needed for them.
+ */
+
+MP_GLOBAL
+size_t
+__mp_treereserve(treeroot *t, size_t n)
+{
+    size_t l;
+
+    if (t->null.flag != BTREE_ROOT)
+        return 0;
+    l = (n * (t->height + 1)) + 2;
+    if (l <= t->pages)
+        return 0;
+    return (l - t->pages) * sizeof(treepage);
+}
+
+
+/* Add as many pages as will fit in a block of memory to the spare pages of a
+ * B-tree.  The memory will never be given back.
+ */
+
+MP_GLOBAL
+void
+__mp_treepages(treeroot *t, void *p, size_t l)
+{
+    treepage *a;
+
+    while (l >= sizeof(treepage))
+    {
+        a = (treepage *) p;
+        a->parent = t->spare;
+        t->spare = a;
+        t->pages++;
+        p = (char *) p + sizeof(treepage);
+        l -= sizeof(treepage);
+    }
+}
+
+
+/* Remove a page from the spare pages of a B-tree.  The caller must have made
+ * sure that there is at least one spare page.
+ */
+
+static
+treepage *
+getpage(treeroot *t)
+{
+    treepage *p;
+
+    p = t->spare;
+    t->spare = p->parent;
+    t->pages--;
+    return p;
+}
+
+
+/* Return a page that is no longer used by a B-tree to its spare pages.
+ */
+
+static
+void
+freepage(treeroot *t, treepage *p)
+{
+    p->parent = t->spare;
+    t->spare = p;
+    t->pages++;
+}
+
+
+/* Record which page refers to a given child page or tree node.
+ */
+
+static
+void
+setparent(treepage *p, void *c)
+{
+    if (p->leaf)
+        ((treenode *) c)->parent = (treenode *) p;
+    else
+        ((treepage *) c)->parent = p;
+}
+
+
+/* Return the position of a child page within its parent page.
+ */
+
+static
+size_t
+findchild(treepage *p, treepage *c)
+{
+    size_t i;
+
+    for (i = 0; p->child[i] != c; i++);
+    return i;
+}
+
+
+/* Insert a new entry into a page of a B-tree at a specific position.  If the
+ * page is full then it is split in two and the new page is inserted into
+ * the parent page, which may in turn need to be split.
+ */
+
+static
+void
+insertentry(treeroot *t, treepage *p, size_t i, unsigned long k, void *c)
+{
+    treepage *q, *r;
+    size_t j, m;
+
+    if (p->count == MP_TREEPAGE_SIZE)
+    {
+        q = getpage(t);
+        q->leaf = p->leaf;
+        m = MP_TREEPAGE_SIZE / 2;
+        q->count = p->count - m;
+        for (j = 0; j < q->count; j++)
+        {
+            q->keys[j] = p->keys[m + j];
+            q->child[j] = p->child[m + j];
+            setparent(q, q->child[j]);
+        }
+        p->count = m;
+        if (i <= m)
+            insertentry(t, p, i, k, c);
+        else
+            insertentry(t, q, i - m, k, c);
+        if ((r = p->parent) == NULL)
+        {
+            r = getpage(t);
+            r->parent = NULL;
+            r->count = 2;
+            r->leaf = 0;
+            r->keys[0] = p->keys[0];
+            r->child[0] = p;
+            r->keys[1] = q->keys[0];
+            r->child[1] = q;
+            p->parent = q->parent = r;
+            t->page = r;
+            t->height++;
+        }
+        else
+            insertentry(t, r, findchild(r, p) + 1, q->keys[0], q);
+        return;
+    }
+    for (j = p->count; j > i; j--)
+    {
+        p->keys[j] = p->keys[j - 1];
+        p->child[j] = p->child[j - 1];
+    }
+    p->keys[i] = k;
+    p->child[i] = c;
+    setparent(p, c);
+    p->count++;
+}
+
+
+/* Remove an entry from a page of a B-tree.  If the page becomes less than
+ * half full then it is either merged with or takes entries from one of its
+ * siblings, which may in turn cause its parent page to become less than
+ * half full.
+ */
+
+static
+void
+removeentry(treeroot *t, treepage *p, size_t i)
+{
+    treepage *l, *q, *r;
+    size_t c, j;
+
+    for (p->count--; i < p->count; i++)
+    {
+        p->keys[i] = p->keys[i + 1];
+        p->child[i] = p->child[i + 1];
+    }
+    if ((r = p->parent) == NULL)
+    {
+        /* The topmost page is removed if it becomes empty or if it only
+         * refers to one other page.
+         */
+        if (p->count == 0)
+        {
+            t->page = NULL;
+            t->height = 0;
+            freepage(t, p);
+        }
+        else if (!p->leaf && (p->count == 1))
+        {
+            t->page = (treepage *) p->child[0];
+            t->page->parent = NULL;
+            t->height--;
+            freepage(t, p);
+        }
+        return;
+    }
+    if (p->count >= MP_TREEPAGE_SIZE / 2)
+        return;
+    if ((j = findchild(r, p)) > 0)
+    {
+        l = (treepage *) r->child[--j];
+        q = p;
+    }
+    else
+    {
+        l = p;
+        q = (treepage *) r->child[1];
+    }
+    /* The first key in a page that does not refer to tree nodes is never
+     * used when searching it, so make sure that it matches the key in the
+     * parent page before any entries are moved.
+     */
+    if (!q->leaf)
+        q->keys[0] = r->keys[j + 1];
+    if (l->count + q->count <= MP_TREEPAGE_SIZE)
+    {
+        for (i = 0; i < q->count; i++)
+        {
+            l->keys[l->count + i] = q->keys[i];
+            l->child[l->count + i] = q->child[i];
+            setparent(l, q->child[i]);
+        }
+        l->count += q->count;
+        freepage(t, q);
+        removeentry(t, r, j + 1);
+        return;
+    }
+    if (l->count < q->count)
+    {
+        c = ((l->count + q->count) / 2) - l->count;
+        for (i = 0; i < c; i++)
+        {
+            l->keys[l->count + i] = q->keys[i];
+            l->child[l->count + i] = q->child[i];
+            setparent(l, q->child[i]);
+        }
+        l->count += c;
+        for (q->count -= c, i = 0; i < q->count; i++)
+        {
+            q->keys[i] = q->keys[i + c];
+            q->child[i] = q->child[i + c];
+        }
+    }
+    else
+    {
+        c = l->count - ((l->count + q->count) / 2);
+        for (i = q->count; i > 0; i--)
+        {
+            q->keys[i + c - 1] = q->keys[i - 1];
+            q->child[i + c - 1] = q->child[i - 1];
+        }
+        for (l->count -= c, i = 0; i < c; i++)
+        {
+            q->keys[i] = l->keys[l->count + i];
+            q->child[i] = l->child[l->count + i];
+            setparent(q, q->child[i]);
+        }
+        q->count += c;
+    }
+    r->keys[j + 1] = q->keys[0];
+}
+
+
+/* Insert a new tree node with a specific key into a B-tree, after any
+ * existing nodes with the same key.  The tree node is not inserted if there
+ * might not be enough spare pages.
+ */
+
+static
+int
+btreeinsert(treeroot *t, treenode *n, unsigned long k)
+{
+    treenode *a;
+    treepage *p;
+    size_t i;
+
+    if (t->pages < t->height + 1)
+        return 0;
+    n->key = k;
+    n->flag = BTREE_NODE;
+    if ((p = t->page) == NULL)
+    {
+        p = getpage(t);
+        p->parent = NULL;
+        p->count = 0;
+        p->leaf = 1;
+        t->page = p;
+        t->height = 1;
+        n->left = n->right = NULL;
+        i = 0;
+    }
+    else
+    {
+        while (!p->leaf)
+        {
+            for (i = 1; (i < p->count) && (p->keys[i] <= k); i++);
+            p = (treepage *) p->child[i - 1];
+        }
+        for (i = 0; (i < p->count) && (p->keys[i] <= k); i++);
+        if (i > 0)
+        {
+            a = (treenode *) p->child[i - 1];
+            n->left = a;
+            n->right = a->right;
+        }
+        else
+        {
+            a = (treenode *) p->child[0];
+            n->left = a->left;
+            n->right = a;
+        }
+    }
+    if (n->left)
+        n->left->right = n;
+    else
+        t->null.left = n;
+    if (n->right)
+        n->right->left = n;
+    else
+        t->null.right = n;
+    insertentry(t, p, i, k, n);
+    t->size++;
+    return 1;
+}
+
+
+/* Remove an existing tree node from a B-tree.
+ */
+
+static
+void
+btreeremove(treeroot *t, treenode *n)
+{
+    treepage *p;
+    size_t i;
+
+    p = (treepage *) n->parent;
+    for (i = 0; p->child[i] != n; i++);
+    if (n->left)
+        n->left->right = n->right;
+    else
+        t->null.left = n->right;
+    if (n->right)
+        n->right->left = n->left;
+    else
+        t->null.right = n->left;
+    n->parent = n->left = n->right = NULL;
+    removeentry(t, p, i);
+    t->size--;
+}
+
+
+/* Search a B-tree for the node with the highest key not greater than the
+ * given key, or return NULL if no such node exists.
+ */
+
+static
+treenode *
+btreesearchlower(treeroot *t, unsigned long k)
+{
+    treepage *p;
+    size_t i;
+
+    if ((p = t->page) == NULL)
+        return NULL;
+    while (!p->leaf)
+    {
+        for (i = 1; (i < p->count) && (p->keys[i] <= k); i++);
+        p = (treepage *) p->child[i - 1];
+    }
+    for (i = 0; (i < p->count) && (p->keys[i] <= k); i++);
+    if (i > 0)
+        return (treenode *) p->child[i - 1];
+    return ((treenode *) p->child[0])->left;
+}
+
+
+/* Search a B-tree for the node with the lowest key not less than the
+ * given key, or return NULL if no such node exists.
+ */
+
+static
+treenode *
+btreesearchhigher(treeroot *t, unsigned long k)
+{
+    treepage *p;
+    size_t i;
+
+    if ((p = t->page) == NULL)
+        return NULL;
+    while (!p->leaf)
+    {
+        for (i = 1; (i < p->count) && (p->keys[i] < k); i++);
+        p = (treepage *) p->child[i - 1];
+    }
+    for (i = 0; (i < p->count) && (p->keys[i] < k); i++);
+    if (i < p->count)
+        return (treenode *) p->child[i];
+    return ((treenode *) p->child[p->count - 1])->right;
 }
 
 
@@ -110,17 +551,20 @@ rotateright(treeroot *t, treenode *r)
 
 /* Insert a new tree node with a specific key into a tree, possibly
  * restructuring the tree in order to preserve the red-black property and
- * keep it properly balanced.
+ * keep it properly balanced.  This can only fail for a B-tree that might
+ * not have enough spare pages.
  */
 
 MP_GLOBAL
-void
+int
 __mp_treeinsert(treeroot *t, treenode *n, unsigned long k)
 {
     treenode *a, *b;
 
     if (n == &t->null)
-        return;
+        return 0;
+    if (t->null.flag == BTREE_ROOT)
+        return btreeinsert(t, n, k);
     a = t->root;
     b = NULL;
     while (a->left)
@@ -183,6 +627,7 @@ __mp_treeinsert(treeroot *t, treenode *n, unsigned long k)
             }
     t->root->flag = 0;
     t->size++;
+    return 1;
 }
 
 
@@ -200,6 +645,11 @@ __mp_treeremove(treeroot *t, treenode *n)
 
     if (n == &t->null)
         return;
+    if (t->null.flag == BTREE_ROOT)
+    {
+        btreeremove(t, n);
+        return;
+    }
     if ((n->left->left == NULL) || (n->right->right == NULL))
         b = n;
     else
@@ -302,13 +752,21 @@ __mp_treeremove(treeroot *t, treenode *n)
 
 
 /* Search a subtree for a node with an exact match for a given key,
- * or return NULL if no such node exists.
+ * or return NULL if no such node exists.  Only the whole of a B-tree can be
+ * searched.
  */
 
 MP_GLOBAL
 treenode *
 __mp_search(treenode *n, unsigned long k)
 {
+    if (n->flag == BTREE_ROOT)
+    {
+        if (((n = btreesearchhigher(btreeroot(n), k)) != NULL) &&
+            (n->key == k))
+            return n;
+        return NULL;
+    }
     while (n->left && (k != n->key))
         if (k < n->key)
             n = n->left;
@@ -330,6 +788,8 @@ __mp_searchlower(treenode *n, unsigned long k)
 {
     treenode *a;
 
+    if (n->flag == BTREE_ROOT)
+        return btreesearchlower(btreeroot(n), k);
     a = n;
     while (n->left && (k != n->key))
     {
@@ -357,6 +817,8 @@ __mp_searchhigher(treenode *n, unsigned long k)
 {
     treenode *a;
 
+    if (n->flag == BTREE_ROOT)
+        return btreesearchhigher(btreeroot(n), k);
     a = n;
     while (n->right && (k != n->key))
     {
@@ -383,6 +845,8 @@ __mp_minimum(treenode *n)
 {
     treenode *a;
 
+    if (n->flag == BTREE_ROOT)
+        return n->left;
     if (n->left == NULL)
         return NULL;
     while ((a = n->left)->left)
@@ -400,6 +864,8 @@ __mp_maximum(treenode *n)
 {
     treenode *a;
 
+    if (n->flag == BTREE_ROOT)
+        return n->right;
     if (n->right == NULL)
         return NULL;
     while ((a = n->right)->right)
@@ -418,6 +884,8 @@ __mp_predecessor(treenode *n)
 {
     treenode *a;
 
+    if (n->flag == BTREE_NODE)
+        return n->left;
     if (n->left == NULL)
         return NULL;
     if (n->left->left)
@@ -442,6 +910,8 @@ __mp_successor(treenode *n)
 {
     treenode *a;
 
+    if (n->flag == BTREE_NODE)
+        return n->right;
     if (n->right == NULL)
         return NULL;
     if (n->right->right)
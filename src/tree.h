@@ -27,7 +27,9 @@
  * library are based on the following data structures and use the same
  * interface for building and traversing them.  Only the linkage between
  * tree nodes is dealt with by this module - dynamically allocating
- * memory for nodes is done elsewhere.
+ * memory for nodes is done elsewhere.  A tree can alternatively be
+ * created as a B-tree, in which case the memory for its index pages must
+ * also be supplied from elsewhere.
  */
 
 
@@ -41,7 +43,10 @@
 
 
 /* A tree node simply contains linkage information and is intended to be
- * used as a member for any datatypes that need to belong to a tree.
+ * used as a member for any datatypes that need to belong to a tree.  If the
+ * node belongs to a B-tree then the parent node is actually the index page
+ * which refers to it, and the left and right child nodes are actually its
+ * predecessor and successor nodes.
  */
 
 typedef struct treenode
@@ -55,9 +60,30 @@ typedef struct treenode
 treenode;
 
 
+/* A tree page is an index page in a B-tree and contains the keys and
+ * pointers of up to MP_TREEPAGE_SIZE child pages, or of up to
+ * MP_TREEPAGE_SIZE tree nodes if it is at the bottom of the B-tree.  The
+ * first key in each page is the lowest key of its first child and each
+ * subsequent key is not greater than any key in the corresponding child.
+ */
+
+typedef struct treepage
+{
+    struct treepage *parent;               /* parent page in tree */
+    unsigned int count;                    /* number of entries */
+    unsigned int leaf;                     /* page refers to tree nodes */
+    unsigned long keys[MP_TREEPAGE_SIZE];  /* search keys */
+    void *child[MP_TREEPAGE_SIZE];         /* child pages or tree nodes */
+}
+treepage;
+
+
 /* A tree root contains a pointer to the topmost node of the tree and
  * also contains a sentinel leaf node in order to make tree manipulation
- * simpler.
+ * simpler.  The topmost node of a B-tree is always the sentinel leaf node,
+ * whose left and right child nodes are the lowest and highest nodes in the
+ * tree, and its index pages are held separately along with any pages that
+ * have been supplied but are not currently in use.
  */
 
 typedef struct treeroot
@@ -65,6 +91,10 @@ typedef struct treeroot
     struct treenode *root; /* topmost node of tree */
     struct treenode null;  /* leaf node for tree */
     size_t size;           /* number of nodes in tree */
+    treepage *page;        /* topmost page of B-tree */
+    treepage *spare;       /* list of spare pages */
+    size_t pages;          /* number of spare pages */
+    size_t height;         /* number of levels in B-tree */
 }
 treeroot;
 
@@ -76,7 +106,10 @@ extern "C"
 
 
 MP_EXPORT void __mp_newtree(treeroot *);
-MP_EXPORT void __mp_treeinsert(treeroot *, treenode *, unsigned long);
+MP_EXPORT void __mp_newbtree(treeroot *);
+MP_EXPORT size_t __mp_treereserve(treeroot *, size_t);
+MP_EXPORT void __mp_treepages(treeroot *, void *, size_t);
+MP_EXPORT int __mp_treeinsert(treeroot *, treenode *, unsigned long);
 MP_EXPORT void __mp_treeremove(treeroot *, treenode *);
 MP_EXPORT treenode *__mp_search(treenode *, unsigned long);
 MP_EXPORT treenode *__mp_searchlower(treenode *, unsigned long);
@@ -0,0 +1,148 @@
+#!/bin/sh
+
+
+# mpatrol
+# A library for controlling and tracing dynamic memory allocations.
+# Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+#
+# This program is free software: you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or (at
+# your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+# General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+# UNIX shell script to replay a tracing output file against the system malloc
+# library, libmpalloc and libmpatrol with several different options, and then
+# to run the vector growth and per-block overhead benchmarks in the same way -
+# the replay, growth and overhead programs and their -mpalloc and -mpatrol
+# variants must have already been built in the given directory, along with
+# the trees program which compares red-black trees with B-trees - the number
+# of data TLB misses is also shown for each run if perf is available
+
+
+# $Id$
+
+
+if [ $# -lt 1 ] || [ $# -gt 2 ]
+then
+    echo "Usage: $0 file [directory]" >&2
+    exit 1
+fi
+
+trace="$1"
+dir="${2-.}"
+
+if [ ! -f "$trace" ]
+then
+    echo "cannot locate tracing file $trace" >&2
+    exit 1
+fi
+
+
+# Any files written by libmpatrol go to a temporary directory so that they
+# cannot overwrite the tracing output file being replayed.
+
+tmp="${TMPDIR-/tmp}/mpbench.$$"
+mkdir "$tmp" || exit 1
+trap 'rm -rf "$tmp"' 0 1 2 15
+files="LOGFILE=$tmp/mpatrol.log PROFFILE=$tmp/mpatrol.out"
+files="$files TRACEFILE=$tmp/mpatrol.trace"
+
+
+# If perf can read the data TLB miss counters then the number of misses is
+# also shown for each configuration, otherwise only the throughput is shown.
+
+if perf stat -e dTLB-load-misses -o /dev/null true >/dev/null 2>&1
+then
+    perf="perf stat -x , -e dTLB-load-misses,dTLB-store-misses -o $tmp/perf"
+else
+    perf=""
+fi
+
+
+# Run a benchmark program with the given mpatrol options and show the number
+# of data TLB misses if they were counted.
+
+launch()
+{
+    options="$1"
+    shift
+    MPATROL_OPTIONS="$files $options" $perf "$@" || exit 1
+    if [ -n "$perf" ]
+    then
+        awk -F , '$3 ~ /TLB/ { n += $1 }
+                  END { printf "%-12s %14.0f dTLB misses\n", "", n }' \
+            "$tmp/perf"
+    fi
+}
+
+
+# Run the replay program for a single configuration.
+
+run()
+{
+    launch "$3" "$dir/$2" "$trace" "$1"
+}
+
+
+# Run the vector growth program for a single configuration.
+
+grow()
+{
+    launch "$3" "$dir/$2" "$1"
+}
+
+
+# Run the tree program for a single kind of tree and number of nodes.
+
+trees()
+{
+    launch "" "$dir/trees" "$2" "$1" "$3"
+}
+
+
+# Run the per-block overhead program for a single configuration.
+
+overhead()
+{
+    launch "$3" "$dir/$2" "$1"
+}
+
+
+run system replay ""
+run mpalloc replay-mpalloc ""
+run default replay-mpatrol ""
+run check replay-mpatrol "CHECK=-"
+run hugepages replay-mpatrol "HUGEPAGES"
+run pagealloc replay-mpatrol "PAGEALLOC=UPPER"
+run oflowwatch replay-mpatrol "OFLOWSIZE=8 OFLOWWATCH"
+run prof replay-mpatrol "PROF"
+run trace replay-mpatrol "TRACE"
+
+echo
+grow system growth ""
+grow mpalloc growth-mpalloc ""
+grow default growth-mpatrol ""
+grow hugepages growth-mpatrol "HUGEPAGES"
+grow pagealloc growth-mpatrol "PAGEALLOC=UPPER"
+grow pagelower growth-mpatrol "PAGEALLOC=LOWER"
+grow nofree growth-mpatrol "NOFREE=16"
+
+echo
+overhead system overhead ""
+overhead mpalloc overhead-mpalloc ""
+overhead default overhead-mpatrol ""
+
+echo
+trees rbtree-1M rbtree 1000000
+trees btree-1M btree 1000000
+trees rbtree-100M rbtree 100000000
+trees btree-100M btree 100000000
@@ -0,0 +1,124 @@
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Grows several vectors side by side by repeatedly calling realloc() to
+ * extend each of them by a fixed number of bytes, timing each call.  Since
+ * the vectors are grown in turn, none of them can simply be extended into
+ * the memory that follows it unless the malloc library has reserved some
+ * space there.  The number of calls per second, the median and 99th
+ * percentile call latencies and the peak resident set size of the process
+ * are then displayed on a single line in the same format as the replay
+ * program.  If this file is compiled with MPBENCH_MPATROL defined then the
+ * calls are made through mpatrol.h so that the resulting program can be
+ * linked with either libmpatrol or libmpalloc.
+ */
+
+
+#include "harness.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#ifdef MPBENCH_MPATROL
+#include "mpatrol.h"
+#endif /* MPBENCH_MPATROL */
+
+
+/* The default number of vectors, the default final size of each vector and
+ * the default number of bytes that each vector is extended by.
+ */
+
+#define VECTORS 4
+#define MAXSIZE 0x400000
+#define STEPSIZE 0x1000
+
+
+static unsigned long *latencies;
+static void **vectors;
+static unsigned long nvectors, maxsize, stepsize, ncalls;
+
+
+/* Grow each vector in turn, timing each call.  The last element of each
+ * vector is written after every call so that a malloc library which does
+ * not really provide the memory cannot appear to be faster.
+ */
+
+static void grow(void)
+{
+    unsigned long i, j, l, t;
+
+    for (i = 0, l = stepsize; l <= maxsize; l += stepsize)
+        for (j = 0; j < nvectors; j++, i++)
+        {
+            t = now();
+            vectors[j] = realloc(vectors[j], l);
+            latencies[i] = now() - t;
+            if (vectors[j] == NULL)
+            {
+                fputs("Out of memory\n", stderr);
+                exit(EXIT_FAILURE);
+            }
+            ((char *) vectors[j])[l - 1] = (char) j;
+        }
+}
+
+
+int main(int argc, char **argv)
+{
+    struct rusage u;
+    char *s;
+    unsigned long i, t;
+    double r;
+
+    if (argc > 5)
+    {
+        fprintf(stderr, "Usage: %s [label [vectors [size [step]]]]\n",
+                argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    s = (argc > 1) ? argv[1] : argv[0];
+    nvectors = (argc > 2) ? getnumber(argv[2]) : VECTORS;
+    maxsize = (argc > 3) ? getnumber(argv[3]) : MAXSIZE;
+    stepsize = (argc > 4) ? getnumber(argv[4]) : STEPSIZE;
+    ncalls = (maxsize / stepsize) * nvectors;
+    latencies = (unsigned long *) getmemory((ncalls + 1) *
+                                            sizeof(unsigned long));
+    vectors = (void **) getmemory(nvectors * sizeof(void *));
+    memset(vectors, 0, nvectors * sizeof(void *));
+    t = now();
+    grow();
+    t = now() - t;
+    if (getrusage(RUSAGE_SELF, &u) != 0)
+        u.ru_maxrss = 0;
+    for (i = 0; i < nvectors; i++)
+        free(vectors[i]);
+    if (ncalls > 0)
+        qsort(latencies, ncalls, sizeof(unsigned long), comparelatency);
+    r = (t > 0) ? (double) ncalls * 1000000000.0 / (double) t : 0.0;
+    fprintf(stdout, "%-12s %10lu ops %12.0f ops/sec", s, ncalls, r);
+    if (ncalls > 0)
+        fprintf(stdout, "  p50 %8lu ns  p99 %8lu ns",
+                latencies[(ncalls - 1) / 2], latencies[(ncalls * 99) / 100]);
+    fprintf(stdout, "  peak RSS %8ld KB\n", (long) u.ru_maxrss);
+    (free)(latencies);
+    (free)(vectors);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/*
+ * Support functions that are shared by the benchmark programs.
+ */
+
+
+#include "harness.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+
+
+/* Allocate memory for the harness itself and abort if there is none left.
+ */
+
+void *getmemory(size_t l)
+{
+    void *p;
+
+    if ((p = malloc(l)) == NULL)
+    {
+        fputs("Out of memory\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+
+/* Read a positive number from the command line.
+ */
+
+unsigned long getnumber(char *s)
+{
+    char *t;
+    unsigned long n;
+
+    n = strtoul(s, &t, 0);
+    if ((*s == '\0') || (*t != '\0') || (n == 0))
+    {
+        fprintf(stderr, "Invalid number %s\n", s);
+        exit(EXIT_FAILURE);
+    }
+    return n;
+}
+
+
+/* Return the current time in nanoseconds, using a monotonic clock if the
+ * system has one.
+ */
+
+unsigned long now(void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long) t.tv_sec * 1000000000UL + (unsigned long) t.tv_nsec;
+#else /* CLOCK_MONOTONIC */
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    return (unsigned long) t.tv_sec * 1000000000UL +
+           (unsigned long) t.tv_usec * 1000UL;
+#endif /* CLOCK_MONOTONIC */
+}
+
+
+/* Compare two latencies for qsort().
+ */
+
+int comparelatency(const void *a, const void *b)
+{
+    unsigned long x, y;
+
+    x = *((const unsigned long *) a);
+    y = *((const unsigned long *) b);
+    if (x < y)
+        return -1;
+    else if (x > y)
+        return 1;
+    return 0;
+}
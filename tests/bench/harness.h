@@ -0,0 +1,44 @@
+#ifndef MPBENCH_HARNESS_H
+#define MPBENCH_HARNESS_H
+
+
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/*
+ * Support functions that are shared by the benchmark programs.  They are
+ * compiled without mpatrol.h so that the memory used by the harness itself is
+ * never allocated through its macros.  That memory is still allocated by
+ * libmpatrol or libmpalloc if the benchmark program is linked with either of
+ * them, since they replace the malloc library as a whole.
+ */
+
+
+#include <stddef.h>
+
+
+void *getmemory(size_t);
+unsigned long getnumber(char *);
+unsigned long now(void);
+int comparelatency(const void *, const void *);
+
+
+#endif /* MPBENCH_HARNESS_H */
@@ -0,0 +1,160 @@
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Makes a large number of small allocations and keeps all of them live in
+ * order to measure how much memory the malloc library uses to keep track
+ * of each block.  The number of calls per second, the peak resident set
+ * size of the process and the number of bytes of resident memory used per
+ * block beyond the size that was requested are then displayed on a single
+ * line.  Where the process memory map can be read from /proc/self/maps, the
+ * number of memory mappings that were created per block is also displayed,
+ * which shows the cost of giving each block its own pages.  If this file is compiled with MPBENCH_MPATROL defined then the
+ * calls are made through mpatrol.h so that the resulting program can be
+ * linked with either libmpatrol or libmpalloc, and the number of bytes of
+ * internal memory that mpatrol uses per block is also displayed.
+ */
+
+
+#include "harness.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#ifdef MPBENCH_MPATROL
+#include "mpatrol.h"
+#endif /* MPBENCH_MPATROL */
+
+
+/* The default number of blocks and the default size of each block.
+ */
+
+#define BLOCKS 10000000
+#define BLOCKSIZE 16
+
+
+static void **blocks;
+static unsigned long nblocks, blocksize;
+
+
+/* Return the peak resident set size of the process in kilobytes.
+ */
+
+static long peakrss(void)
+{
+    struct rusage u;
+
+    if (getrusage(RUSAGE_SELF, &u) != 0)
+        return 0;
+    return (long) u.ru_maxrss;
+}
+
+
+/* Return the number of memory mappings in the process, or -1 if the process
+ * memory map cannot be read.
+ */
+
+static long mappings(void)
+{
+    FILE *f;
+    long n;
+    int c;
+
+    if ((f = fopen("/proc/self/maps", "r")) == NULL)
+        return -1;
+    n = 0;
+    while ((c = fgetc(f)) != EOF)
+        if (c == '\n')
+            n++;
+    fclose(f);
+    return n;
+}
+
+
+/* Allocate all of the blocks, writing to the first byte of each so that a
+ * malloc library which does not really provide the memory cannot appear to
+ * use less of it.
+ */
+
+static void allocate(void)
+{
+    unsigned long i;
+
+    for (i = 0; i < nblocks; i++)
+    {
+        if ((blocks[i] = malloc(blocksize)) == NULL)
+        {
+            fputs("Out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        *((char *) blocks[i]) = (char) i;
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+#ifdef MPBENCH_MPATROL
+    __mp_heapinfo h;
+#endif /* MPBENCH_MPATROL */
+    char *s;
+    unsigned long i, t;
+    long b, m, n, p;
+    double r;
+
+    if (argc > 4)
+    {
+        fprintf(stderr, "Usage: %s [label [blocks [size]]]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    s = (argc > 1) ? argv[1] : argv[0];
+    nblocks = (argc > 2) ? getnumber(argv[2]) : BLOCKS;
+    blocksize = (argc > 3) ? getnumber(argv[3]) : BLOCKSIZE;
+    /* The block array is touched before the baseline is taken so that it
+     * does not count towards the overhead of each block.
+     */
+    blocks = (void **) getmemory(nblocks * sizeof(void *));
+    memset(blocks, 0, nblocks * sizeof(void *));
+    b = peakrss();
+    m = mappings();
+    t = now();
+    allocate();
+    t = now() - t;
+    p = peakrss();
+    n = mappings();
+    r = (t > 0) ? (double) nblocks * 1000000000.0 / (double) t : 0.0;
+    fprintf(stdout, "%-12s %10lu ops %12.0f ops/sec", s, nblocks, r);
+    fprintf(stdout, "  peak RSS %8ld KB  %6.1f bytes/block", p,
+            ((double) (p - b) * 1024.0 / (double) nblocks) -
+            (double) blocksize);
+    if ((m >= 0) && (n >= 0))
+        fprintf(stdout, "  %6.2f mappings/block",
+                (double) (n - m) / (double) nblocks);
+#ifdef MPBENCH_MPATROL
+    if (__mp_stats(&h))
+        fprintf(stdout, "  internal %6.1f bytes/block",
+                (double) h.itotal / (double) nblocks);
+#endif /* MPBENCH_MPATROL */
+    fputc('\n', stdout);
+    for (i = 0; i < nblocks; i++)
+        free(blocks[i]);
+    (free)(blocks);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,356 @@
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Reads a tracing output file produced by the TRACE option and replays
+ * every allocation, reallocation and deallocation in it, timing each call.
+ * The number of calls per second, the median and 99th percentile call
+ * latencies and the peak resident set size of the process are then
+ * displayed on a single line.  If this file is compiled with MPBENCH_MPATROL
+ * defined then the replayed calls are made through mpatrol.h so that the
+ * resulting program can be linked with either libmpatrol or libmpalloc.
+ * The memory used to hold the decoded events is obtained before any of the
+ * calls are timed.  The parenthesised function names that are used for it
+ * only bypass the macros in mpatrol.h, so when the program is linked with
+ * libmpatrol or libmpalloc that memory is still allocated by the library
+ * being measured, although not from any of the timed calls.  The peak
+ * resident set size is a high water mark of the whole process and so also
+ * includes the tracing output file and the arrays used by the harness.  The
+ * peak before the events are replayed is therefore displayed alongside it.
+ */
+
+
+#include "harness.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#ifdef MPBENCH_MPATROL
+#include "mpatrol.h"
+#endif /* MPBENCH_MPATROL */
+
+
+/* The magic sequence of bytes at the start and end of a tracing output file
+ * and the earliest version of mpatrol which wrote source-level information
+ * for each event.
+ */
+
+#define TRACEMAGIC "MTRC"
+#define SOURCEVER  10405
+
+
+/* An event records a single replayed call.  The slot is an index into the
+ * array of live pointers, the size is zero for a deallocation, and the type
+ * is one of the event characters from the tracing output file.
+ */
+
+typedef struct event
+{
+    unsigned long slot;
+    unsigned long size;
+    char type;
+}
+event;
+
+
+static char *buffer, *bufferpos, *bufferend, *eventstart;
+static unsigned long version;
+static event *events;
+static unsigned long *slotmap;
+static unsigned long *latencies;
+static void **slots;
+static unsigned long nevents, maxindex, nslots;
+
+
+/* Report a malformed tracing output file.
+ */
+
+static void badfile(void)
+{
+    fputs("Invalid tracing file\n", stderr);
+    exit(EXIT_FAILURE);
+}
+
+
+/* Read an unsigned LEB128 number from the tracing output file.
+ */
+
+static unsigned long getuleb128(void)
+{
+    unsigned long n;
+    unsigned int s;
+    unsigned char c;
+
+    n = 0;
+    s = 0;
+    do
+    {
+        if (bufferpos >= bufferend)
+            badfile();
+        c = (unsigned char) *bufferpos++;
+        if (s < sizeof(unsigned long) * 8)
+            n |= (unsigned long) (c & 0x7F) << s;
+        s += 7;
+    }
+    while (c & 0x80);
+    return n;
+}
+
+
+/* Skip over a cached function or file name.
+ */
+
+static void skipname(void)
+{
+    if (bufferpos >= bufferend)
+        badfile();
+    if ((unsigned char) *bufferpos++ & 0x80)
+    {
+        while ((bufferpos < bufferend) && (*bufferpos != '\0'))
+            bufferpos++;
+        if (bufferpos >= bufferend)
+            badfile();
+        bufferpos++;
+    }
+}
+
+
+/* Skip over the source-level information for an event.
+ */
+
+static void skipsource(void)
+{
+    if (version >= SOURCEVER)
+    {
+        getuleb128();
+        skipname();
+        skipname();
+        getuleb128();
+    }
+}
+
+
+/* Read the entire tracing output file into memory and check its header.
+ */
+
+static void readfile(char *s)
+{
+    FILE *f;
+    size_t i;
+    long l;
+
+    if ((f = fopen(s, "rb")) == NULL)
+    {
+        fprintf(stderr, "Cannot open %s\n", s);
+        exit(EXIT_FAILURE);
+    }
+    if ((fseek(f, 0, SEEK_END) != 0) || ((l = ftell(f)) < 0) ||
+        (fseek(f, 0, SEEK_SET) != 0))
+    {
+        fprintf(stderr, "Cannot read %s\n", s);
+        exit(EXIT_FAILURE);
+    }
+    buffer = (char *) getmemory(l + 1);
+    if (fread(buffer, sizeof(char), l, f) != (size_t) l)
+    {
+        fprintf(stderr, "Cannot read %s\n", s);
+        exit(EXIT_FAILURE);
+    }
+    fclose(f);
+    bufferend = buffer + l;
+    if ((l < (long) (8 + sizeof(size_t) + sizeof(unsigned long))) ||
+        (memcmp(buffer, TRACEMAGIC, 4) != 0) ||
+        (memcmp(bufferend - 4, TRACEMAGIC, 4) != 0))
+        badfile();
+    memcpy(&i, buffer + 4, sizeof(size_t));
+    if (i != 1)
+    {
+        fputs("Tracing file was written on a different architecture\n",
+              stderr);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(&version, buffer + 4 + sizeof(size_t), sizeof(unsigned long));
+    eventstart = buffer + 4 + sizeof(size_t) + sizeof(unsigned long);
+    bufferend -= 4;
+}
+
+
+/* Scan the events in the tracing output file.  On the first pass we just
+ * count the events and find the highest allocation index, and on the second
+ * pass we fill in the event array, mapping each allocation index onto a slot
+ * in the array of live pointers.  Events that refer to allocations that were
+ * never seen are ignored.
+ */
+
+static void scanfile(int d)
+{
+    event *e;
+    unsigned long i, l;
+
+    e = events;
+    bufferpos = eventstart;
+    while (bufferpos < bufferend)
+        switch (*bufferpos++)
+        {
+          case 'A':
+          case 'R':
+            i = getuleb128();
+            getuleb128();
+            l = getuleb128();
+            skipsource();
+            if (d == 0)
+            {
+                if (i > maxindex)
+                    maxindex = i;
+                nevents++;
+            }
+            else if ((i == 0) || (i > maxindex))
+                break;
+            else if (slotmap[i] == 0)
+            {
+                slotmap[i] = ++nslots;
+                e->type = 'A';
+                e->slot = nslots - 1;
+                e->size = l;
+                e++;
+            }
+            else
+            {
+                e->type = 'R';
+                e->slot = slotmap[i] - 1;
+                e->size = l;
+                e++;
+            }
+            break;
+          case 'F':
+            i = getuleb128();
+            skipsource();
+            if (d == 0)
+                nevents++;
+            else if ((i != 0) && (i <= maxindex) && (slotmap[i] != 0))
+            {
+                e->type = 'F';
+                e->slot = slotmap[i] - 1;
+                e->size = 0;
+                e++;
+                slotmap[i] = 0;
+            }
+            break;
+          case 'H':
+          case 'I':
+            getuleb128();
+            getuleb128();
+            break;
+          default:
+            badfile();
+        }
+    if (d != 0)
+        nevents = e - events;
+}
+
+
+/* Replay the events, timing each call.
+ */
+
+static void replay(void)
+{
+    event *e;
+    void *p;
+    unsigned long i, t;
+
+    for (i = 0; i < nevents; i++)
+    {
+        e = &events[i];
+        t = now();
+        if (e->type == 'A')
+            p = slots[e->slot] = malloc(e->size);
+        else if (e->type == 'R')
+            p = slots[e->slot] = realloc(slots[e->slot], e->size);
+        else
+        {
+            free(slots[e->slot]);
+            slots[e->slot] = p = NULL;
+        }
+        latencies[i] = now() - t;
+        if ((p == NULL) && (e->type != 'F') && (e->size != 0))
+        {
+            fputs("Out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    struct rusage u;
+    char *s;
+    long b;
+    unsigned long i, t;
+    double r;
+
+    if ((argc < 2) || (argc > 3))
+    {
+        fprintf(stderr, "Usage: %s file [label]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    s = (argc == 3) ? argv[2] : argv[0];
+    readfile(argv[1]);
+    scanfile(0);
+    events = (event *) getmemory((nevents + 1) * sizeof(event));
+    slotmap = (unsigned long *) getmemory((maxindex + 1) *
+                                          sizeof(unsigned long));
+    memset(slotmap, 0, (maxindex + 1) * sizeof(unsigned long));
+    scanfile(1);
+    latencies = (unsigned long *) getmemory((nevents + 1) *
+                                            sizeof(unsigned long));
+    slots = (void **) getmemory((nslots + 1) * sizeof(void *));
+    memset(slots, 0, (nslots + 1) * sizeof(void *));
+    (free)(slotmap);
+    (free)(buffer);
+    if (getrusage(RUSAGE_SELF, &u) != 0)
+        u.ru_maxrss = 0;
+    b = (long) u.ru_maxrss;
+    t = now();
+    replay();
+    t = now() - t;
+    if (getrusage(RUSAGE_SELF, &u) != 0)
+        u.ru_maxrss = 0;
+    /* The remaining allocations are freed outside of the timed region so
+     * that programs which exit with unfreed memory are not penalised.
+     */
+    for (i = 0; i < nslots; i++)
+        if (slots[i] != NULL)
+            free(slots[i]);
+    if (nevents > 0)
+        qsort(latencies, nevents, sizeof(unsigned long),
+              comparelatency);
+    r = (t > 0) ? (double) nevents * 1000000000.0 / (double) t : 0.0;
+    fprintf(stdout, "%-12s %10lu ops %12.0f ops/sec", s, nevents, r);
+    if (nevents > 0)
+        fprintf(stdout, "  p50 %8lu ns  p99 %8lu ns",
+                latencies[(nevents - 1) / 2], latencies[(nevents * 99) / 100]);
+    fprintf(stdout, "  peak RSS %8ld KB (%8ld KB before replay)\n",
+            (long) u.ru_maxrss, b);
+    (free)(latencies);
+    (free)(slots);
+    (free)(events);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,234 @@
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Checks the trees that are used within the mpatrol library by making a
+ * long sequence of random insertions and removals, and comparing the results
+ * of searching and iterating over the tree against a brute force search of
+ * the tree nodes that should be in it.  The keys are chosen from a small
+ * range so that there are many tree nodes with the same key.  Each B-tree is
+ * only supplied with the exact amount of memory that is asked for by
+ * __mp_treereserve() before a random number of insertions.  The tree
+ * functions are called directly rather than through the mpatrol library.
+ */
+
+
+#include "tree.h"
+#include "harness.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* The default number of tree nodes and the default number of operations.
+ */
+
+#define NODES 2000
+#define OPERATIONS 100000
+
+
+static treeroot tree;
+static treenode *nodes;
+static char *used;
+static unsigned long nnodes, nused, seed;
+
+
+/* Return a 32-bit pseudo-random number.
+ */
+
+static unsigned long randomnumber(void)
+{
+    seed ^= (seed << 13) & 0xFFFFFFFFUL;
+    seed ^= seed >> 17;
+    seed ^= (seed << 5) & 0xFFFFFFFFUL;
+    return seed;
+}
+
+
+/* Report a difference between the tree and the brute force search and then
+ * terminate.
+ */
+
+static void fail(const char *s, unsigned long i)
+{
+    fprintf(stderr, "%s: operation %lu: %s\n", tree.null.flag ? "btree" :
+            "rbtree", i, s);
+    exit(EXIT_FAILURE);
+}
+
+
+/* Return a random key.  The range of keys is kept smaller than the number of
+ * tree nodes so that there are many duplicates.
+ */
+
+static unsigned long randomkey(void)
+{
+    return randomnumber() % ((nnodes >> 2) + 1);
+}
+
+
+/* Check that the tree contains exactly the tree nodes that should be in it,
+ * in ascending order of key when iterated over in both directions.
+ */
+
+static void checkorder(unsigned long i)
+{
+    treenode *n, *p;
+    unsigned long c;
+
+    if (tree.size != nused)
+        fail("wrong size", i);
+    for (n = __mp_minimum(tree.root), p = NULL, c = 0; n != NULL;
+         p = n, n = __mp_successor(n), c++)
+    {
+        if ((n < nodes) || (n >= nodes + nnodes) || !used[n - nodes])
+            fail("unexpected node", i);
+        if ((p != NULL) && (p->key > n->key))
+            fail("successor out of order", i);
+        if ((p != NULL) && (__mp_predecessor(n) != p))
+            fail("predecessor does not match successor", i);
+        if (c > nused)
+            fail("successor does not terminate", i);
+    }
+    if (c != nused)
+        fail("wrong number of nodes by successor", i);
+    if (__mp_maximum(tree.root) != p)
+        fail("maximum is not the last node", i);
+}
+
+
+/* Check the three search functions for a given key against the results of
+ * a brute force search.  Only the keys of the tree nodes that they return
+ * can be compared since they may return any one of the nodes that have the
+ * same key.
+ */
+
+static void checksearch(unsigned long k, unsigned long i)
+{
+    treenode *n;
+    unsigned long j;
+    int e, h, l;
+    unsigned long a, b;
+
+    e = h = l = 0;
+    a = b = 0;
+    for (j = 0; j < nnodes; j++)
+        if (used[j])
+        {
+            if (nodes[j].key == k)
+                e = 1;
+            if ((nodes[j].key <= k) && (!l || (nodes[j].key > a)))
+            {
+                a = nodes[j].key;
+                l = 1;
+            }
+            if ((nodes[j].key >= k) && (!h || (nodes[j].key < b)))
+            {
+                b = nodes[j].key;
+                h = 1;
+            }
+        }
+    n = __mp_search(tree.root, k);
+    if (e ? ((n == NULL) || (n->key != k)) : (n != NULL))
+        fail("search", i);
+    n = __mp_searchlower(tree.root, k);
+    if (l ? ((n == NULL) || (n->key != a)) : (n != NULL))
+        fail("searchlower", i);
+    n = __mp_searchhigher(tree.root, k);
+    if (h ? ((n == NULL) || (n->key != b)) : (n != NULL))
+        fail("searchhigher", i);
+}
+
+
+/* Perform a random sequence of insertions and removals on the tree,
+ * checking it after every operation.
+ */
+
+static void check(unsigned long o)
+{
+    size_t l;
+    unsigned long i, j, r;
+
+    memset(used, 0, nnodes);
+    nused = r = 0;
+    for (i = 0; i < o; i++)
+    {
+        j = randomnumber() % nnodes;
+        /* The balance between insertions and removals drifts slowly so that
+         * the tree grows and shrinks several times.
+         */
+        if ((((i / (nnodes << 1)) & 1) ? (randomnumber() % 4 == 0) :
+             (randomnumber() % 4 != 0)) && !used[j])
+        {
+            if (r == 0)
+            {
+                r = (randomnumber() % 64) + 1;
+                if ((l = __mp_treereserve(&tree, r)) != 0)
+                    __mp_treepages(&tree, getmemory(l), l);
+            }
+            if (!__mp_treeinsert(&tree, &nodes[j], randomkey()))
+                fail("insert failed", i);
+            used[j] = 1;
+            nused++;
+            r--;
+        }
+        else if (used[j])
+        {
+            __mp_treeremove(&tree, &nodes[j]);
+            used[j] = 0;
+            nused--;
+        }
+        checkorder(i);
+        checksearch(randomkey(), i);
+    }
+    for (j = 0; j < nnodes; j++)
+        if (used[j])
+            __mp_treeremove(&tree, &nodes[j]);
+    if ((tree.size != 0) || (__mp_minimum(tree.root) != NULL))
+        fail("tree not empty", o);
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned long o;
+
+    if (argc > 3)
+    {
+        fprintf(stderr, "Usage: %s [nodes [operations]]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    nnodes = (argc > 1) ? getnumber(argv[1]) : NODES;
+    o = (argc > 2) ? getnumber(argv[2]) : OPERATIONS;
+    if (nnodes == 0)
+        nnodes = 1;
+    nodes = (treenode *) getmemory(nnodes * sizeof(treenode));
+    used = (char *) getmemory(nnodes);
+    seed = 1;
+    __mp_newtree(&tree);
+    check(o);
+    seed = 1;
+    __mp_newbtree(&tree);
+    check(o);
+    fprintf(stdout, "%lu nodes %lu operations passed\n", nnodes, o);
+    free(nodes);
+    free(used);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Inserts a number of tree nodes with random keys into one of the trees
+ * that are used within the mpatrol library, searches the tree for the
+ * lowest node not less than each of a number of random keys, and then
+ * removes all of the tree nodes again in a different order.  The number of
+ * operations per second in each phase is then displayed on a single line,
+ * either for a red-black tree or for a B-tree.  The tree functions are
+ * called directly rather than through the mpatrol library.
+ */
+
+
+#include "tree.h"
+#include "harness.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* The default number of tree nodes.
+ */
+
+#define NODES 1000000
+
+
+static treeroot tree;
+static treenode *nodes;
+static unsigned long *order;
+static unsigned long nnodes, seed;
+
+
+/* Return a 32-bit pseudo-random number.  The system random number generator
+ * is not used since its range varies between systems, and this is a 32-bit
+ * xorshift generator so that the same keys are used on every system.
+ */
+
+static unsigned long randomnumber(void)
+{
+    seed ^= (seed << 13) & 0xFFFFFFFFUL;
+    seed ^= seed >> 17;
+    seed ^= (seed << 5) & 0xFFFFFFFFUL;
+    return seed;
+}
+
+
+/* The size of each block of memory that is supplied to the B-tree for its
+ * index pages.
+ */
+
+#define CHUNKSIZE 0x10000
+
+
+/* Insert a tree node into the tree, first supplying more memory for index
+ * pages if the tree is a B-tree that might not have enough of them, in the
+ * same way as the mpatrol library does.
+ */
+
+static void insert(treenode *n, unsigned long k)
+{
+    size_t l;
+
+    if ((l = __mp_treereserve(&tree, 1)) != 0)
+    {
+        if (l < CHUNKSIZE)
+            l = CHUNKSIZE;
+        __mp_treepages(&tree, getmemory(l), l);
+    }
+    __mp_treeinsert(&tree, n, k);
+}
+
+
+/* Display the number of operations per second for one phase.
+ */
+
+static void showrate(const char *s, unsigned long t)
+{
+    double r;
+
+    r = (t > 0) ? (double) nnodes * 1000000000.0 / (double) t : 0.0;
+    fprintf(stdout, "  %s %12.0f ops/sec", s, r);
+}
+
+
+int main(int argc, char **argv)
+{
+    char *s;
+    unsigned long i, j, k, t;
+    int b;
+
+    if ((argc < 2) || (argc > 4) ||
+        ((strcmp(argv[1], "rbtree") != 0) && (strcmp(argv[1], "btree") != 0)))
+    {
+        fprintf(stderr, "Usage: %s rbtree|btree [label [nodes]]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    b = (strcmp(argv[1], "btree") == 0);
+    s = (argc > 2) ? argv[2] : argv[1];
+    nnodes = (argc > 3) ? getnumber(argv[3]) : NODES;
+    nodes = (treenode *) getmemory(nnodes * sizeof(treenode));
+    order = (unsigned long *) getmemory(nnodes * sizeof(unsigned long));
+    seed = 1;
+    if (b)
+        __mp_newbtree(&tree);
+    else
+        __mp_newtree(&tree);
+    fprintf(stdout, "%-12s %10lu nodes", s, nnodes);
+    t = now();
+    for (i = 0; i < nnodes; i++)
+        insert(&nodes[i], randomnumber());
+    showrate("insert", now() - t);
+    t = now();
+    for (i = k = 0; i < nnodes; i++)
+        if (__mp_searchhigher(tree.root, randomnumber()) != NULL)
+            k++;
+    showrate("search", now() - t);
+    /* Remove the tree nodes in a random order that is chosen before the
+     * timing starts.
+     */
+    for (i = 0; i < nnodes; i++)
+        order[i] = i;
+    for (i = nnodes - 1; i > 0; i--)
+    {
+        j = randomnumber() % (i + 1);
+        k = order[i];
+        order[i] = order[j];
+        order[j] = k;
+    }
+    t = now();
+    for (i = 0; i < nnodes; i++)
+        __mp_treeremove(&tree, &nodes[order[i]]);
+    showrate("remove", now() - t);
+    fputc('\n', stdout);
+    free(nodes);
+    free(order);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+/*
+ * mpatrol
+ * A library for controlling and tracing dynamic memory allocations.
+ * Copyright (C) 1997-2008 Graeme S. Roy <graemeroy@users.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+/*
+ * Demonstrates and tests that free memory which has been returned to the
+ * system with __mp_trim() can be reused for small allocations.  The pages that
+ * were returned to the system read back as zero bytes rather than the free
+ * byte, so the parts of them that are still free must not be reported as
+ * corrupted by the check of the heap that follows.
+ */
+
+
+#include "mpatrol.h"
+#include <stdio.h>
+
+
+int main(void)
+{
+    void *p, *q, *r[16];
+    size_t i;
+
+    p = malloc(16);
+    q = malloc(262144);
+    /* This allocation will usually be made just after the large allocation
+     * so that the block of heap memory containing the large allocation cannot
+     * be returned to the system as a whole, and only the whole pages within
+     * the large allocation are returned instead.
+     */
+    r[0] = malloc(16);
+    free(q);
+    if (__mp_trim() == 0)
+        fputs("Expected free memory to be returned to the system\n", stderr);
+    for (i = 1; i < 16; i++)
+        r[i] = malloc(i * 100);
+    __mp_check();
+    for (i = 0; i < 16; i++)
+        free(r[i]);
+    free(p);
+    return EXIT_SUCCESS;
+}